@@ -0,0 +1,168 @@
+/**
+ * @file arena.hpp
+ * @author fyvoid (fyvo1d@outlook.com)
+ * @brief Bump allocator for compilation scoped objects
+ * @version 1.0
+ * @date 2024-12-22
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef BLANG_ARENA_H
+#define BLANG_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace blang {
+
+namespace tools {
+
+/**
+ * @brief Non-owning view of a contiguous array, usually living in an arena
+ *
+ * @tparam T
+ */
+template<typename T>
+class Span {
+private:
+    T* _data;
+    std::size_t _size;
+public:
+    Span() : _data(nullptr), _size(0) {}
+    Span(T* data, std::size_t size) : _data(data), _size(size) {}
+    T* begin() const { return _data; }
+    T* end() const { return _data + _size; }
+    T* data() const { return _data; }
+    std::size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    T& operator[](std::size_t index) const { return _data[index]; }
+    T& front() const { return _data[0]; }
+    T& back() const { return _data[_size - 1]; }
+};
+
+/**
+ * @brief Bump allocator, objects are never freed one by one
+ * Only trivially destructible objects may be allocated, so reset() releases
+ * everything by rewinding the bump pointer, no destructor ever runs.
+ * Chunks are kept across reset() and reused by the next compilation.
+ * Not thread safe, every compilation owns its own arena
+ *
+ */
+class Arena {
+private:
+    static constexpr std::size_t CHUNK_SIZE = 64 * 1024;
+    struct Chunk {
+        std::unique_ptr<char[]> data;
+        std::size_t size;
+    };
+    std::vector<Chunk> _chunks;
+    std::size_t _chunk;     // index of chunk in use
+    char* _cur;
+    char* _end;
+    std::size_t _allocated;
+    /**
+     * @brief Move on to the next chunk that fits, allocate one if none
+     *
+     * @param size
+     * @param align
+     * @return void*
+     */
+    void* grow(std::size_t size, std::size_t align);
+public:
+    Arena() : _chunks(), _chunk(0), _cur(nullptr), _end(nullptr), _allocated(0) {}
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    /**
+     * @brief Allocate raw memory
+     *
+     * @param size
+     * @param align
+     * @return void*
+     */
+    void* allocate(std::size_t size, std::size_t align) {
+        auto addr = reinterpret_cast<std::uintptr_t>(_cur);
+        auto aligned = (addr + align - 1) & ~static_cast<std::uintptr_t>(align - 1);
+        if (_cur && aligned + size <= reinterpret_cast<std::uintptr_t>(_end)) {
+            _cur = reinterpret_cast<char*>(aligned + size);
+            _allocated += size;
+            return reinterpret_cast<void*>(aligned);
+        }
+        return grow(size, align);
+    }
+    /**
+     * @brief Construct an object in arena
+     *
+     * @tparam T Must be trivially destructible
+     * @tparam Args
+     * @param args Constructor arguments
+     * @return T* Valid until reset()
+     */
+    template<typename T, typename... Args>
+    T* make(Args&&... args) {
+        static_assert(std::is_trivially_destructible_v<T>, "arena objects are never destructed");
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+    /**
+     * @brief Copy a vector into arena
+     *
+     * @tparam T
+     * @param vec
+     * @return Span<T>
+     */
+    template<typename T>
+    Span<T> span(const std::vector<T>& vec) {
+        static_assert(std::is_trivially_destructible_v<T>, "arena objects are never destructed");
+        if (vec.empty()) {
+            return Span<T>();
+        }
+        auto data = static_cast<T*>(allocate(sizeof(T) * vec.size(), alignof(T)));
+        std::uninitialized_copy(vec.begin(), vec.end(), data);
+        return Span<T>(data, vec.size());
+    }
+    /**
+     * @brief Copy a string into arena
+     *
+     * @param str
+     * @return std::string_view
+     */
+    std::string_view string(std::string_view str) {
+        if (str.empty()) {
+            return std::string_view();
+        }
+        auto data = static_cast<char*>(allocate(str.size(), 1));
+        std::memcpy(data, str.data(), str.size());
+        return std::string_view(data, str.size());
+    }
+    /**
+     * @brief Release every object at once, chunks are kept for reuse
+     *
+     */
+    void reset();
+    /**
+     * @brief Bytes handed out since last reset
+     *
+     * @return std::size_t
+     */
+    std::size_t allocated() { return _allocated; }
+    /**
+     * @brief Bytes of all chunks owned
+     *
+     * @return std::size_t
+     */
+    std::size_t capacity();
+};
+
+}
+
+}
+
+#endif
@@ -13,9 +13,12 @@
 #define BLANG_AST_H
 
 #include <cstdint>
-#include <memory>
-#include <vector>
+#include <optional>
+#include <string_view>
+#include <tuple>
 #include <variant>
+#include "arena.hpp"
+#include "ident.hpp"
 #include "type.hpp"
 
 namespace blang {
@@ -39,6 +42,8 @@ class Visitor;
 
 /**
  * @brief Abstract tree node base class
+ * Nodes are allocated from a compilation scoped tools::Arena and link to each other
+ * with non-owning pointers, they are released all at once with the arena
  * 
  */
 class AstNode {
@@ -68,8 +73,10 @@ public:
 class ExpNode : public AstNode {
 private:
     const Op _op;
+    bool _evaluated;
+    std::optional<int32_t> _value;
 protected:
-    ExpNode(uint32_t line, Op op) : AstNode(line), _op(op) {}
+    ExpNode(uint32_t line, Op op) : AstNode(line), _op(op), _evaluated(false), _value() {}
 public:
     /**
      * @brief Operator type of this exp
@@ -77,6 +84,23 @@ public:
      * @return Op 
      */
     Op op() { return _op; }
+    /**
+     * @brief Whether tools::Evaluator has memoized a value for this exp
+     * 
+     * @return true 
+     * @return false 
+     */
+    bool evaluated() { return _evaluated; }
+    /**
+     * @brief Memoized value, std::nullopt if exp is not constant
+     * 
+     * @return std::optional<int32_t> 
+     */
+    std::optional<int32_t> folded() { return _value; }
+    void setFolded(std::optional<int32_t> value) {
+        _evaluated = true;
+        _value = value;
+    }
 };
 
 /**
@@ -85,13 +109,13 @@ public:
  */
 class BinaryExpNode : public ExpNode {
 private:
-    std::shared_ptr<ExpNode> _left;
-    std::shared_ptr<ExpNode> _right;
+    ExpNode* _left;
+    ExpNode* _right;
 public:
-    BinaryExpNode(uint32_t line, Op op, std::shared_ptr<ExpNode> left, std::shared_ptr<ExpNode> right) :
+    BinaryExpNode(uint32_t line, Op op, ExpNode* left, ExpNode* right) :
         ExpNode(line, op), _left(left), _right(right) {}
-    std::shared_ptr<ExpNode> left() { return _left; }
-    std::shared_ptr<ExpNode> right() { return _right; }
+    ExpNode* left() { return _left; }
+    ExpNode* right() { return _right; }
     void accept(Visitor& visitor) override;
 };
 
@@ -106,10 +130,10 @@ class FuncRParamsNode;
  */
 class UnaryExpNode : public ExpNode {
 private:
-    std::shared_ptr<UnaryExpNode> _unary_exp;
-    std::shared_ptr<PrimaryExpNode> _primary_exp;
-    const std::string _ident;
-    std::shared_ptr<FuncRParamsNode> _func_rparams;
+    UnaryExpNode* _unary_exp;
+    PrimaryExpNode* _primary_exp;
+    const Ident _ident;
+    FuncRParamsNode* _func_rparams;
 public:
     /**
      * @brief Construct a new Unary Exp Node object
@@ -119,8 +143,8 @@ public:
      * @param op 
      * @param unary_exp 
      */
-    UnaryExpNode(uint32_t line, Op op, std::shared_ptr<UnaryExpNode> unary_exp) :
-        ExpNode(line, op), _unary_exp(unary_exp), _primary_exp(nullptr), _ident(""), _func_rparams(nullptr) {}
+    UnaryExpNode(uint32_t line, Op op, UnaryExpNode* unary_exp) :
+        ExpNode(line, op), _unary_exp(unary_exp), _primary_exp(nullptr), _ident(), _func_rparams(nullptr) {}
     /**
      * @brief Construct a new Unary Exp Node object
      * Node constructed with this method represents primary exp
@@ -128,8 +152,8 @@ public:
      * @param line 
      * @param primary_exp 
      */
-    UnaryExpNode(uint32_t line, std::shared_ptr<PrimaryExpNode> primary_exp) :
-        ExpNode(line, OP_EMPTY), _unary_exp(nullptr), _primary_exp(primary_exp), _ident(""), _func_rparams(nullptr) {}
+    UnaryExpNode(uint32_t line, PrimaryExpNode* primary_exp) :
+        ExpNode(line, OP_EMPTY), _unary_exp(nullptr), _primary_exp(primary_exp), _ident(), _func_rparams(nullptr) {}
     /**
      * @brief Construct a new Unary Exp Node object
      * Node constructed with this method represents ident(funcrparams)
@@ -138,12 +162,12 @@ public:
      * @param ident 
      * @param func_rparams 
      */
-    UnaryExpNode(uint32_t line, const std::string& ident, std::shared_ptr<FuncRParamsNode> func_rparams) :
+    UnaryExpNode(uint32_t line, Ident ident, FuncRParamsNode* func_rparams) :
         ExpNode(line, OP_EMPTY), _unary_exp(nullptr), _primary_exp(nullptr), _ident(ident), _func_rparams(func_rparams) {}
-    std::shared_ptr<UnaryExpNode> unary_exp() { return _unary_exp; }
-    std::shared_ptr<PrimaryExpNode> primary_exp() { return _primary_exp; }
-    const std::string& ident() { return _ident; }
-    std::shared_ptr<FuncRParamsNode> func_rparams() { return _func_rparams; }
+    UnaryExpNode* unary_exp() { return _unary_exp; }
+    PrimaryExpNode* primary_exp() { return _primary_exp; }
+    Ident ident() { return _ident; }
+    FuncRParamsNode* func_rparams() { return _func_rparams; }
     void accept(Visitor& visitor) override;
 };
 
@@ -163,11 +187,12 @@ enum InitType {
 class InitValNode : public AstNode {
 private:
     InitType _type;
-    std::vector<std::shared_ptr<ExpNode>> _exps;
-    std::string _str;
+    ExpNode* _exp;
+    tools::Span<ExpNode*> _exps;
+    std::string_view _str;
     const bool _is_const;
-    InitValNode(uint32_t line, InitType type, std::vector<std::shared_ptr<ExpNode>> vec, const std::string& str, bool is_const) :
-        AstNode(line), _type(type), _exps(vec), _str(str), _is_const(is_const) {}
+    InitValNode(uint32_t line, InitType type, ExpNode* exp, tools::Span<ExpNode*> vec, std::string_view str, bool is_const) :
+        AstNode(line), _type(type), _exp(exp), _exps(vec), _str(str), _is_const(is_const) {}
 public:
     /**
      * @brief Construct a new Init Val Node object
@@ -177,8 +202,8 @@ public:
      * @param exp 
      * @param is_const 
      */
-    InitValNode(uint32_t line, std::shared_ptr<ExpNode> exp, bool is_const) :
-        InitValNode(line, INIT_SINGLE, std::vector<std::shared_ptr<ExpNode>>{exp}, "", is_const) {}
+    InitValNode(uint32_t line, ExpNode* exp, bool is_const) :
+        InitValNode(line, INIT_SINGLE, exp, tools::Span<ExpNode*>(), "", is_const) {}
     /**
      * @brief Construct a new Init Val Node object
      * Represent init val with a initilizer list style init values
@@ -187,32 +212,33 @@ public:
      * @param exps 
      * @param is_const 
      */
-    InitValNode(uint32_t line, std::vector<std::shared_ptr<ExpNode>>& exps, bool is_const) :
-        InitValNode(line, INIT_ARRAY, exps, "", is_const) {}
+    InitValNode(uint32_t line, tools::Span<ExpNode*> exps, bool is_const) :
+        InitValNode(line, INIT_ARRAY, nullptr, exps, "", is_const) {}
     /**
      * @brief Construct a new Init Val Node object
      * Represent init val with a string
      *
      * @param line 
-     * @param str 
+     * @param str Must outlive the node, usually in the ast arena
      * @param is_const 
      */
-    InitValNode(uint32_t line, const std::string& str, bool is_const) :
-        InitValNode(line, INIT_STRING, std::vector<std::shared_ptr<ExpNode>>(), str, is_const) {}
+    InitValNode(uint32_t line, std::string_view str, bool is_const) :
+        InitValNode(line, INIT_STRING, nullptr, tools::Span<ExpNode*>(), str, is_const) {}
     void accept(Visitor& visitor) override;
     const InitType& type() { return _type; }
-    const std::string& str() { return _str; }
+    std::string_view str() { return _str; }
     bool is_const() { return _is_const; }
     /**
      * @brief Will only return exp if type is INIT_SINGLE, therefore can be used to determine node type
      * 
-     * @return std::shared_ptr<ExpNode> 
+     * @return ExpNode* 
      */
-    std::shared_ptr<ExpNode> exp() {
-        if (_type == INIT_SINGLE) return _exps[0];
-        return std::shared_ptr<ExpNode>();
+    ExpNode* exp() {
+        if (_type == INIT_SINGLE) return _exp;
+        return nullptr;
     }
-    std::vector<std::shared_ptr<ExpNode>> exps() {
+    tools::Span<ExpNode*> exps() {
+        if (_type == INIT_SINGLE) return tools::Span<ExpNode*>(&_exp, 1);
         return _exps;
     }
 };
@@ -224,19 +250,19 @@ public:
  */
 class DefNode : public AstNode {
 private:
-    const std::string _ident;
+    const Ident _ident;
     const bool _is_const;
-    std::shared_ptr<InitValNode> _init_val;
-    std::shared_ptr<ExpNode> _array_exp;
+    InitValNode* _init_val;
+    ExpNode* _array_exp;
 public:
-    DefNode(uint32_t line, const std::string& ident, std::shared_ptr<InitValNode> exp, bool is_const,
-        std::shared_ptr<ExpNode> array_exp=std::shared_ptr<ExpNode>()) :
+    DefNode(uint32_t line, Ident ident, InitValNode* exp, bool is_const,
+        ExpNode* array_exp=nullptr) :
         AstNode(line), _ident(ident), _init_val(exp), _array_exp(array_exp), _is_const(is_const) {}
     void accept(Visitor& visitor) override;
-    const std::string& ident() { return _ident; }
+    Ident ident() { return _ident; }
     bool is_const() { return _is_const; }
-    std::shared_ptr<InitValNode> init_val() { return _init_val; }
-    std::shared_ptr<ExpNode> array_exp() { return _array_exp; }
+    InitValNode* init_val() { return _init_val; }
+    ExpNode* array_exp() { return _array_exp; }
 };
 
 /**
@@ -248,14 +274,14 @@ class DeclNode : public AstNode {
 private:
     Type* const _type;
     const bool _is_const;
-    std::vector<std::shared_ptr<DefNode>> _nodes;
+    tools::Span<DefNode*> _nodes;
 public:
-    DeclNode(uint32_t line, Type* type, bool is_const, std::vector<std::shared_ptr<DefNode>> vec) :
+    DeclNode(uint32_t line, Type* type, bool is_const, tools::Span<DefNode*> vec) :
         AstNode(line), _type(type), _is_const(is_const), _nodes(vec) {}
     void accept(Visitor& visitor) override;
     Type* const type() { return _type; }
     bool is_const() { return _is_const; }
-    std::vector<std::shared_ptr<DefNode>>& defs() { return _nodes; }
+    tools::Span<DefNode*>& defs() { return _nodes; }
 };
 
 /**
@@ -264,11 +290,11 @@ public:
  */
 class FuncRParamsNode : public AstNode {
 private:
-    std::vector<std::shared_ptr<ExpNode>> _nodes;
+    tools::Span<ExpNode*> _nodes;
 public:
-    FuncRParamsNode(uint32_t line, std::vector<std::shared_ptr<ExpNode>> vec) :
+    FuncRParamsNode(uint32_t line, tools::Span<ExpNode*> vec) :
         AstNode(line), _nodes(vec) {}
-    std::vector<std::shared_ptr<ExpNode>> nodes() { return _nodes; }
+    tools::Span<ExpNode*> nodes() { return _nodes; }
     void accept(Visitor& visitor) override;
 };
 
@@ -312,14 +338,14 @@ enum RValType {
 class RValNode : public AstNode {
 private:
     const RValType _type;
-    std::shared_ptr<ExpNode> _exp;
+    ExpNode* _exp;
 public:
     RValNode(uint32_t line, RValType type) :
         AstNode(line), _type(type), _exp(nullptr) {}
-    RValNode(uint32_t line, std::shared_ptr<ExpNode> exp) :
+    RValNode(uint32_t line, ExpNode* exp) :
         AstNode(line), _type(RVAL_EXP), _exp(exp) {}
     RValType type() { return _type; }
-    std::shared_ptr<ExpNode> exp() { return _exp; }
+    ExpNode* exp() { return _exp; }
     void accept(Visitor& visitor) override;
 };
 
@@ -332,23 +358,23 @@ class LValNode;
  */
 class PrimaryExpNode : public AstNode {
 private:
-    std::shared_ptr<ExpNode> _exp;
-    std::shared_ptr<LValNode> _lval;
-    std::shared_ptr<ValueNode> _value;
+    ExpNode* _exp;
+    LValNode* _lval;
+    ValueNode* _value;
 public:
-    PrimaryExpNode(uint32_t line, std::shared_ptr<ExpNode> exp) :
+    PrimaryExpNode(uint32_t line, ExpNode* exp) :
         AstNode(line), _exp(exp), _lval(nullptr), _value(nullptr) {}
-    PrimaryExpNode(uint32_t line, std::shared_ptr<LValNode> lval) :
+    PrimaryExpNode(uint32_t line, LValNode* lval) :
         AstNode(line), _exp(nullptr), _lval(lval), _value(nullptr) {}
-    PrimaryExpNode(uint32_t line, std::shared_ptr<ValueNode> value) :
+    PrimaryExpNode(uint32_t line, ValueNode* value) :
         AstNode(line), _exp(nullptr), _lval(nullptr), _value(value) {}
-    std::shared_ptr<ExpNode> exp() {
+    ExpNode* exp() {
         return _exp;
     }
-    std::shared_ptr<LValNode> lval() {
+    LValNode* lval() {
         return _lval;
     }
-    std::shared_ptr<ValueNode> value() {
+    ValueNode* value() {
         return _value;
     }
     void accept(Visitor& visitor) override;
@@ -360,13 +386,13 @@ public:
  */
 class LValNode : public AstNode {
 private:
-    const std::string _ident;
-    std::shared_ptr<ExpNode> _exp;
+    const Ident _ident;
+    ExpNode* _exp;
 public:
-    LValNode(uint32_t line, const std::string& ident, std::shared_ptr<ExpNode> exp) :
+    LValNode(uint32_t line, Ident ident, ExpNode* exp) :
         AstNode(line), _ident(ident), _exp(exp) {}
-    const std::string& ident() { return _ident; }
-    std::shared_ptr<ExpNode> exp() { return _exp; }
+    Ident ident() { return _ident; }
+    ExpNode* exp() { return _exp; }
     void accept(Visitor& visitor) override;
 };
 
@@ -387,13 +413,13 @@ protected:
  */
 class AssignStmtNode : public StmtNode {
 private:
-    std::shared_ptr<LValNode> _lval;
-    std::shared_ptr<RValNode> _rval;
+    LValNode* _lval;
+    RValNode* _rval;
 public:
-    AssignStmtNode(uint32_t line, std::shared_ptr<LValNode> lval, std::shared_ptr<RValNode> rval) :
+    AssignStmtNode(uint32_t line, LValNode* lval, RValNode* rval) :
         StmtNode(line), _lval(lval), _rval(rval) {}
-    std::shared_ptr<LValNode> lval() { return _lval; }
-    std::shared_ptr<RValNode> rval() { return _rval; }
+    LValNode* lval() { return _lval; }
+    RValNode* rval() { return _rval; }
     void accept(Visitor& visitor) override;
 };
 
@@ -403,13 +429,13 @@ public:
  */
 class PrintfStmtNode : public StmtNode {
 private:
-    std::string _fmt;
-    std::vector<std::shared_ptr<ExpNode>> _exps;
+    std::string_view _fmt;
+    tools::Span<ExpNode*> _exps;
 public:
-    PrintfStmtNode(uint32_t line, const std::string& fmt, std::vector<std::shared_ptr<ExpNode>> exps=std::vector<std::shared_ptr<ExpNode>>()) : 
+    PrintfStmtNode(uint32_t line, std::string_view fmt, tools::Span<ExpNode*> exps=tools::Span<ExpNode*>()) : 
         StmtNode(line), _fmt(fmt), _exps(exps) {}
-    const std::string fmt() { return _fmt; }
-    std::vector<std::shared_ptr<ExpNode>> exps() { return _exps; }
+    std::string_view fmt() { return _fmt; }
+    tools::Span<ExpNode*> exps() { return _exps; }
     void accept(Visitor& visitor) override;
 };
 
@@ -419,11 +445,11 @@ public:
  */
 class ExpStmtNode : public StmtNode {
 private:
-    std::shared_ptr<ExpNode> _exp;
+    ExpNode* _exp;
 public:
-    ExpStmtNode(uint32_t line, std::shared_ptr<ExpNode> exp=nullptr) :
+    ExpStmtNode(uint32_t line, ExpNode* exp=nullptr) :
         StmtNode(line), _exp(exp) {}
-    std::shared_ptr<ExpNode> exp() { return _exp; }
+    ExpNode* exp() { return _exp; }
     void accept(Visitor& visitor) override;
 };
 
@@ -433,11 +459,11 @@ public:
  */
 class BlockStmtNode : public StmtNode {
 private:
-    std::shared_ptr<BlockNode> _block;
+    BlockNode* _block;
 public:
-    BlockStmtNode(uint32_t line, std::shared_ptr<BlockNode> block) :
+    BlockStmtNode(uint32_t line, BlockNode* block) :
         StmtNode(line), _block(block) {}
-    std::shared_ptr<BlockNode> block() { return _block; }
+    BlockNode* block() { return _block; }
     void accept(Visitor& visitor) override;
 };
 
@@ -447,15 +473,15 @@ public:
  */
 class IfStmtNode : public StmtNode {
 private:
-    std::shared_ptr<ExpNode> _cond;
-    std::shared_ptr<StmtNode> _if_stmt;
-    std::shared_ptr<StmtNode> _else_stmt;
+    ExpNode* _cond;
+    StmtNode* _if_stmt;
+    StmtNode* _else_stmt;
 public:
-    IfStmtNode(uint32_t line, std::shared_ptr<ExpNode> cond, std::shared_ptr<StmtNode> if_stmt, std::shared_ptr<StmtNode> else_stmt) :
+    IfStmtNode(uint32_t line, ExpNode* cond, StmtNode* if_stmt, StmtNode* else_stmt) :
         StmtNode(line), _cond(cond), _if_stmt(if_stmt), _else_stmt(else_stmt) {}
-    std::shared_ptr<ExpNode> cond() { return _cond; }
-    std::shared_ptr<StmtNode> if_stmt() { return _if_stmt; }
-    std::shared_ptr<StmtNode> else_stmt() { return _else_stmt; }
+    ExpNode* cond() { return _cond; }
+    StmtNode* if_stmt() { return _if_stmt; }
+    StmtNode* else_stmt() { return _else_stmt; }
     void accept(Visitor& visitor) override;
 };
 
@@ -466,17 +492,17 @@ public:
  */
 class ForStmtNode : public StmtNode {
 private:
-    std::shared_ptr<StmtNode> _for_in;
-    std::shared_ptr<ExpNode> _cond;
-    std::shared_ptr<StmtNode> _for_out;
-    std::shared_ptr<StmtNode> _stmt;
+    StmtNode* _for_in;
+    ExpNode* _cond;
+    StmtNode* _for_out;
+    StmtNode* _stmt;
 public:
-    ForStmtNode(uint32_t line, std::shared_ptr<StmtNode> for_in, std::shared_ptr<ExpNode> cond, std::shared_ptr<StmtNode> for_out, std::shared_ptr<StmtNode> stmt) :
+    ForStmtNode(uint32_t line, StmtNode* for_in, ExpNode* cond, StmtNode* for_out, StmtNode* stmt) :
         StmtNode(line), _for_in(for_in), _cond(cond), _for_out(for_out), _stmt(stmt) {}
-    std::shared_ptr<StmtNode> for_in() { return _for_in; }
-    std::shared_ptr<ExpNode> cond() { return _cond; }
-    std::shared_ptr<StmtNode> for_out() { return _for_out; }
-    std::shared_ptr<StmtNode> stmt() { return _stmt; }
+    StmtNode* for_in() { return _for_in; }
+    ExpNode* cond() { return _cond; }
+    StmtNode* for_out() { return _for_out; }
+    StmtNode* stmt() { return _stmt; }
     void accept(Visitor& visitor) override;
 };
 
@@ -509,11 +535,11 @@ public:
  */
 class ReturnStmtNode : public StmtNode {
 private:
-    std::shared_ptr<ExpNode> _exp;
+    ExpNode* _exp;
 public:
-    ReturnStmtNode(uint32_t line, std::shared_ptr<ExpNode> exp=nullptr) :
+    ReturnStmtNode(uint32_t line, ExpNode* exp=nullptr) :
         StmtNode(line), _exp(exp) {}
-    std::shared_ptr<ExpNode> exp() { return _exp; }
+    ExpNode* exp() { return _exp; }
     void accept(Visitor& visitor) override;
 };
 
@@ -523,18 +549,18 @@ public:
  */
 class BlockItemNode: public AstNode {
 private:
-    std::shared_ptr<AstNode> _item;
+    AstNode* _item;
 public:
-    BlockItemNode(uint32_t line, std::shared_ptr<DeclNode> decl) :
+    BlockItemNode(uint32_t line, DeclNode* decl) :
         AstNode(line), _item(decl) {}
-    BlockItemNode(uint32_t line, std::shared_ptr<StmtNode> stmt) : 
+    BlockItemNode(uint32_t line, StmtNode* stmt) : 
         AstNode(line), _item(stmt) {}
     void accept(Visitor& visitor) override;
-    std::shared_ptr<DeclNode> decl() {
-        return std::dynamic_pointer_cast<DeclNode>(_item);
+    DeclNode* decl() {
+        return dynamic_cast<DeclNode*>(_item);
     }
-    std::shared_ptr<StmtNode> stmt() {
-        return std::dynamic_pointer_cast<StmtNode>(_item);
+    StmtNode* stmt() {
+        return dynamic_cast<StmtNode*>(_item);
     }
 };
 
@@ -544,12 +570,12 @@ public:
  */
 class BlockNode : public AstNode {
 private:
-    std::vector<std::shared_ptr<BlockItemNode>> _items;
+    tools::Span<BlockItemNode*> _items;
 public:
-    BlockNode(uint32_t line, std::vector<std::shared_ptr<BlockItemNode>> vec) :
+    BlockNode(uint32_t line, tools::Span<BlockItemNode*> vec) :
         AstNode(line), _items(vec) {}
     void accept(Visitor& visitor) override;
-    std::vector<std::shared_ptr<BlockItemNode>> items() { return _items; }
+    tools::Span<BlockItemNode*> items() { return _items; }
 };
 
 /**
@@ -558,13 +584,13 @@ public:
  */
 class FuncFParamsNode : public AstNode {
 private:
-    std::vector<std::tuple<Type*, std::string>> _params;
+    tools::Span<std::tuple<Type*, Ident>> _params;
 public:
-    FuncFParamsNode(uint32_t line, std::vector<std::tuple<Type*, std::string>> vec
-        = std::vector<std::tuple<Type*, std::string>>()) : 
+    FuncFParamsNode(uint32_t line, tools::Span<std::tuple<Type*, Ident>> vec
+        = tools::Span<std::tuple<Type*, Ident>>()) : 
         AstNode(line), _params(vec) {}
     void accept(Visitor& visitor) override;
-    std::vector<std::tuple<Type*, std::string>>& params() { return _params; }
+    tools::Span<std::tuple<Type*, Ident>>& params() { return _params; }
 };
 
 /**
@@ -575,18 +601,18 @@ public:
 class FuncDefNode : public AstNode {
 private:
     Type* const _type;
-    const std::string _ident;
-    std::shared_ptr<FuncFParamsNode> _params;
-    std::shared_ptr<BlockNode> _block;
+    const Ident _ident;
+    FuncFParamsNode* _params;
+    BlockNode* _block;
 public:
-    FuncDefNode(uint32_t line, Type* type, const std::string& ident, std::shared_ptr<BlockNode> block,
-        std::shared_ptr<FuncFParamsNode> params=nullptr) :
+    FuncDefNode(uint32_t line, Type* type, Ident ident, BlockNode* block,
+        FuncFParamsNode* params=nullptr) :
         AstNode(line), _type(type), _ident(ident), _params(params), _block(block) {}
     void accept(Visitor& visitor) override;
     Type* type() { return _type; }
-    const std::string& ident() { return _ident; }
-    std::shared_ptr<FuncFParamsNode> params() { return _params; }
-    std::shared_ptr<BlockNode> block() { return _block; }
+    Ident ident() { return _ident; }
+    FuncFParamsNode* params() { return _params; }
+    BlockNode* block() { return _block; }
 };
 
 /**
@@ -595,11 +621,11 @@ public:
  */
 class MainNode : public AstNode {
 private:
-    std::shared_ptr<BlockNode> _block;
+    BlockNode* _block;
 public:
-    MainNode(uint32_t line, std::shared_ptr<BlockNode> block) :
+    MainNode(uint32_t line, BlockNode* block) :
         AstNode(line), _block(block) {}
-    std::shared_ptr<BlockNode> block() { return _block; }
+    BlockNode* block() { return _block; }
     void accept(Visitor& visitor) override;
 };
 
@@ -609,25 +635,25 @@ public:
  */
 class CompNode : public AstNode {
 private:
-    std::shared_ptr<CompNode> _comp;
-    std::shared_ptr<AstNode> _unit;
+    CompNode* _comp;
+    AstNode* _unit;
 public:
-    CompNode(uint32_t line, std::shared_ptr<DeclNode> decl, std::shared_ptr<CompNode> comp=nullptr) :
+    CompNode(uint32_t line, DeclNode* decl, CompNode* comp=nullptr) :
         AstNode(line), _comp(comp), _unit(decl) {}
-    CompNode(uint32_t line, std::shared_ptr<FuncDefNode> func_def, std::shared_ptr<CompNode> comp=nullptr) :
+    CompNode(uint32_t line, FuncDefNode* func_def, CompNode* comp=nullptr) :
         AstNode(line), _comp(comp), _unit(func_def) {}
-    CompNode(uint32_t line, std::shared_ptr<MainNode> main_func_def, std::shared_ptr<CompNode> comp=nullptr) :
+    CompNode(uint32_t line, MainNode* main_func_def, CompNode* comp=nullptr) :
         AstNode(line), _comp(comp), _unit(main_func_def) {}
     void accept(Visitor& visitor) override;
-    std::shared_ptr<CompNode> comp() { return _comp; }
-    std::shared_ptr<DeclNode> decl() { 
-        return std::dynamic_pointer_cast<DeclNode>(_unit); 
+    CompNode* comp() { return _comp; }
+    DeclNode* decl() { 
+        return dynamic_cast<DeclNode*>(_unit); 
     };
-    std::shared_ptr<FuncDefNode> func_def() {
-        return std::dynamic_pointer_cast<FuncDefNode>(_unit);
+    FuncDefNode* func_def() {
+        return dynamic_cast<FuncDefNode*>(_unit);
     }
-    std::shared_ptr<MainNode> main_func_def() {
-        return std::dynamic_pointer_cast<MainNode>(_unit);
+    MainNode* main_func_def() {
+        return dynamic_cast<MainNode*>(_unit);
     }
 };
 
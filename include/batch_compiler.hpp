@@ -0,0 +1,87 @@
+/**
+ * @file batch_compiler.hpp
+ * @author fyvoid (fyvo1d@outlook.com)
+ * @brief Batch compilation driver, compile many files in parallel
+ * @version 1.0
+ * @date 2024-12-20
+ * 
+ * @copyright Copyright (c) 2024
+ * 
+ */
+
+#ifndef BLANG_BATCH_COMPILER_H
+#define BLANG_BATCH_COMPILER_H
+
+#include "blang.hpp"
+#include "thread_pool.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace blang {
+
+/**
+ * @brief A single compile job of a batch
+ * 
+ */
+struct BatchJob {
+    std::string input;
+    std::string output;
+    /**
+     * @brief Set after the batch finished
+     * 
+     */
+    bool success = false;
+    /**
+     * @brief Error message if compilation failed
+     * 
+     */
+    std::string message = "";
+};
+
+/**
+ * @brief Batch compilation driver
+ * Jobs are scheduled on a work stealing thread pool,
+ * every worker owns one Blang pipeline and reuses it for all of its jobs
+ * 
+ */
+class BatchCompiler {
+private:
+    tools::ThreadPool _pool;
+    std::vector<std::unique_ptr<Blang>> _compilers;
+public:
+    /**
+     * @brief Construct a new Batch Compiler
+     * 
+     * @param workers Worker count, 0 for hardware concurrency
+     * @param load_mode How source files are loaded
+     * @param error_fd Stream errors of every job to this fd, -1 to disable
+     */
+    explicit BatchCompiler(std::size_t workers=0, tools::LoadMode load_mode=tools::LOAD_MMAP, int error_fd=-1);
+    /**
+     * @brief Compile all jobs, results are written back to jobs
+     * 
+     * @param jobs 
+     * @return std::size_t Count of failed jobs
+     */
+    std::size_t compile(std::vector<BatchJob>& jobs);
+    /**
+     * @brief Select optimization passes of every worker, see Optimizer::setPipeline
+     * 
+     * @param pipeline 
+     */
+    void setPasses(const std::string& pipeline);
+    /**
+     * @brief Removal counts of each optimization pass, summed over workers
+     * 
+     * @return std::vector<std::pair<std::string, backend::PassStats>> 
+     */
+    std::vector<std::pair<std::string, backend::PassStats>> passStats() const;
+};
+
+}
+
+#endif
@@ -12,14 +12,18 @@
 #ifndef BLANG_H
 #define BLANG_H
 
+#include "arena.hpp"
 #include "ir_generator.hpp"
 #include "lexer.hpp"
 #include "logger.hpp"
 #include "optimizer.hpp"
 #include "parser.hpp"
+#include "source.hpp"
 #include "syntax_checker.hpp"
+#include "type.hpp"
 
 #include <memory>
+#include <utility>
 #include <vector>
 
 namespace blang {
@@ -34,27 +38,47 @@ using namespace backend;
 class Blang {
 private:
     std::shared_ptr<Logger> _logger;
+    std::shared_ptr<entities::IdentTable> _idents;
+    std::shared_ptr<tools::Arena> _arena;
+    entities::TypeContext _types;
     Lexer _lexer;
     Parser _parser;
     SyntaxChecker _syntax_checker;
     IrGenerator _ir_generator;
     Optimizer _optimizer;
+    tools::LoadMode _load_mode;
+    std::size_t _function_workers;
+public:
     /**
-    * @brief Tool function, load source from a file
+    * @brief Construct a new Blang
     * 
-    * @param filename 
-    * @return std::shared_ptr<std::vector<char>> 
+    * @param load_mode How source files are loaded, mapped by default
+    * @param function_workers Threads optimizing and printing functions of a large module
     */
-    std::shared_ptr<std::vector<char>> load_file(const std::string& filename);
-public:
-    Blang();
+    Blang(tools::LoadMode load_mode=tools::LOAD_MMAP, std::size_t function_workers=1);
     /**
     * @brief Blang compile function
+    * Every call is an independent compilation, a Blang instance can be reused
+    * but must not be shared between threads
     * 
     * @param filename File to compile
+    * @param output File to write llvm ir to
     * @return std::shared_ptr<std::vector<char>> Compile result (assembly)
     */
-    std::shared_ptr<std::vector<char>> compile(const std::string& filename);
+    std::shared_ptr<std::vector<char>> compile(const std::string& filename, const std::string& output="./llvm_ir.txt");
+    std::shared_ptr<Logger> logger() { return _logger; }
+    /**
+    * @brief Select optimization passes, see Optimizer::setPipeline
+    * 
+    * @param pipeline 
+    */
+    void setPasses(const std::string& pipeline) { _optimizer.setPipeline(pipeline); }
+    /**
+    * @brief Removal counts of each optimization pass over every compilation so far
+    * 
+    * @return std::vector<std::pair<std::string, backend::PassStats>> 
+    */
+    std::vector<std::pair<std::string, backend::PassStats>> passStats() const { return _optimizer.stats(); }
 };
 
 }
@@ -0,0 +1,85 @@
+/**
+ * @file dominator_tree.hpp
+ * @author fyvoid (fyvo1d@outlook.com)
+ * @brief Dominator tree and dominance frontiers of a function
+ * @version 1.0
+ * @date 2024-12-30
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef BLANG_DOMINATOR_TREE_H
+#define BLANG_DOMINATOR_TREE_H
+
+#include "ir.hpp"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace blang {
+namespace backend {
+
+using namespace blang::entities;
+
+/**
+ * @brief Dominator tree of the blocks reachable from the entry block
+ * Built with the iterative algorithm of Cooper, Harvey and Kennedy over
+ * reverse post order, using the succ/pred lists of blocks. Unreachable blocks
+ * are left out, reachable() tells them apart. Invalidated by any cfg change
+ *
+ */
+class DominatorTree {
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+    std::vector<Block*> _order;
+    std::unordered_map<Block*, uint32_t> _index;
+    std::vector<uint32_t> _idom;
+    std::vector<std::vector<Block*>> _children;
+    std::vector<std::vector<Block*>> _frontier;
+    uint32_t index(Block* block) const;
+public:
+    explicit DominatorTree(Function& function);
+    /**
+     * @brief Reachable blocks in reverse post order, entry first
+     *
+     * @return const std::vector<Block*>&
+     */
+    const std::vector<Block*>& order() const { return _order; }
+    bool reachable(Block* block) const { return _index.count(block) > 0; }
+    /**
+     * @brief Immediate dominator
+     *
+     * @param block
+     * @return Block* nullptr for the entry block
+     */
+    Block* idom(Block* block) const;
+    /**
+     * @brief Blocks immediately dominated by block
+     *
+     * @param block
+     * @return const std::vector<Block*>&
+     */
+    const std::vector<Block*>& children(Block* block) const { return _children[index(block)]; }
+    /**
+     * @brief Dominance frontier, blocks where dominance of block ends
+     *
+     * @param block
+     * @return const std::vector<Block*>&
+     */
+    const std::vector<Block*>& frontier(Block* block) const { return _frontier[index(block)]; }
+    /**
+     * @brief Whether every path from entry to b goes through a, a block dominates itself
+     *
+     * @param a
+     * @param b
+     * @return true
+     * @return false
+     */
+    bool dominates(Block* a, Block* b) const;
+};
+
+}
+}
+
+#endif
@@ -18,7 +18,7 @@
 #include "visitor.hpp"
 #include <cstdint>
 #include <memory>
-#include <stdexcept>
+#include <optional>
 
 namespace blang {
 
@@ -28,27 +28,36 @@ using namespace entities;
 
 /**
  * @brief A Visitor sub class, evaluate constant expression in ast
+ * Never throws, an expression that is not constant evaluates to std::nullopt.
+ * Result of every ExpNode is memoized in the node, so folding a tree and then
+ * each of its subtrees costs one walk
  * 
  */
 class Evaluator : public Visitor {
 private:
     std::shared_ptr<SymbolTable> _current_table;
-    int32_t _value;
+    std::optional<int32_t> _value;
     /**
-     * @brief Calculate binary exp according to op
+     * @brief Calculate binary exp according to op, wrapping like i32 in llvm ir
      * 
      * @param left 
      * @param right 
      * @param op 
-     * @return int32_t 
+     * @return std::optional<int32_t> std::nullopt on division by zero or overflow
      */
-    int32_t calBinary(int32_t left, int32_t right, Op op) {
+    std::optional<int32_t> calBinary(int32_t left, int32_t right, Op op) {
+        auto l = static_cast<uint32_t>(left);
+        auto r = static_cast<uint32_t>(right);
         switch (op) {
-            case OP_ADD:    return left +  right;
-            case OP_MINUS:  return left -  right;
-            case OP_MUL:    return left *  right;
-            case OP_DIV:    return left /  right;
-            case OP_MOD:    return left %  right;
+            case OP_ADD:    return static_cast<int32_t>(l + r);
+            case OP_MINUS:  return static_cast<int32_t>(l - r);
+            case OP_MUL:    return static_cast<int32_t>(l * r);
+            case OP_DIV:
+            case OP_MOD:
+                if (right == 0 || (left == INT32_MIN && right == -1)) {
+                    return std::nullopt;
+                }
+                return op == OP_DIV ? left / right : left % right;
             case OP_AND:    return left && right;
             case OP_OR:     return left || right;
             case OP_EQ:     return left == right;
@@ -58,28 +67,44 @@ private:
             case OP_LE:     return left <= right;
             case OP_LT:     return left <  right;
             default:
-                throw std::runtime_error("invalid op");
+                return std::nullopt;
         }
-
-        return 0;
+    }
+    /**
+     * @brief Evaluate a sub expression through memo
+     * 
+     * @param node 
+     * @return std::optional<int32_t> 
+     */
+    std::optional<int32_t> fold(ExpNode& node) {
+        if (node.evaluated()) {
+            return node.folded();
+        }
+        _value = std::nullopt;
+        node.accept(*this);
+        node.setFolded(_value);
+        return _value;
     }
     virtual void visit(BinaryExpNode& node) override {
-        node.left()->accept(*this);
-        auto left = _value;
-        node.right()->accept(*this);
-        auto right = _value;
-        _value = calBinary(left, right, node.op());
+        auto left = fold(*node.left());
+        auto right = fold(*node.right());
+        _value = left && right ? calBinary(*left, *right, node.op()) : std::nullopt;
     }
     virtual void visit(UnaryExpNode& node) override {
         if (node.primary_exp()) {
             node.primary_exp()->accept(*this);
         } else if (node.unary_exp()) {
-            node.unary_exp()->accept(*this);
-            _value = node.op() == OP_ADD ? _value 
-                    : node.op() == OP_MINUS ? -_value 
-                    : node.op() == OP_NOT ? !_value : 0;
-        } else if (!node.ident().empty()) {
-            throw std::runtime_error("cannot evaluate function call");
+            auto value = fold(*node.unary_exp());
+            if (!value) {
+                _value = std::nullopt;
+                return ;
+            }
+            _value = node.op() == OP_ADD ? *value
+                    : node.op() == OP_MINUS ? static_cast<int32_t>(0u - static_cast<uint32_t>(*value))
+                    : node.op() == OP_NOT ? !*value : 0;
+        } else {
+            // function call
+            _value = std::nullopt;
         }
     }
     virtual void visit(PrimaryExpNode& node) override {
@@ -88,7 +113,7 @@ private:
         } else if (node.lval()) {
             node.lval()->accept(*this);
         } else if (node.exp()) {
-            node.exp()->accept(*this);
+            _value = fold(*node.exp());
         }
     }
     virtual void visit(ValueNode& node) override {
@@ -100,23 +125,23 @@ private:
     }
     virtual void visit(LValNode& node) override {
         auto var = _current_table->getVar(node.ident());
-        if (!var) {
-            throw std::runtime_error("var not found");
-        }
-        if (!var->is_const()) {
-            throw std::runtime_error("cannot evaluate non const");
+        _value = std::nullopt;
+        if (!var || !var->is_const()) {
+            return ;
         }
         if (Type::is_same(var->type(), IntType::get())) {
-            _value = *var->get<int32_t>();
+            _value = var->at<int32_t>(0);
         } else if (Type::is_same(var->type(), CharType::get())) {
-            _value = static_cast<int32_t>(*var->get<char>());
-        } else if (auto array_t = dynamic_cast<ArrayType*>(var->type()); array_t) {
+            _value = static_cast<int32_t>(var->at<char>(0));
+        } else if (auto array_t = dynamic_cast<ArrayType*>(var->type()); array_t && node.exp()) {
             auto content_t = array_t->type();
-            auto index = evaluate(*node.exp(), _current_table);
-            if (Type::is_same(content_t, IntType::get())) {
-                _value = *(var->get<int32_t>() + index);
+            auto index = fold(*node.exp());
+            if (!index || *index < 0 || static_cast<uint32_t>(*index) >= array_t->length()) {
+                _value = std::nullopt;
+            } else if (Type::is_same(content_t, IntType::get())) {
+                _value = var->at<int32_t>(*index);
             } else if (Type::is_same(content_t, CharType::get())) {
-                _value = static_cast<char>(*(var->get<char>() + index));
+                _value = static_cast<int32_t>(var->at<char>(*index));
             }
         }
     }
@@ -124,17 +149,14 @@ public:
     Evaluator();
     /**
      * @brief Evaluate a constatnt expression in ast
-     * throw std::runtime_error if expression cannot be evaluated
      * 
      * @param node Exp to be evaluated
      * @param current_table Current symbol table
-     * @return int32_t 
+     * @return std::optional<int32_t> std::nullopt if expression is not constant
      */
-    int32_t evaluate(ExpNode& node, std::shared_ptr<SymbolTable> current_table) {
+    std::optional<int32_t> evaluate(ExpNode& node, const std::shared_ptr<SymbolTable>& current_table) {
         _current_table = current_table;
-        _value = 0;
-        node.accept(*this);
-        return _value;
+        return fold(node);
     }
 };
 
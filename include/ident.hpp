@@ -0,0 +1,115 @@
+/**
+ * @file ident.hpp
+ * @author fyvoid (fyvo1d@outlook.com)
+ * @brief Identifier interning support for blang
+ * @version 1.0
+ * @date 2024-12-20
+ * 
+ * @copyright Copyright (c) 2024
+ * 
+ */
+
+#ifndef BLANG_IDENT_H
+#define BLANG_IDENT_H
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace blang {
+
+namespace entities {
+
+/**
+ * @brief Interned identifier
+ * Identifiers of one compilation are compared by their dense id,
+ * the spelling is kept by the IdentTable that created it
+ * 
+ */
+class Ident {
+private:
+    uint32_t _id;
+    const std::string* _name;
+public:
+    /**
+     * @brief Empty ident, id 0
+     * 
+     */
+    Ident() : _id(0), _name(nullptr) {}
+    Ident(uint32_t id, const std::string* name) : _id(id), _name(name) {}
+    uint32_t id() const { return _id; }
+    /**
+     * @brief Spelling of this ident
+     * 
+     * @return const std::string& 
+     */
+    const std::string& str() const {
+        static const std::string empty{};
+        return _name ? *_name : empty;
+    }
+    bool empty() const { return _id == 0; }
+    bool operator==(const Ident& other) const { return _id == other._id; }
+    bool operator!=(const Ident& other) const { return _id != other._id; }
+};
+
+/**
+ * @brief Identifier interner, maps every spelling to a dense 32-bit id
+ * One table is shared by all stages of a compilation
+ * 
+ */
+class IdentTable {
+private:
+    /**
+     * @brief Spellings, deque keeps references stable
+     * 
+     */
+    std::deque<std::string> _names;
+    std::unordered_map<std::string_view, uint32_t> _ids;
+public:
+    IdentTable();
+    /**
+     * @brief Get ident of a spelling, assign a new id if not seen yet
+     * 
+     * @param name 
+     * @return Ident 
+     */
+    Ident intern(std::string_view name);
+    /**
+     * @brief Count of ids handed out, including empty ident
+     * 
+     * @return uint32_t 
+     */
+    uint32_t size() { return static_cast<uint32_t>(_names.size()); }
+    /**
+     * @brief Spelling of an id handed out by this table
+     * 
+     * @param id 
+     * @return const std::string& 
+     */
+    const std::string& str(uint32_t id) { return _names[id]; }
+    /**
+     * @brief Drop all idents, those handed out become invalid
+     * 
+     */
+    void clear();
+};
+
+}
+
+}
+
+namespace std {
+
+template<>
+struct hash<blang::entities::Ident> {
+    size_t operator()(const blang::entities::Ident& ident) const {
+        return std::hash<uint32_t>()(ident.id());
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,118 @@
+/**
+ * @file inst_visitor.hpp
+ * @author fyvoid (fyvo1d@outlook.com)
+ * @brief Visitor over llvm ir instructions, dispatched on opcode
+ * @version 1.0
+ * @date 2024-12-28
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef BLANG_INST_VISITOR_H
+#define BLANG_INST_VISITOR_H
+
+#include "ir.hpp"
+#include <stdexcept>
+
+namespace blang {
+
+namespace entities {
+
+/**
+ * @brief Instruction visitor, static dispatch on Instruct::typeId()
+ * SubClass overrides (hides) the visit functions it cares about, the rest fall
+ * through to their group, visitArith for binary arith and visitCast for casts,
+ * then to visitInstruct. No virtual call and no rtti per instruction
+ *
+ * @tparam SubClass The visitor itself, CRTP
+ * @tparam RetTy
+ */
+template<typename SubClass, typename RetTy = void>
+class InstVisitor {
+private:
+    SubClass& self() { return *static_cast<SubClass*>(this); }
+protected:
+    InstVisitor() {}
+public:
+    void visit(Function& function) {
+        for (auto& block : function.blocks()) {
+            self().visit(*block);
+        }
+    }
+    void visit(Block& block) {
+        for (auto& instruct : block.instructions()) {
+            self().visit(*instruct);
+        }
+    }
+    RetTy visit(Instruct& inst) {
+        switch (inst.typeId()) {
+            case INSTRUCT_DEF:              return self().visitDef(static_cast<DefInstruct&>(inst));
+            case INSTRUCT_GEP:              return self().visitGEP(static_cast<GEPInstruct&>(inst));
+            case INSTRUCT_ALLOCA:           return self().visitAlloca(static_cast<AllocaInstruct&>(inst));
+            case INSTRUCT_STORE:            return self().visitStore(static_cast<StoreInstruct&>(inst));
+            case INSTRUCT_LOAD:             return self().visitLoad(static_cast<LoadInstruct&>(inst));
+            case INSTRUCT_RET:              return self().visitRet(static_cast<RetInstruct&>(inst));
+            case INSTRUCT_CALL:             return self().visitCall(static_cast<CallInstruct&>(inst));
+            case INSTRUCT_CALL_EXTERNAL:    return self().visitCallExternal(static_cast<CallExternalInstruct&>(inst));
+            case INSTRUCT_BR:               return self().visitBr(static_cast<BrInstruct&>(inst));
+            case INSTRUCT_CONDBR:           return self().visitCondBr(static_cast<CondBrInstruct&>(inst));
+            case INSTRUCT_PHI:              return self().visitPhi(static_cast<PhiInstruct&>(inst));
+            case INSTRUCT_ADD:              return self().visitAdd(static_cast<AddInstruct&>(inst));
+            case INSTRUCT_SUB:              return self().visitSub(static_cast<SubInstruct&>(inst));
+            case INSTRUCT_MUL:              return self().visitMul(static_cast<MulInstruct&>(inst));
+            case INSTRUCT_DIV:              return self().visitDiv(static_cast<DivInstruct&>(inst));
+            case INSTRUCT_MOD:              return self().visitMod(static_cast<ModInstruct&>(inst));
+            case INSTRUCT_AND:              return self().visitAnd(static_cast<AndInstruct&>(inst));
+            case INSTRUCT_OR:               return self().visitOr(static_cast<OrInstruct&>(inst));
+            case INSTRUCT_EQ:               return self().visitEq(static_cast<EqInstruct&>(inst));
+            case INSTRUCT_NEQ:              return self().visitNeq(static_cast<NeqInstruct&>(inst));
+            case INSTRUCT_GE:               return self().visitGe(static_cast<GeInstruct&>(inst));
+            case INSTRUCT_GT:               return self().visitGt(static_cast<GtInstruct&>(inst));
+            case INSTRUCT_LE:               return self().visitLe(static_cast<LeInstruct&>(inst));
+            case INSTRUCT_LT:               return self().visitLt(static_cast<LtInstruct&>(inst));
+            case INSTRUCT_SEXT:             return self().visitSext(static_cast<SextInstruct&>(inst));
+            case INSTRUCT_ZEXT:             return self().visitZext(static_cast<ZextInstruct&>(inst));
+            case INSTRUCT_TRUNC:            return self().visitTrunc(static_cast<TruncInstruct&>(inst));
+        }
+        throw std::runtime_error("Unknown instruction type!");
+    }
+
+    RetTy visitDef(DefInstruct& inst)                   { return self().visitInstruct(inst); }
+    RetTy visitGEP(GEPInstruct& inst)                   { return self().visitInstruct(inst); }
+    RetTy visitAlloca(AllocaInstruct& inst)             { return self().visitInstruct(inst); }
+    RetTy visitStore(StoreInstruct& inst)               { return self().visitInstruct(inst); }
+    RetTy visitLoad(LoadInstruct& inst)                 { return self().visitInstruct(inst); }
+    RetTy visitRet(RetInstruct& inst)                   { return self().visitInstruct(inst); }
+    RetTy visitCall(CallInstruct& inst)                 { return self().visitInstruct(inst); }
+    RetTy visitCallExternal(CallExternalInstruct& inst) { return self().visitInstruct(inst); }
+    RetTy visitBr(BrInstruct& inst)                     { return self().visitInstruct(inst); }
+    RetTy visitCondBr(CondBrInstruct& inst)             { return self().visitInstruct(inst); }
+    RetTy visitPhi(PhiInstruct& inst)                   { return self().visitInstruct(inst); }
+    RetTy visitAdd(AddInstruct& inst)                   { return self().visitArith(inst); }
+    RetTy visitSub(SubInstruct& inst)                   { return self().visitArith(inst); }
+    RetTy visitMul(MulInstruct& inst)                   { return self().visitArith(inst); }
+    RetTy visitDiv(DivInstruct& inst)                   { return self().visitArith(inst); }
+    RetTy visitMod(ModInstruct& inst)                   { return self().visitArith(inst); }
+    RetTy visitAnd(AndInstruct& inst)                   { return self().visitArith(inst); }
+    RetTy visitOr(OrInstruct& inst)                     { return self().visitArith(inst); }
+    RetTy visitEq(EqInstruct& inst)                     { return self().visitArith(inst); }
+    RetTy visitNeq(NeqInstruct& inst)                   { return self().visitArith(inst); }
+    RetTy visitGe(GeInstruct& inst)                     { return self().visitArith(inst); }
+    RetTy visitGt(GtInstruct& inst)                     { return self().visitArith(inst); }
+    RetTy visitLe(LeInstruct& inst)                     { return self().visitArith(inst); }
+    RetTy visitLt(LtInstruct& inst)                     { return self().visitArith(inst); }
+    RetTy visitSext(SextInstruct& inst)                 { return self().visitCast(inst); }
+    RetTy visitZext(ZextInstruct& inst)                 { return self().visitCast(inst); }
+    RetTy visitTrunc(TruncInstruct& inst)               { return self().visitCast(inst); }
+
+    RetTy visitArith(ArithInstruct& inst)               { return self().visitInstruct(inst); }
+    RetTy visitCast(Instruct& inst)                     { return self().visitInstruct(inst); }
+    RetTy visitInstruct(Instruct& inst)                 { return RetTy(); }
+};
+
+}
+
+}
+
+#endif
@@ -12,8 +12,12 @@
 #ifndef BLANG_IR_H
 #define BLANG_IR_H
 
+#include "arena.hpp"
+#include "ir_writer.hpp"
 #include "type.hpp"
+#include <map>
 #include <memory>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <tuple>
@@ -22,18 +26,22 @@
 namespace blang {
 namespace entities {
 
+class Block;
+
 /**
- * @brief Instruction types enum
+ * @brief Instruction types enum, one per instruction class
+ * Binary arith instructions are kept in one range, from INSTRUCT_ADD to
+ * INSTRUCT_LT, so ArithInstruct::classof is a range check
  * 
  */
 enum InstructType {
     INSTRUCT_DEF, INSTRUCT_GEP, INSTRUCT_ALLOCA, 
-    INSTRUCT_ADD, INSTRUCT_SUB, INSTRUCT_MUL, INSTRUCT_DIV, INSTRUCT_MOD,
     INSTRUCT_STORE, INSTRUCT_LOAD,
-    INSTRUCT_RET, INSTRUCT_CALL,
+    INSTRUCT_RET, INSTRUCT_CALL, INSTRUCT_CALL_EXTERNAL,
+    INSTRUCT_BR, INSTRUCT_CONDBR, INSTRUCT_PHI,
+    INSTRUCT_ADD, INSTRUCT_SUB, INSTRUCT_MUL, INSTRUCT_DIV, INSTRUCT_MOD,
     INSTRUCT_AND, INSTRUCT_OR, INSTRUCT_EQ, INSTRUCT_NEQ,
     INSTRUCT_GE, INSTRUCT_GT, INSTRUCT_LE, INSTRUCT_LT,
-    INSTRUCT_ICMP, INSTRUCT_BR,
     INSTRUCT_SEXT, INSTRUCT_ZEXT, INSTRUCT_TRUNC, 
 };
 
@@ -44,9 +52,32 @@ enum InstructType {
 class Instruct {
 private:
     InstructType _type;
+    std::unique_ptr<Use[]> _spilled;
+    tools::Span<Use> _operands;
 protected:
-    Instruct(InstructType type) : _type(type) {}
+    /**
+     * @brief Construct with operand slots, filled by initOperand
+     * Fixed size instructions keep their slots inline and pass them here,
+     * pass nullptr to allocate slots when the count is only known at runtime
+     * 
+     * @param type 
+     * @param operands 
+     * @param num_operands 
+     */
+    Instruct(InstructType type, Use* operands, std::size_t num_operands) : 
+        _type(type), _spilled(operands || num_operands == 0 ? nullptr : new Use[num_operands]),
+        _operands(operands ? operands : _spilled.get(), num_operands) {}
+    void initOperand(std::size_t index, std::shared_ptr<Value> value) { _operands[index].init(this, value); }
+    /**
+     * @brief Drop operands from size on, only for instructions with a variable operand count
+     * 
+     * @param size 
+     */
+    void shrinkOperands(std::size_t size);
 public:
+    Instruct(const Instruct&) = delete;
+    Instruct& operator=(const Instruct&) = delete;
+    virtual ~Instruct() = default;
     /**
      * @brief Get InstructType of instruction
      * 
@@ -60,14 +91,83 @@ public:
      * @return std::shared_ptr<Value> 
      */
     virtual std::shared_ptr<Value> reg() = 0;
+    /**
+     * @brief Whether reg() is a local register defined by this instruction,
+     * rather than an operand like the pointer of a store
+     * 
+     * @return true 
+     * @return false 
+     */
+    bool defines();
+    /**
+     * @brief Operand slots, every non null one is in the use list of its value
+     * 
+     * @return tools::Span<Use> 
+     */
+    tools::Span<Use> operands() { return _operands; }
+    const std::shared_ptr<Value>& operand(std::size_t index) { return _operands[index].get(); }
+    void setOperand(std::size_t index, std::shared_ptr<Value> value) { _operands[index].set(value); }
+    /**
+     * @brief Clear every operand, removing this instruction from use lists
+     * Call before erasing an instruction that may still be referenced elsewhere
+     * 
+     */
+    void dropOperands();
+    /**
+     * @brief Print instruction in llvm ir representation, without '\n'
+     * 
+     * @param out 
+     */
+    virtual void write(tools::IrWriter& out) = 0;
     /**
      * @brief Convert Instruction to llvm ir representation, without '\n'
      * 
      * @return std::string 
      */
-    virtual std::string to_string() = 0;
+    std::string to_string() {
+        tools::IrWriter out;
+        write(out);
+        return out.take();
+    }
 };
 
+/**
+ * @brief Whether inst is a T, a compare of typeId() through T::classof
+ * 
+ * @tparam T Instruction class
+ * @param inst 
+ * @return true 
+ * @return false 
+ */
+template<typename T>
+bool isa(Instruct* inst) { return T::classof(inst); }
+template<typename T>
+bool isa(const std::shared_ptr<Instruct>& inst) { return T::classof(inst.get()); }
+
+/**
+ * @brief Downcast inst already known to be a T
+ * 
+ * @tparam T Instruction class
+ * @param inst 
+ * @return T* 
+ */
+template<typename T>
+T* cast(Instruct* inst) { return static_cast<T*>(inst); }
+template<typename T>
+T* cast(const std::shared_ptr<Instruct>& inst) { return static_cast<T*>(inst.get()); }
+
+/**
+ * @brief Downcast inst if it is a T
+ * 
+ * @tparam T Instruction class
+ * @param inst 
+ * @return T* nullptr if inst is not a T
+ */
+template<typename T>
+T* dyn_cast(Instruct* inst) { return isa<T>(inst) ? static_cast<T*>(inst) : nullptr; }
+template<typename T>
+T* dyn_cast(const std::shared_ptr<Instruct>& inst) { return dyn_cast<T>(inst.get()); }
+
 /**
  * @brief Global defination instruction
  * _var = global/constant _var.type _init
@@ -77,14 +177,20 @@ class DefInstruct : public Instruct {
 private:
     bool _is_const;
     std::shared_ptr<PtrValue> _var;
-    std::shared_ptr<Value> _init;
+    Use _slots[1];
 public:
+    static bool classof(Instruct* inst) { return inst->typeId() == INSTRUCT_DEF; }
     DefInstruct(bool is_const, std::shared_ptr<PtrValue> var, std::shared_ptr<Value> init) : 
-        Instruct(INSTRUCT_DEF), _is_const(is_const), _var(var), _init(init) {}
+        Instruct(INSTRUCT_DEF, _slots, 1), _is_const(is_const), _var(var) { initOperand(0, init); }
+    const std::shared_ptr<Value>& init() { return operand(0); }
+    bool is_const() { return _is_const; }
     virtual std::shared_ptr<Value> reg() { return _var; }
-    virtual std::string to_string() {
-        auto flag = _is_const ? "constant" : "global";
-        return _var->def() + " = " + flag + " " + _var->getType()->to_string() + " " + _init->ident(); 
+    virtual void write(tools::IrWriter& out) {
+        _var->writeIdent(out);
+        out << (_is_const ? " = constant " : " = global ");
+        _var->getType()->write(out);
+        out << ' ';
+        init()->writeIdent(out);
     }
 };
 
@@ -96,21 +202,36 @@ public:
 class GEPInstruct : public Instruct {
 private:
     std::shared_ptr<PtrValue> _result;
-    std::shared_ptr<PtrValue> _ptr;
-    std::shared_ptr<IntConstValue> _elem;
-    std::shared_ptr<IntConstValue> _offset;
+    Use _slots[3];
 public:
+    static bool classof(Instruct* inst) { return inst->typeId() == INSTRUCT_GEP; }
     GEPInstruct(std::shared_ptr<PtrValue> result, std::shared_ptr<PtrValue> ptr, std::shared_ptr<IntConstValue> elem, std::shared_ptr<IntConstValue> offset) :
-        Instruct(INSTRUCT_GEP), _result(result), _ptr(ptr), _elem(elem), _offset(offset) {}
+        Instruct(INSTRUCT_GEP, _slots, 3), _result(result) {
+        initOperand(0, ptr);
+        initOperand(1, elem);
+        initOperand(2, offset);
+    }
+    const std::shared_ptr<Value>& ptr() { return operand(0); }
+    /**
+     * @brief Leading index, nullptr when indexing a pointer parameter
+     * 
+     * @return const std::shared_ptr<Value>& 
+     */
+    const std::shared_ptr<Value>& elem() { return operand(1); }
+    const std::shared_ptr<Value>& offset() { return operand(2); }
     virtual std::shared_ptr<Value> reg() { return _result; }
-    virtual std::string to_string() {
-        auto ret = _result->ident() + " = getelementptr ";
-        ret += _ptr->getType()->to_string() + ", " + _ptr->to_string();
-        if (_elem) {
-            ret += ", " + _elem->to_string();
+    virtual void write(tools::IrWriter& out) {
+        _result->writeIdent(out);
+        out << " = getelementptr ";
+        ptr()->getType()->write(out);
+        out << ", ";
+        ptr()->write(out);
+        if (elem()) {
+            out << ", ";
+            elem()->write(out);
         }
-        ret += ", " + _offset->to_string();
-        return ret;
+        out << ", ";
+        offset()->write(out);
     }
 };
 
@@ -123,11 +244,14 @@ class AllocaInstruct : public Instruct {
 private:
     std::shared_ptr<PtrValue> _var;
 public:
+    static bool classof(Instruct* inst) { return inst->typeId() == INSTRUCT_ALLOCA; }
     AllocaInstruct(std::shared_ptr<PtrValue> var) :
-        Instruct(INSTRUCT_ALLOCA), _var(var) {}
+        Instruct(INSTRUCT_ALLOCA, nullptr, 0), _var(var) {}
     virtual std::shared_ptr<Value> reg() { return _var; }
-    virtual std::string to_string() {
-        return _var->ident() + " = alloca " + _var->getType()->to_string(); 
+    virtual void write(tools::IrWriter& out) {
+        _var->writeIdent(out);
+        out << " = alloca ";
+        _var->getType()->write(out);
     }
 };
 
@@ -138,14 +262,22 @@ public:
  */
 class StoreInstruct : public Instruct {
 private:
-    std::shared_ptr<Value> _from;
-    std::shared_ptr<PtrValue> _to;
+    Use _slots[2];
 public:
+    static bool classof(Instruct* inst) { return inst->typeId() == INSTRUCT_STORE; }
     StoreInstruct(std::shared_ptr<Value> from, std::shared_ptr<PtrValue> to) :
-        Instruct(INSTRUCT_STORE), _from(from), _to(to) {}
-    virtual std::shared_ptr<Value> reg() { return _to; }
-    virtual std::string to_string() {
-        return "store " + _from->getType()->to_string() + " " + _from->ident() + ", " + _to->to_string();
+        Instruct(INSTRUCT_STORE, _slots, 2) {
+        initOperand(0, from);
+        initOperand(1, to);
+    }
+    const std::shared_ptr<Value>& from() { return operand(0); }
+    const std::shared_ptr<Value>& to() { return operand(1); }
+    virtual std::shared_ptr<Value> reg() { return to(); }
+    virtual void write(tools::IrWriter& out) {
+        out << "store ";
+        from()->write(out);
+        out << ", ";
+        to()->write(out);
     }
 };
 
@@ -156,14 +288,20 @@ public:
  */
 class LoadInstruct : public Instruct {
 private:
-    std::shared_ptr<Value> _from;
     std::shared_ptr<Value> _to;
+    Use _slots[1];
 public:
+    static bool classof(Instruct* inst) { return inst->typeId() == INSTRUCT_LOAD; }
     LoadInstruct(std::shared_ptr<Value> from, std::shared_ptr<Value> to) :
-        Instruct(INSTRUCT_LOAD), _from(from), _to(to) {}
+        Instruct(INSTRUCT_LOAD, _slots, 1), _to(to) { initOperand(0, from); }
+    const std::shared_ptr<Value>& from() { return operand(0); }
     virtual std::shared_ptr<Value> reg() { return _to; }
-    virtual std::string to_string() {
-        return _to->ident() + " = load " + _to->getType()->to_string() + ", " + _from->to_string();
+    virtual void write(tools::IrWriter& out) {
+        _to->writeIdent(out);
+        out << " = load ";
+        _to->getType()->write(out);
+        out << ", ";
+        from()->write(out);
     }
 };
 
@@ -175,19 +313,20 @@ public:
  */
 class RetInstruct : public Instruct {
 private:
-    std::shared_ptr<Value> _ret_value;
+    Use _slots[1];
 public:
+    static bool classof(Instruct* inst) { return inst->typeId() == INSTRUCT_RET; }
     RetInstruct(std::shared_ptr<Value> ret_value) :
-        Instruct(INSTRUCT_RET), _ret_value(ret_value) {}
-    virtual std::shared_ptr<Value> reg() { return _ret_value; }
-    virtual std::string to_string() {
-        std::string ret = "ret";
-        if (_ret_value) {
-            ret += " " + _ret_value->to_string();
+        Instruct(INSTRUCT_RET, _slots, 1) { initOperand(0, ret_value); }
+    const std::shared_ptr<Value>& ret_value() { return operand(0); }
+    virtual std::shared_ptr<Value> reg() { return ret_value(); }
+    virtual void write(tools::IrWriter& out) {
+        out << "ret ";
+        if (ret_value()) {
+            ret_value()->write(out);
         } else {
-            ret += " void";
+            out << "void";
         }
-        return ret;
     }
 };
 
@@ -199,10 +338,29 @@ public:
 class ArithInstruct : public Instruct {
 protected:
     std::shared_ptr<Value> _reg;
-    std::shared_ptr<Value> _left;
-    std::shared_ptr<Value> _right;
+    Use _slots[2];
     ArithInstruct(InstructType type, std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) :
-        Instruct(type), _reg(reg), _left(left), _right(right) {}
+        Instruct(type, _slots, 2), _reg(reg) {
+        initOperand(0, left);
+        initOperand(1, right);
+    }
+    /**
+     * @brief Print _reg = op _left.type _left, _right
+     * 
+     * @param out 
+     * @param op 
+     */
+    void writeBinary(tools::IrWriter& out, std::string_view op) {
+        _reg->writeIdent(out);
+        out << " = " << op << ' ';
+        left()->write(out);
+        out << ", ";
+        right()->writeIdent(out);
+    }
+public:
+    static bool classof(Instruct* inst) { return inst->typeId() >= INSTRUCT_ADD && inst->typeId() <= INSTRUCT_LT; }
+    const std::shared_ptr<Value>& left() { return operand(0); }
+    const std::shared_ptr<Value>& right() { return operand(1); }
     virtual std::shared_ptr<Value> reg() { return _reg; }
 };
 
@@ -212,11 +370,10 @@ protected:
  */
 class AddInstruct : public ArithInstruct {
 public:
+    static bool classof(Instruct* inst) { return inst->typeId() == INSTRUCT_ADD; }
     AddInstruct(std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) :
         ArithInstruct(INSTRUCT_ADD, reg, left, right) {}
-    virtual std::string to_string() {
-        return _reg->ident() + " = add " + _left->getType()->to_string() + " " + _left->ident() + ", " + _right->ident();
-    }
+    virtual void write(tools::IrWriter& out) { writeBinary(out, "add"); }
 };
 
 /**
@@ -225,11 +382,10 @@ public:
  */
 class SubInstruct : public ArithInstruct {
 public:
+    static bool classof(Instruct* inst) { return inst->typeId() == INSTRUCT_SUB; }
     SubInstruct(std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) :
         ArithInstruct(INSTRUCT_SUB, reg, left, right) {}
-    virtual std::string to_string() {
-        return _reg->ident() + " = sub " + _left->getType()->to_string() + " " + _left->ident() + ", " + _right->ident();
-    }
+    virtual void write(tools::IrWriter& out) { writeBinary(out, "sub"); }
 };
 
 /**
@@ -238,11 +394,10 @@ public:
  */
 class MulInstruct : public ArithInstruct {
 public:
+    static bool classof(Instruct* inst) { return inst->typeId() == INSTRUCT_MUL; }
     MulInstruct(std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) :
         ArithInstruct(INSTRUCT_MUL, reg, left, right) {}
-    virtual std::string to_string() {
-        return _reg->ident() + " = mul " + _left->getType()->to_string() + " " + _left->ident() + ", " + _right->ident();
-    }
+    virtual void write(tools::IrWriter& out) { writeBinary(out, "mul"); }
 };
 
 /**
@@ -251,11 +406,10 @@ public:
  */
 class DivInstruct : public ArithInstruct {
 public:
+    static bool classof(Instruct* inst) { return inst->typeId() == INSTRUCT_DIV; }
     DivInstruct(std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) :
         ArithInstruct(INSTRUCT_DIV, reg, left, right) {}
-    virtual std::string to_string() {
-        return _reg->ident() + " = sdiv " + _left->getType()->to_string() + " " + _left->ident() + ", " + _right->ident();
-    }
+    virtual void write(tools::IrWriter& out) { writeBinary(out, "sdiv"); }
 };
 
 /**
@@ -264,11 +418,10 @@ public:
  */
 class ModInstruct : public ArithInstruct {
 public:
+    static bool classof(Instruct* inst) { return inst->typeId() == INSTRUCT_MOD; }
     ModInstruct(std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) :
         ArithInstruct(INSTRUCT_MOD, reg, left, right) {}
-    virtual std::string to_string() {
-        return _reg->ident() + " = srem " + _left->getType()->to_string() + " " + _left->ident() + ", " + _right->ident();
-    }
+    virtual void write(tools::IrWriter& out) { writeBinary(out, "srem"); }
 };
 
 /**
@@ -277,11 +430,10 @@ public:
  */
 class AndInstruct : public ArithInstruct {
 public:
+    static bool classof(Instruct* inst) { return inst->typeId() == INSTRUCT_AND; }
     AndInstruct(std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) :
         ArithInstruct(INSTRUCT_AND, reg, left, right) {}
-    virtual std::string to_string() {
-        return _reg->ident() + " = and " + _left->getType()->to_string() + " " + _left->ident() + ", " + _right->ident();
-    }
+    virtual void write(tools::IrWriter& out) { writeBinary(out, "and"); }
 };
 
 /**
@@ -290,11 +442,10 @@ public:
  */
 class OrInstruct : public ArithInstruct {
 public:
+    static bool classof(Instruct* inst) { return inst->typeId() == INSTRUCT_OR; }
     OrInstruct(std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) :
         ArithInstruct(INSTRUCT_OR, reg, left, right) {}
-    virtual std::string to_string() {
-        return _reg->ident() + " = or " + _left->getType()->to_string() + " " + _left->ident() + ", " + _right->ident();
-    }
+    virtual void write(tools::IrWriter& out) { writeBinary(out, "or"); }
 };
 
 /**
@@ -303,11 +454,10 @@ public:
  */
 class EqInstruct : public ArithInstruct {
 public:
+    static bool classof(Instruct* inst) { return inst->typeId() == INSTRUCT_EQ; }
     EqInstruct(std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) :
         ArithInstruct(INSTRUCT_EQ, reg, left, right) {}
-    virtual std::string to_string() {
-        return _reg->ident() + " = icmp eq " + _left->getType()->to_string() + " " + _left->ident() + ", " + _right->ident();
-    }
+    virtual void write(tools::IrWriter& out) { writeBinary(out, "icmp eq"); }
 };
 
 /**
@@ -316,11 +466,10 @@ public:
  */
 class NeqInstruct : public ArithInstruct {
 public:
+    static bool classof(Instruct* inst) { return inst->typeId() == INSTRUCT_NEQ; }
     NeqInstruct(std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) :
         ArithInstruct(INSTRUCT_NEQ, reg, left, right) {}
-    virtual std::string to_string() {
-        return _reg->ident() + " = icmp ne " + _left->getType()->to_string() + " " + _left->ident() + ", " + _right->ident();
-    }
+    virtual void write(tools::IrWriter& out) { writeBinary(out, "icmp ne"); }
 };
 
 /**
@@ -329,11 +478,10 @@ public:
  */
 class GeInstruct : public ArithInstruct {
 public:
+    static bool classof(Instruct* inst) { return inst->typeId() == INSTRUCT_GE; }
     GeInstruct(std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) :
         ArithInstruct(INSTRUCT_GE, reg, left, right) {}
-    virtual std::string to_string() {
-        return _reg->ident() + " = icmp sge " + _left->getType()->to_string() + " " + _left->ident() + ", " + _right->ident();
-    }
+    virtual void write(tools::IrWriter& out) { writeBinary(out, "icmp sge"); }
 };
 
 /**
@@ -342,11 +490,10 @@ public:
  */
 class GtInstruct : public ArithInstruct {
 public:
+    static bool classof(Instruct* inst) { return inst->typeId() == INSTRUCT_GT; }
     GtInstruct(std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) :
         ArithInstruct(INSTRUCT_GT, reg, left, right) {}
-    virtual std::string to_string() {
-        return _reg->ident() + " = icmp sgt " + _left->getType()->to_string() + " " + _left->ident() + ", " + _right->ident();
-    }
+    virtual void write(tools::IrWriter& out) { writeBinary(out, "icmp sgt"); }
 };
 
 /**
@@ -355,11 +502,10 @@ public:
  */
 class LeInstruct : public ArithInstruct {
 public:
+    static bool classof(Instruct* inst) { return inst->typeId() == INSTRUCT_LE; }
     LeInstruct(std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) :
         ArithInstruct(INSTRUCT_LE, reg, left, right) {}
-    virtual std::string to_string() {
-        return _reg->ident() + " = icmp sle " + _left->getType()->to_string() + " " + _left->ident() + ", " + _right->ident();
-    }
+    virtual void write(tools::IrWriter& out) { writeBinary(out, "icmp sle"); }
 };
 
 /**
@@ -368,50 +514,51 @@ public:
  */
 class LtInstruct : public ArithInstruct {
 public:
+    static bool classof(Instruct* inst) { return inst->typeId() == INSTRUCT_LT; }
     LtInstruct(std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) :
         ArithInstruct(INSTRUCT_LT, reg, left, right) {}
-    virtual std::string to_string() {
-        return _reg->ident() + " = icmp slt " + _left->getType()->to_string() + " " + _left->ident() + ", " + _right->ident();
-    }
+    virtual void write(tools::IrWriter& out) { writeBinary(out, "icmp slt"); }
 };
 
 /**
  * @brief Br instruction without conditions
- * br _label
+ * br _target
+ * Targets are blocks of the same function, their labels are read when printing
  * 
  */
 class BrInstruct : public Instruct {
 private:
-    std::string _label;
+    Block* _target;
 public:
-    BrInstruct(std::string label) : Instruct(INSTRUCT_BR), _label(label) {}
+    static bool classof(Instruct* inst) { return inst->typeId() == INSTRUCT_BR; }
+    BrInstruct(Block* target) : Instruct(INSTRUCT_BR, nullptr, 0), _target(target) {}
     virtual std::shared_ptr<Value> reg() { return nullptr; }
-    virtual std::string to_string() {
-        return "br label %" + _label;
-    }
-    std::string label() { return _label; }
+    virtual void write(tools::IrWriter& out);
+    Block* target() { return _target; }
+    void setTarget(Block* target) { _target = target; }
 };
 
 /**
  * @brief Br instruction with conditions
- * br i1 _cond, true_label, _false_label
+ * br i1 _cond, _true_block, _false_block
  * 
  */
 class CondBrInstruct : public Instruct {
 private:
-    std::shared_ptr<Value> _cond;
-    std::string _true_label;
-    std::string _false_label;
-public:
-    CondBrInstruct(std::shared_ptr<Value> cond, std::string true_label, std::string false_label) :
-        Instruct(INSTRUCT_BR), _cond(cond), _true_label(true_label), _false_label(false_label) {}
-    virtual std::shared_ptr<Value> reg() { return _cond; }
-    virtual std::string to_string() {
-        return "br i1 " + _cond->ident() + ", label %" + _true_label + ", label %" + _false_label;
-    }
-    std::shared_ptr<Value> cond() { return _cond; }
-    std::string true_label() { return _true_label; }
-    std::string false_label() { return _false_label; }
+    Block* _true_block;
+    Block* _false_block;
+    Use _slots[1];
+public:
+    static bool classof(Instruct* inst) { return inst->typeId() == INSTRUCT_CONDBR; }
+    CondBrInstruct(std::shared_ptr<Value> cond, Block* true_block, Block* false_block) :
+        Instruct(INSTRUCT_CONDBR, _slots, 1), _true_block(true_block), _false_block(false_block) { initOperand(0, cond); }
+    virtual std::shared_ptr<Value> reg() { return cond(); }
+    virtual void write(tools::IrWriter& out);
+    const std::shared_ptr<Value>& cond() { return operand(0); }
+    Block* true_block() { return _true_block; }
+    Block* false_block() { return _false_block; }
+    void setTrueBlock(Block* block) { _true_block = block; }
+    void setFalseBlock(Block* block) { _false_block = block; }
 };
 
 /**
@@ -422,13 +569,19 @@ public:
 class SextInstruct : public Instruct {
 private:
     std::shared_ptr<Value> _result;
-    std::shared_ptr<Value> _operand;
+    Use _slots[1];
 public:
+    static bool classof(Instruct* inst) { return inst->typeId() == INSTRUCT_SEXT; }
     SextInstruct(std::shared_ptr<Value> result, std::shared_ptr<Value> operand) :
-        Instruct(INSTRUCT_SEXT), _result(result), _operand(operand) {}
+        Instruct(INSTRUCT_SEXT, _slots, 1), _result(result) { initOperand(0, operand); }
+    const std::shared_ptr<Value>& source() { return operand(0); }
     virtual std::shared_ptr<Value> reg() { return _result; }
-    virtual std::string to_string() {
-        return _result->ident() + " = sext " + _operand->to_string() + " to " + _result->getType()->to_string();
+    virtual void write(tools::IrWriter& out) {
+        _result->writeIdent(out);
+        out << " = sext ";
+        source()->write(out);
+        out << " to ";
+        _result->getType()->write(out);
     }
 };
 
@@ -440,13 +593,19 @@ public:
 class ZextInstruct : public Instruct {
 private:
     std::shared_ptr<Value> _result;
-    std::shared_ptr<Value> _operand;
+    Use _slots[1];
 public:
+    static bool classof(Instruct* inst) { return inst->typeId() == INSTRUCT_ZEXT; }
     ZextInstruct(std::shared_ptr<Value> result, std::shared_ptr<Value> operand) :
-        Instruct(INSTRUCT_ZEXT), _result(result), _operand(operand) {}
+        Instruct(INSTRUCT_ZEXT, _slots, 1), _result(result) { initOperand(0, operand); }
+    const std::shared_ptr<Value>& source() { return operand(0); }
     virtual std::shared_ptr<Value> reg() { return _result; }
-    virtual std::string to_string() {
-        return _result->ident() + " = zext " + _operand->to_string() + " to " + _result->getType()->to_string();
+    virtual void write(tools::IrWriter& out) {
+        _result->writeIdent(out);
+        out << " = zext ";
+        source()->write(out);
+        out << " to ";
+        _result->getType()->write(out);
     }
 };
 
@@ -458,35 +617,84 @@ public:
 class TruncInstruct : public Instruct {
 private:
     std::shared_ptr<Value> _result;
-    std::shared_ptr<Value> _operand;
+    Use _slots[1];
 public:
+    static bool classof(Instruct* inst) { return inst->typeId() == INSTRUCT_TRUNC; }
     TruncInstruct(std::shared_ptr<Value> result, std::shared_ptr<Value> operand) :
-        Instruct(INSTRUCT_TRUNC), _result(result), _operand(operand) {}
+        Instruct(INSTRUCT_TRUNC, _slots, 1), _result(result) { initOperand(0, operand); }
+    const std::shared_ptr<Value>& source() { return operand(0); }
     virtual std::shared_ptr<Value> reg() { return _result; }
-    virtual std::string to_string() {
-        return _result->ident() + " = trunc " + _operand->to_string() + " to " + _result->getType()->to_string();
+    virtual void write(tools::IrWriter& out) {
+        _result->writeIdent(out);
+        out << " = trunc ";
+        source()->write(out);
+        out << " to ";
+        _result->getType()->write(out);
     }
 };
 
+/**
+ * @brief Phi instruction
+ * _result = phi _result.type [ value, block ], ...
+ * One incoming slot per predecessor edge of the block holding it, in the
+ * order of its preds() when the phi was created
+ * 
+ */
+class PhiInstruct : public Instruct {
+private:
+    std::shared_ptr<Value> _result;
+    std::vector<Block*> _blocks;
+public:
+    static bool classof(Instruct* inst) { return inst->typeId() == INSTRUCT_PHI; }
+    /**
+     * @brief Construct a phi with empty incoming values, fill them with setIncoming
+     * 
+     * @param result 
+     * @param blocks Incoming blocks
+     */
+    PhiInstruct(std::shared_ptr<Value> result, std::vector<Block*> blocks) :
+        Instruct(INSTRUCT_PHI, nullptr, blocks.size()), _result(result), _blocks(blocks) {
+        for (std::size_t i = 0; i < _blocks.size(); i++) {
+            initOperand(i, nullptr);
+        }
+    }
+    virtual std::shared_ptr<Value> reg() { return _result; }
+    virtual void write(tools::IrWriter& out);
+    std::size_t size() { return _blocks.size(); }
+    Block* block(std::size_t index) { return _blocks[index]; }
+    const std::shared_ptr<Value>& incoming(std::size_t index) { return operand(index); }
+    void setIncoming(std::size_t index, std::shared_ptr<Value> value) { setOperand(index, value); }
+    /**
+     * @brief Remove an incoming entry when its edge goes away, the last entry takes its place
+     * 
+     * @param index 
+     */
+    void removeIncoming(std::size_t index);
+};
+
 /**
  * @brief LLVM IR base block support for blang
+ * Successor and predecessor lists are kept in step with the branch ending
+ * the block, one entry per branch target, so a cond br to the same block twice
+ * is listed twice
  * 
  */
 class Block {
 private:
     std::string _label;
     std::vector<std::shared_ptr<Instruct>> _instructions;
-    std::vector<std::string> _next;
+    std::vector<Block*> _succs;
+    std::vector<Block*> _preds;
     bool _ended;
 public:
     /**
      * @brief Construct a new Block object with label
-     * Most of the time, use function.addBlock instead
+     * Most of the time, use function.newBlock instead
      * 
      * @param label base block label
      */
-    Block(std::string label) : _label(label), _instructions({}), _next({}), _ended(false) {}
-    std::string label() { return _label; }
+    Block(std::string label) : _label(label), _instructions({}), _succs({}), _preds({}), _ended(false) {}
+    const std::string& label() { return _label; }
     std::vector<std::shared_ptr<Instruct>>& instructions() { return _instructions; }
     /**
      * @brief Wrapper for _instruction.push_back
@@ -494,11 +702,15 @@ public:
      * always use this when generating ir
      * 
      * @param instruct 
+     * @return true instruction inserted
+     * @return false block is ended, instruction dropped
      */
-    void push_back(std::shared_ptr<Instruct> instruct) { 
-        if (!_ended) {
-            _instructions.push_back(instruct); 
+    bool push_back(std::shared_ptr<Instruct> instruct) { 
+        if (_ended) {
+            return false;
         }
+        _instructions.push_back(instruct); 
+        return true;
     }
     /**
      * @brief Last instruction in this basic block
@@ -511,8 +723,29 @@ public:
         }
         return *(_instructions.end() - 1); 
     }
+    void write(tools::IrWriter& out);
     std::string to_string();
-    std::vector<std::string>& next() { return _next; }
+    std::vector<Block*>& succs() { return _succs; }
+    std::vector<Block*>& preds() { return _preds; }
+    /**
+     * @brief Add edge this -> to
+     * 
+     * @param to 
+     */
+    void link(Block* to);
+    /**
+     * @brief Remove one edge this -> to
+     * 
+     * @param to 
+     */
+    void unlink(Block* to);
+    /**
+     * @brief Point every branch target from of the ending branch to to, edges updated
+     * 
+     * @param from 
+     * @param to 
+     */
+    void retarget(Block* from, Block* to);
     /**
      * @brief ended memeber reference in basic block, if ended is set, block.push_back will not insert new insts
      * Manually set at present
@@ -554,93 +787,102 @@ public:
      * @param block 
      */
     void setBlock(std::shared_ptr<Block> block) { _current_block = block; }
+    /**
+     * @brief Create a block of this function, not placed until addBlock,
+     * so it can be branched to before its code is generated
+     * 
+     * @param label 
+     * @return std::shared_ptr<Block> 
+     */
+    std::shared_ptr<Block> newBlock(std::string label) { return std::make_shared<Block>(label); }
+    /**
+     * @brief Place a block after the last one, and set it as current block
+     * 
+     * @param block 
+     */
+    void addBlock(std::shared_ptr<Block> block);
     /**
      * @brief Add a new block with label, and set it as current block
      * 
      * @param label 
      */
     void addBlock(std::string label="");
+    /**
+     * @brief Number registers defined in the function as %0, %1, ... in order of appearance
+     * Register idents handed out by next_reg() are only unique, instructions
+     * folded away or dropped leave holes that llvm does not accept
+     * 
+     */
+    void numberRegs();
+    /**
+     * @brief Print function, numbering its registers first
+     * 
+     * @param out 
+     */
+    void write(tools::IrWriter& out);
     std::string to_string();
     /**
-     * @brief Get next reg ident number of this function
+     * @brief Get next unique reg ident of this function, renumbered when printed
      * 
      * @return std::string 
      */
     std::string next_reg() { return std::to_string(_reg_iter++); }
 };
 
+/**
+ * @brief Print a call, shared by calls of module and external functions
+ * 
+ * @param out 
+ * @param result nullptr for void functions
+ * @param function 
+ * @param params 
+ */
+void writeCall(tools::IrWriter& out, const std::shared_ptr<Value>& result, std::string_view function, tools::Span<Use> params);
+
 /**
  * @brief Call instruction
- * _result = call (void) (_function(_params))
+ * _result = call (void) (_function(operands))
  * 
  */
 class CallInstruct : public Instruct {
 private:
     std::shared_ptr<Value> _result;
     std::shared_ptr<Function> _function;
-    std::vector<std::shared_ptr<Value>> _params;
 public:
+    static bool classof(Instruct* inst) { return inst->typeId() == INSTRUCT_CALL; }
     CallInstruct(std::shared_ptr<Value> result, std::shared_ptr<Function> function, std::vector<std::shared_ptr<Value>> params) :
-        Instruct(INSTRUCT_CALL), _result(result), _function(function), _params(params) {}
-    virtual std::shared_ptr<Value> reg() { return _result; }
-    virtual std::string to_string() {
-        std::string ret = "";
-        if (_result) {
-            ret += _result->ident() + " = ";
-            ret += "call " + _result->getType()->to_string() + " ";
-        } else {
-            ret += "call void ";
-        }
-        ret += "@" + _function->ident() + "(";
-        if (!_params.empty()) {
-            auto iter = _params.begin();
-            while (iter + 1 != _params.end()) {
-                ret += (*iter)->to_string() + ", ";
-                iter++;
-            }
-            if (iter != _params.end()) {
-                ret += (*iter)->to_string();
+        Instruct(INSTRUCT_CALL, nullptr, params.size()), _result(result), _function(function) {
+        for (std::size_t i = 0; i < params.size(); i++) {
+            initOperand(i, params[i]);
         }
-        }
-        ret += ")";
-        return ret;
+    }
+    virtual std::shared_ptr<Value> reg() { return _result; }
+    virtual void write(tools::IrWriter& out) {
+        writeCall(out, _result, _function->ident(), operands());
     }
 };
 
 /**
  * @brief Call instruction with external function
- * _result = call (void) (_function(_params))
+ * _result = call (void) (_function(operands))
  * 
  */
 class CallExternalInstruct : public Instruct {
 private:
     std::shared_ptr<Value> _result;
     std::string _function;
-    std::vector<std::shared_ptr<Value>> _params;
 public:
+    static bool classof(Instruct* inst) { return inst->typeId() == INSTRUCT_CALL_EXTERNAL; }
     CallExternalInstruct(std::shared_ptr<Value> result, std::string function, std::vector<std::shared_ptr<Value>> params) :
-        Instruct(INSTRUCT_CALL), _result(result), _function(function), _params(params) {}
-    virtual std::shared_ptr<Value> reg() { return _result; }
-    virtual std::string to_string() {
-        std::string ret = "";
-        if (_result) {
-            ret += _result->ident() + " = ";
-            ret += "call " + _result->getType()->to_string() + " ";
-        } else {
-            ret += "call void ";
+        Instruct(INSTRUCT_CALL_EXTERNAL, nullptr, params.size()), _result(result), _function(function) {
+        for (std::size_t i = 0; i < params.size(); i++) {
+            initOperand(i, params[i]);
         }
-        ret += "@" + _function + "(";
-        if (!_params.empty()) {
-            auto iter = _params.begin();
-            while (iter + 1 != _params.end()) {
-                ret += (*iter)->to_string() + ", ";
-                iter++;
-            }
-            ret += (*iter)->to_string();
-        }
-        ret += ")";
-        return ret;
-    }  
+    }
+    virtual std::shared_ptr<Value> reg() { return _result; }
+    virtual void write(tools::IrWriter& out) {
+        writeCall(out, _result, _function, operands());
+    }
 };
 
 /**
@@ -649,6 +891,11 @@ public:
  */
 class IrModule { 
 private:
+    /**
+     * @brief Modules with fewer instructions are printed on the calling thread only
+     * 
+     */
+    static constexpr std::size_t PARALLEL_WRITE_INSTRUCTS = 16 * 1024;
     std::vector<std::shared_ptr<Instruct>> _global;
     std::map<std::string, std::shared_ptr<Function>> _functions;
     std::shared_ptr<Function> _current_function;
@@ -679,19 +926,110 @@ public:
      * @param function 
      */
     void setFunction(std::shared_ptr<Function> function) { _current_function = function; }
+    /**
+     * @brief Print module, functions are printed into buffers of their own
+     * by up to workers threads and appended in order
+     * 
+     * @param out 
+     * @param workers 
+     */
+    void write(tools::IrWriter& out, std::size_t workers=1);
     std::string to_string();
 };
 
+/**
+ * @brief Integer value of a constant, sign extended like llvm does,
+ * so i1 true is -1
+ * 
+ * @param value 
+ * @return std::optional<int32_t> std::nullopt if value is not a constant
+ */
+std::optional<int32_t> constValue(const std::shared_ptr<Value>& value);
+/**
+ * @brief Constant of type, value wrapped to its width
+ * 
+ * @param type 
+ * @param value 
+ * @return std::shared_ptr<Value> 
+ */
+std::shared_ptr<Value> makeConst(Type* type, int32_t value);
+/**
+ * @brief Evaluate a binary instruction on constant operands read by constValue
+ * 
+ * @param type 
+ * @param result_t 
+ * @param left 
+ * @param right 
+ * @return std::optional<int32_t> Value to pass to makeConst, std::nullopt if the instruction traps
+ */
+std::optional<int32_t> foldConstants(InstructType type, Type* result_t, int32_t left, int32_t right);
+/**
+ * @brief Evaluate a sext, zext or trunc on a constant operand read by constValue
+ * 
+ * @param type 
+ * @param operand_t 
+ * @param value 
+ * @return int32_t Value to pass to makeConst
+ */
+int32_t foldConstantCast(InstructType type, Type* operand_t, int32_t value);
+
 /**
  * @brief Factory pattern class for add instructions to a llvm module
+ * Arith, compare and cast instructions are folded on the fly: when operands
+ * are constants, or an identity like x + 0, x * 1, x * 0 applies, no
+ * instruction is emitted. Always read result of the last add call with last()
  * 
  */
 class IrFactory {
 private:
     std::shared_ptr<IrModule> _module;
     uint64_t _block_iter;
+    std::shared_ptr<Value> _last;
+    /**
+     * @brief Push an instruction to current block and record its reg
+     * 
+     * @param instruct 
+     * @return true instruction inserted
+     * @return false current block is ended, instruction dropped
+     */
+    bool push(std::shared_ptr<Instruct> instruct);
+    /**
+     * @brief Fold a binary instruction
+     * 
+     * @param type 
+     * @param reg 
+     * @param left 
+     * @param right 
+     * @return std::shared_ptr<Value> Value replacing reg, nullptr if it cannot be folded
+     */
+    std::shared_ptr<Value> foldBinary(InstructType type, std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right);
+    /**
+     * @brief Fold a sext, zext or trunc instruction
+     * 
+     * @param type 
+     * @param result 
+     * @param operand 
+     * @return std::shared_ptr<Value> Value replacing result, nullptr if it cannot be folded
+     */
+    std::shared_ptr<Value> foldCast(InstructType type, std::shared_ptr<Value> result, std::shared_ptr<Value> operand);
+    template<typename T>
+    void addBinary(InstructType type, std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) {
+        if (auto folded = foldBinary(type, reg, left, right); folded) {
+            _last = folded;
+            return ;
+        }
+        push(std::make_shared<T>(reg, left, right));
+    }
+    template<typename T>
+    void addCast(InstructType type, std::shared_ptr<Value> result, std::shared_ptr<Value> operand) {
+        if (auto folded = foldCast(type, result, operand); folded) {
+            _last = folded;
+            return ;
+        }
+        push(std::make_shared<T>(result, operand));
+    }
 public:
-    IrFactory(std::shared_ptr<IrModule> module) : _module(module), _block_iter(0) {}
+    IrFactory(std::shared_ptr<IrModule> module) : _module(module), _block_iter(0), _last(nullptr) {}
     /**
      * @brief Get next reg number of current function
      * 
@@ -704,6 +1042,13 @@ public:
      * @return std::string 
      */
     inline std::string next_block() { return std::to_string(_block_iter++); }
+    /**
+     * @brief Value produced by the last add call, reg of the instruction
+     * or the constant it was folded to
+     * 
+     * @return std::shared_ptr<Value> 
+     */
+    std::shared_ptr<Value> last() { return _last; }
     void addFunction(Type* ret_type, std::string ident, std::vector<std::tuple<Type*, std::string>> params);
     void addDefInstruct(bool is_const, std::shared_ptr<PtrValue> var, std::shared_ptr<Value> init);
     void addAllocaInstruct(std::shared_ptr<PtrValue> var);
@@ -725,8 +1070,8 @@ public:
     void addRetInstruct(std::shared_ptr<Value> ret_value);
     void addCallInstruct(std::shared_ptr<Value> result, std::shared_ptr<Function> function, std::vector<std::shared_ptr<Value>> params);
     void addGepInstruct(std::shared_ptr<PtrValue> result, std::shared_ptr<PtrValue> ptr, std::shared_ptr<IntConstValue> elem, std::shared_ptr<IntConstValue> offset);
-    void addBrInstruct(std::string label);
-    void addCondBrInstruct(std::shared_ptr<Value> cond, std::string true_label, std::string false_label);
+    void addBrInstruct(const std::shared_ptr<Block>& target);
+    void addCondBrInstruct(std::shared_ptr<Value> cond, const std::shared_ptr<Block>& true_block, const std::shared_ptr<Block>& false_block);
     void addSextInstruct(std::shared_ptr<Value> result, std::shared_ptr<Value> operand);
     void addZextInstruct(std::shared_ptr<Value> result, std::shared_ptr<Value> operand);
     void addTruncInstruct(std::shared_ptr<Value> result, std::shared_ptr<Value> operand);
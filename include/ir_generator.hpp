@@ -12,6 +12,7 @@
 #ifndef BLANG_IR_GENERATOR_H
 #define BLANG_IR_GENERATOR_H
 
+#include "arena.hpp"
 #include "ast.hpp"
 #include "evaluator.hpp"
 #include "ir.hpp"
@@ -35,29 +36,35 @@ using namespace tools;
 class IrGenerator : public Visitor {
 private:
     std::shared_ptr<Logger> _logger;
-    std::shared_ptr<GlobalSymbolTable> _global_table;
-    std::shared_ptr<SymbolTable> _current_table;
+    std::shared_ptr<tools::Arena> _arena;
+    std::shared_ptr<SymbolTable> _table;
     std::shared_ptr<IrModule> _module;
     std::shared_ptr<IrFactory> _factory;
-    std::vector<std::string> _for_end_labels = {};
-    std::vector<std::string> _for_out_labels = {};
+    std::vector<std::shared_ptr<Block>> _for_end_blocks = {};
+    std::vector<std::shared_ptr<Block>> _for_out_blocks = {};
+    Evaluator _evaluator;
     /**
      * @brief Wrapper for exp evaluation
-     * Catched std::runtime_error, return -1 if error occured
+     * Return -1 if expression is not constant
      * Therefore should be used after validating expression
      * 
      * @param node 
      * @param current_table 
      * @return int32_t 
      */
-    static int32_t evaluate(ExpNode& node, std::shared_ptr<SymbolTable> current_table) {
-        static Evaluator evaluator{};
-        try {
-            return evaluator.evaluate(node, current_table);
-        } catch (std::runtime_error err) {
-            return -1;
-        }
+    int32_t evaluate(ExpNode& node, std::shared_ptr<SymbolTable> current_table) {
+        return _evaluator.evaluate(node, current_table).value_or(-1);
     }
+    /**
+     * @brief Load folded value of a constant exp to a temp register
+     * instead of generating its arithmetic
+     * 
+     * @param node 
+     * @param type Type of the exp, int or bool
+     * @return true exp is constant and has been generated
+     * @return false exp is not constant, nothing generated
+     */
+    bool genFolded(ExpNode& node, Type* type);
     /**
      * @brief Convert initval node to a vector containing initilize values
      * 
@@ -70,10 +77,10 @@ private:
         std::vector<T> ret{};
 
         if (node.type() == entities::INIT_SINGLE) {
-            ret.push_back(static_cast<T>(evaluate(*node.exp(), _current_table)));
+            ret.push_back(static_cast<T>(evaluate(*node.exp(), _table)));
         } else if (node.type() == entities::INIT_ARRAY) {
             for (auto exp : node.exps()) {
-                ret.push_back(static_cast<T>(evaluate(*exp, _current_table)));
+                ret.push_back(static_cast<T>(evaluate(*exp, _table)));
             }
         } else if (node.type() == entities::INIT_STRING) {
             for (auto ch : node.str()) {
@@ -112,14 +119,14 @@ private:
     void setFunction();
     void setMain();
 public:
-    IrGenerator(std::shared_ptr<Logger> logger);
+    IrGenerator(std::shared_ptr<Logger> logger, std::shared_ptr<tools::Arena> arena);
     /**
     * @brief Generate llvm ir module from global symbol table formed from syntax checker
     * 
     * @param checked_table 
     * @return std::shared_ptr<IrModule> 
     */
-    std::shared_ptr<IrModule> gen(std::shared_ptr<GlobalSymbolTable> checked_table);
+    std::shared_ptr<IrModule> gen(std::shared_ptr<SymbolTable> checked_table);
 };
 
 }
@@ -0,0 +1,95 @@
+/**
+ * @file ir_writer.hpp
+ * @author fyvoid (fyvo1d@outlook.com)
+ * @brief Buffered text output for llvm ir
+ * @version 1.0
+ * @date 2024-12-29
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef BLANG_IR_WRITER_H
+#define BLANG_IR_WRITER_H
+
+#include <charconv>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace blang {
+
+namespace tools {
+
+/**
+ * @brief Append only text buffer that ir is printed into
+ * Either collects text in memory, or owns an output file and writes the
+ * buffer out whenever it fills up, so a module is never held as a whole.
+ * Integers are formatted in place, appending never allocates once the
+ * buffer has grown
+ *
+ */
+class IrWriter {
+private:
+    static constexpr std::size_t FLUSH_SIZE = 64 * 1024;
+    std::string _buffer;
+    int _fd;
+public:
+    /**
+     * @brief Construct a writer collecting text in memory
+     *
+     */
+    IrWriter() : _buffer(), _fd(-1) {}
+    /**
+     * @brief Construct a writer to file, truncated if it exists
+     * Call flush() when done, the destructor only closes the file
+     *
+     * @param path
+     */
+    explicit IrWriter(const std::string& path);
+    ~IrWriter();
+    IrWriter(const IrWriter&) = delete;
+    IrWriter& operator=(const IrWriter&) = delete;
+    IrWriter& operator<<(std::string_view str) {
+        _buffer.append(str);
+        if (_fd >= 0 && _buffer.size() >= FLUSH_SIZE) {
+            flush();
+        }
+        return *this;
+    }
+    IrWriter& operator<<(char c) {
+        _buffer.push_back(c);
+        return *this;
+    }
+    template<typename T, typename = std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, char> && !std::is_same_v<T, bool>>>
+    IrWriter& operator<<(T value) {
+        char digits[24];
+        auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), value);
+        _buffer.append(digits, end);
+        return *this;
+    }
+    /**
+     * @brief Text not yet flushed, everything for a memory writer
+     *
+     * @return const std::string&
+     */
+    const std::string& str() { return _buffer; }
+    /**
+     * @brief Move text out of a memory writer
+     *
+     * @return std::string
+     */
+    std::string take() { return std::move(_buffer); }
+    /**
+     * @brief Write buffered text to file, nothing for a memory writer
+     *
+     */
+    void flush();
+};
+
+}
+
+}
+
+#endif
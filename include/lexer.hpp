@@ -14,8 +14,10 @@
 
 #include "token.hpp"
 #include "logger.hpp"
+#include "source.hpp"
 
 #include <memory>
+#include <string_view>
 #include <vector>
 
 namespace blang {
@@ -28,42 +30,56 @@ namespace frontend {
  */
 class Lexer {
 private:
-    uint32_t _pos = 0;
     uint32_t _line = 0;
-    std::shared_ptr<std::vector<char>> _buffer;
+    std::shared_ptr<tools::SourceBuffer> _source;
+    /**
+     * @brief Scan cursor, the buffer ends with a '\0' sentinel at _end
+     * so scanning loops stop on it without checking bounds
+     * 
+     */
+    const char* _cur = nullptr;
+    const char* _end = nullptr;
     std::shared_ptr<Logger> _logger;
+    std::shared_ptr<entities::IdentTable> _idents;
 
     inline bool atEnd() {
-        return _pos >= _buffer->size();
-    }
-    inline void step() {
-        _pos++;
-    }
-    inline char current() {
-        return atEnd() ? (*_buffer)[_buffer->size() - 1]
-            : (*_buffer)[_pos];
-    }
-    inline char peak() {
-        return atEnd() ? current() : (*_buffer)[_pos + 1];
+        return _cur >= _end;
     }
 
     Token lexToken();
 
-    std::string lexString();
-    std::string lexChar();
-    std::string lexNumber();
-    std::string lexIdent();
-    Token matchKeyword(const std::string& ident);
+    std::string_view lexString();
+    std::string_view lexChar();
+    std::string_view lexNumber();
+    std::string_view lexIdent();
+    /**
+     * @brief Skip a // comment, stops at the line break
+     * 
+     */
+    void skipLineComment();
+    /**
+     * @brief Skip a block comment, counting lines inside
+     * 
+     */
+    void skipBlockComment();
+    /**
+     * @brief Keyword lookup with a perfect hash
+     * 
+     * @param ident 
+     * @return TokenType keyword type, or IDENT
+     */
+    static TokenType matchKeyword(std::string_view ident);
 
 public:
-    Lexer(std::shared_ptr<Logger> logger);
+    Lexer(std::shared_ptr<Logger> logger, std::shared_ptr<entities::IdentTable> idents);
     /**
-    * @brief From input(char vector) lex token vector
+    * @brief From source buffer lex token vector
+    * Token values are views into source, no text is copied
     * 
-    * @param input_buffer 
+    * @param source 
     * @return std::shared_ptr<std::vector<Token>> 
     */
-    std::shared_ptr<std::vector<Token>> lexTokens(std::shared_ptr<std::vector<char>> input_buffer);
+    std::shared_ptr<std::vector<Token>> lexTokens(std::shared_ptr<tools::SourceBuffer> source);
 };
 
 }
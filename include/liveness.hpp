@@ -0,0 +1,56 @@
+/**
+ * @file liveness.hpp
+ * @author fyvoid (fyvo1d@outlook.com)
+ * @brief Live registers at block boundaries
+ * @version 1.0
+ * @date 2024-12-31
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef BLANG_LIVENESS_H
+#define BLANG_LIVENESS_H
+
+#include "ir.hpp"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace blang {
+namespace backend {
+
+using namespace blang::entities;
+
+/**
+ * @brief Registers defined in a function that are live on entry to and exit
+ * from each block, solved backwards to a fixed point over bit sets
+ * An incoming value of a phi is live out of the matching predecessor, not
+ * live into the block of the phi. Invalidated by any instruction change
+ *
+ */
+class Liveness {
+private:
+    std::unordered_map<Value*, uint32_t> _index;
+    std::unordered_map<Block*, uint32_t> _blocks;
+    std::size_t _words;
+    std::vector<std::vector<uint64_t>> _live_in;
+    std::vector<std::vector<uint64_t>> _live_out;
+    static bool test(const std::vector<uint64_t>& set, uint32_t bit) { return (set[bit / 64] >> (bit % 64)) & 1; }
+    bool lookup(const std::vector<std::vector<uint64_t>>& sets, Block* block, Value* value) const;
+public:
+    explicit Liveness(Function& function);
+    /**
+     * @brief Count of registers defined in the function
+     *
+     * @return std::size_t
+     */
+    std::size_t numValues() const { return _index.size(); }
+    bool liveIn(Block* block, Value* value) const { return lookup(_live_in, block, value); }
+    bool liveOut(Block* block, Value* value) const { return lookup(_live_out, block, value); }
+};
+
+}
+}
+
+#endif
@@ -12,13 +12,16 @@
 #ifndef BLANG_LOGGER_H
 #define BLANG_LOGGER_H
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "token.hpp"
 #include "buaa.hpp"
+#include "ident.hpp"
 
 namespace blang {
 
@@ -100,32 +103,106 @@ struct SyntaxLog : public Log {
     }
 };
 
+/**
+ * @brief Error held back by a stage before it is logged
+ * message is always a string literal
+ * 
+ */
+struct PendingError {
+    uint32_t line;
+    const char* message;
+    buaa::ErrorType error;
+};
+
 /**
  * @brief Logger support for blang
+ * Logs are kept column wise, one row per log, with messages interned.
+ * Log objects are only built when one of the getters is called, so
+ * a compilation that never reads its logs never allocates one
  * 
  */
 class Logger {
 private:
-    std::vector<std::shared_ptr<ErrorLog>> _errors;
-    std::vector<std::shared_ptr<Log>> _logs;
+    static constexpr std::size_t LOG_TYPE_COUNT = LOG_SYNTAX + 1;
+    std::vector<LogType> _types;
+    std::vector<uint32_t> _lines;
+    /**
+     * @brief Block number of syntax logs, 0 for others
+     * 
+     */
+    std::vector<uint32_t> _blockns;
+    std::vector<uint32_t> _messages;
+    /**
+     * @brief Error type of error logs, token type of lexer logs,
+     * interned type name of syntax logs
+     * 
+     */
+    std::vector<uint32_t> _details;
+    /**
+     * @brief Rows of each log type, in log order
+     * Error rows are reordered by sortError()
+     * 
+     */
+    std::vector<uint32_t> _index[LOG_TYPE_COUNT];
+    /**
+     * @brief Syntax rows ordered by block number, rebuilt only after new syntax logs
+     * 
+     */
+    std::vector<uint32_t> _syntax_order;
+    bool _syntax_sorted;
+    entities::IdentTable _strings;
+    int _sink;
+    uint32_t push(LogType type, uint32_t line, uint32_t blockn, std::string_view message, uint32_t detail);
+    const std::string& message(uint32_t row) { return _strings.str(_messages[row]); }
 public:
     Logger();
     /**
-     * @brief Get all error logs by reference
+     * @brief Build error logs, in order of sortError() if called
+     * 
+     * @return std::vector<std::shared_ptr<ErrorLog>> 
+     */
+    std::vector<std::shared_ptr<ErrorLog>> errors();
+    /**
+     * @brief Build all non error logs in log order
      * 
-     * @return std::vector<std::shared_ptr<ErrorLog>>& 
+     * @return std::vector<std::shared_ptr<Log>> 
      */
-    std::vector<std::shared_ptr<ErrorLog>>& errors() { return _errors; }
+    std::vector<std::shared_ptr<Log>> logs();
     /**
-     * @brief Get all logs by reference
+     * @brief Build syntax logs, stable sorted by block number
      * 
-     * @return std::vector<std::shared_ptr<Log>>& 
+     * @return std::vector<std::shared_ptr<SyntaxLog>> 
      */
-    std::vector<std::shared_ptr<Log>>& logs() { return _logs; }
     std::vector<std::shared_ptr<SyntaxLog>> syntax_logs();
+    /**
+     * @brief Count of logs of a type
+     * 
+     * @param type 
+     * @return std::size_t 
+     */
+    std::size_t count(LogType type) { return _index[type].size(); }
+    /**
+     * @brief Stable sort errors by line
+     * 
+     */
     void sortError();
-    void logError(std::shared_ptr<ErrorLog> log);
-    void log(std::shared_ptr<Log> log);
+    /**
+     * @brief Stream every error to a file descriptor as it is logged,
+     * one line in buaa format each, in log order rather than line order.
+     * The logger does not own fd
+     * 
+     * @param fd -1 to disable
+     */
+    void setSink(int fd) { _sink = fd; }
+    /**
+     * @brief Drop all logs, called before a new compilation
+     * 
+     */
+    void clear();
+    void logError(uint32_t line, std::string_view message, buaa::ErrorType error);
+    void logLexer(uint32_t line, frontend::TokenType type, std::string_view value);
+    void logParser(uint32_t line, std::string_view name);
+    void logSyntax(uint32_t line, uint32_t blockn, std::string_view name, std::string_view type);
 };
 
 }
@@ -0,0 +1,77 @@
+/**
+ * @file loop_info.hpp
+ * @author fyvoid (fyvo1d@outlook.com)
+ * @brief Natural loops of a function
+ * @version 1.0
+ * @date 2024-12-31
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef BLANG_LOOP_INFO_H
+#define BLANG_LOOP_INFO_H
+
+#include "dominator_tree.hpp"
+#include "ir.hpp"
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace blang {
+namespace backend {
+
+using namespace blang::entities;
+
+/**
+ * @brief A natural loop, back edges sharing a header make one loop
+ *
+ */
+struct Loop {
+    Block* header;
+    /**
+     * @brief Blocks of the loop and its inner loops, header first
+     *
+     */
+    std::vector<Block*> blocks;
+    Loop* parent;
+    /**
+     * @brief 1 for an outermost loop
+     *
+     */
+    uint32_t depth;
+};
+
+/**
+ * @brief Loop nest of the reachable blocks of a function
+ * A back edge is an edge to a block dominating its source. Invalidated by
+ * any cfg change
+ *
+ */
+class LoopInfo {
+private:
+    std::vector<std::shared_ptr<Loop>> _loops;
+    std::unordered_map<Block*, Loop*> _innermost;
+public:
+    LoopInfo(Function& function, const DominatorTree& dominators);
+    /**
+     * @brief All loops, outer loops before the loops they contain
+     *
+     * @return const std::vector<std::shared_ptr<Loop>>&
+     */
+    const std::vector<std::shared_ptr<Loop>>& loops() const { return _loops; }
+    /**
+     * @brief Innermost loop containing block
+     *
+     * @param block
+     * @return Loop* nullptr outside of loops
+     */
+    Loop* loopOf(Block* block) const;
+    uint32_t depth(Block* block) const;
+};
+
+}
+}
+
+#endif
@@ -13,8 +13,12 @@
 #define BLANG_OPTIMIZER_H
 
 #include "ir.hpp"
+#include "pass_manager.hpp"
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 using namespace blang::entities;
@@ -22,30 +26,118 @@ using namespace blang::entities;
 namespace blang {
 namespace backend {
 
-class Pass {
-public:
-    Pass() {}
-    virtual ~Pass() {}
-    virtual std::shared_ptr<IrModule> optim(std::shared_ptr<IrModule> module) = 0;
-};
-
 class Optimizer {
 private:
-    std::shared_ptr<IrModule> _module;  
-    std::vector<std::shared_ptr<Pass>> _passes;
+    PassManager _passes;
 public:
+    /**
+     * @brief Pipeline run when none is selected
+     * 
+     */
+    static constexpr const char* DEFAULT_PIPELINE = "unreachable,empty-block,mem2reg,sccp,adce,empty-block";
     Optimizer();
-    std::shared_ptr<IrModule> optim(std::shared_ptr<IrModule> module);
+    /**
+     * @brief Select passes by name, comma separated and run in order, empty for none
+     * 
+     * @param pipeline e.g. "empty-block,mem2reg"
+     */
+    void setPipeline(const std::string& pipeline);
+    /**
+     * @brief Names accepted by setPipeline
+     * 
+     * @return std::vector<std::string> 
+     */
+    static std::vector<std::string> passNames();
+    /**
+     * @brief Removal counts of each pass of the pipeline, summed over every module optimized
+     * 
+     * @return std::vector<std::pair<std::string, PassStats>> 
+     */
+    std::vector<std::pair<std::string, PassStats>> stats() const;
+    /**
+     * @brief Run the pipeline on module
+     * 
+     * @param module 
+     * @param workers Threads running function passes, see PassManager::run
+     * @return std::shared_ptr<IrModule> 
+     */
+    std::shared_ptr<IrModule> optim(std::shared_ptr<IrModule> module, std::size_t workers=1);
 };
 
-class EmptyBlockPass : public Pass {
-    // TODO: optimize
-private:
-    void resetPreBlock(std::shared_ptr<Function> function, std::string from, std::string to);
+/**
+ * @brief Remove blocks holding a single br, their predecessors branch to the target directly
+ * Blocks branching to a block starting with phis are kept, the phis name them
+ * 
+ */
+class EmptyBlockPass : public FunctionPass {
 public:
     EmptyBlockPass() = default;
     virtual ~EmptyBlockPass() = default;
-    virtual std::shared_ptr<IrModule> optim(std::shared_ptr<IrModule> module) override;
+    const char* name() const override { return "empty-block"; }
+    PreservedAnalyses run(Function& function, AnalysisManager& analyses) override;
+};
+
+/**
+ * @brief Promote scalar allocas that are only loaded and stored to ssa registers
+ * Phis are placed on the iterated dominance frontiers of the stores, then loads
+ * are renamed in a preorder walk of the dominator tree. A variable read before
+ * any store reads zero. Phis left unused are removed
+ * 
+ */
+class Mem2RegPass : public FunctionPass {
+public:
+    Mem2RegPass() = default;
+    virtual ~Mem2RegPass() = default;
+    const char* name() const override { return "mem2reg"; }
+    PreservedAnalyses run(Function& function, AnalysisManager& analyses) override;
+};
+
+/**
+ * @brief Sparse conditional constant propagation
+ * Registers are evaluated only once their block is reached through edges
+ * found taken so far, so constants flow through phis of loops and branches on
+ * constants take one edge. Loads of constant scalar globals are constants.
+ * Constant registers are replaced, cond brs taking one edge become brs, blocks
+ * never reached are removed and phis left with one incoming value are replaced by it
+ * 
+ */
+class SCCPPass : public FunctionPass {
+private:
+    std::unordered_map<Value*, int32_t> _globals;
+public:
+    SCCPPass() = default;
+    virtual ~SCCPPass() = default;
+    const char* name() const override { return "sccp"; }
+    void prepare(IrModule& module) override;
+    PreservedAnalyses run(Function& function, AnalysisManager& analyses) override;
+};
+
+/**
+ * @brief Aggressive dead code elimination
+ * Everything is dead unless reached from a root through operands, roots being
+ * stores, calls, rets and branches. Unused loads, casts and cycles of phis
+ * only feeding each other are removed
+ * 
+ */
+class ADCEPass : public FunctionPass {
+public:
+    ADCEPass() = default;
+    virtual ~ADCEPass() = default;
+    const char* name() const override { return "adce"; }
+    PreservedAnalyses run(Function& function, AnalysisManager& analyses) override;
+};
+
+/**
+ * @brief Remove blocks not reachable from the entry block, like code after a
+ * return or break, together with their edges and phi entries
+ * 
+ */
+class UnreachableBlockPass : public FunctionPass {
+public:
+    UnreachableBlockPass() = default;
+    virtual ~UnreachableBlockPass() = default;
+    const char* name() const override { return "unreachable"; }
+    PreservedAnalyses run(Function& function, AnalysisManager& analyses) override;
 };
 
 }
@@ -15,7 +15,12 @@
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <vector>
+#include "arena.hpp"
 #include "logger.hpp"
 #include "token.hpp"
 #include "ast.hpp"
@@ -28,43 +33,72 @@ namespace frontend {
 using namespace entities;
 
 /**
- * @brief Wrapper of a parse try
- * return by tryParse<T> function, parse log stored in buffer
+ * @brief How much of the parse is recorded for the buaa lexer/parser dump
  * 
  */
-struct ParseResult {
-    std::shared_ptr<AstNode> node;
-    std::vector<std::shared_ptr<Log>> log_buffer;
-    std::vector<std::shared_ptr<ErrorLog>> error_buffer;
-    ParseResult() : node(nullptr), 
-        log_buffer(std::vector<std::shared_ptr<Log>>()), 
-        error_buffer(std::vector<std::shared_ptr<ErrorLog>>()) {}
-    /**
-     * @brief Add a log to log buffer
-     * 
-     * @param log 
-     */
-    void log(std::shared_ptr<Log> log) {
-        log_buffer.push_back(log);
-    }
-    /**
-     * @brief Add an error to error log buffer
-     * 
-     * @param error 
-     */
-    void logError(std::shared_ptr<ErrorLog> error) {
-        error_buffer.push_back(error);
-    }
-    /**
-     * @brief Try to get a node of type T
-     * 
-     * @tparam T 
-     * @return std::shared_ptr<T> Return nullptr if not contains expected node
-     */
-    template<typename T>
-    std::shared_ptr<T> get() {
-        return std::dynamic_pointer_cast<T>(node);
-    }
+enum TraceLevel {
+    TRACE_NONE,     // record nothing
+    TRACE_COMPACT,  // record (token index, kind) pairs, text rebuilt by Parser::traceLogs on request
+    TRACE_FULL,     // as compact, and the rebuilt logs are passed to logger after each parse
+};
+
+/**
+ * @brief Kind of a trace record, a consumed token or a finished grammar unit
+ * 
+ */
+enum TraceKind : uint32_t {
+    TRACE_TOKEN,
+    TRACE_COMP_UNIT,
+    TRACE_MAIN_FUNC_DEF,
+    TRACE_FUNC_TYPE,
+    TRACE_FUNC_DEF,
+    TRACE_FUNC_F_PARAMS,
+    TRACE_FUNC_F_PARAM,
+    TRACE_BLOCK,
+    TRACE_STMT,
+    TRACE_FOR_STMT,
+    TRACE_EXP,
+    TRACE_CONST_EXP,
+    TRACE_COND,
+    TRACE_L_VAL,
+    TRACE_PRIMARY_EXP,
+    TRACE_CHARACTER,
+    TRACE_NUMBER,
+    TRACE_UNARY_OP,
+    TRACE_UNARY_EXP,
+    TRACE_FUNC_R_PARAMS,
+    TRACE_MUL_EXP,
+    TRACE_ADD_EXP,
+    TRACE_REL_EXP,
+    TRACE_EQ_EXP,
+    TRACE_L_AND_EXP,
+    TRACE_L_OR_EXP,
+    TRACE_CONST_DECL,
+    TRACE_VAR_DECL,
+    TRACE_CONST_DEF,
+    TRACE_VAR_DEF,
+    TRACE_CONST_INIT_VAL,
+    TRACE_INIT_VAL,
+};
+
+/**
+ * @brief Compact trace record
+ * token is the index of the consumed token for TRACE_TOKEN,
+ * otherwise the token whose line is reported for the unit
+ * 
+ */
+struct TraceRecord {
+    uint32_t token;
+    TraceKind kind;
+};
+
+/**
+ * @brief Packrat memo counters of the last parse
+ * 
+ */
+struct MemoStats {
+    uint64_t hits;
+    uint64_t misses;
 };
 
 /**
@@ -74,20 +108,65 @@ struct ParseResult {
 class Parser {
 private:
     std::shared_ptr<Logger> _logger;
+    std::shared_ptr<tools::Arena> _arena;
     std::shared_ptr<std::vector<Token>> _tokens;
 
     uint32_t _pos;
+    /**
+     * @brief Parse trace and errors
+     * Append only while parsing, ranges dropped by revert are recorded dead and removed after parsing
+     * 
+     */
+    TraceLevel _trace_level;
+    std::vector<TraceRecord> _trace;
+    std::vector<PendingError> _errors;
+    std::vector<std::pair<std::size_t, std::size_t>> _dead_trace;
+    std::vector<std::pair<std::size_t, std::size_t>> _dead_errors;
+    /**
+     * @brief LVal already parsed at statement level, consumed by the next parsePrimary
+     * IDENT starts both AssignStmt and ExpStmt, the lval is parsed once and handed down
+     * 
+     */
+    LValNode* _pending_lval;
+    /**
+     * @brief Productions cached by the packrat memo
+     * 
+     */
+    enum Production : uint32_t {
+        PROD_LVAL,
+        PROD_EXP,
+        PROD_CONST_EXP,
+    };
+    /**
+     * @brief Cached parse of a production at a token position
+     * trace and errors are ranges of the buffers, replayed on hit, parsing resumes from end
+     * 
+     */
+    struct MemoEntry {
+        AstNode* node;
+        uint32_t end;
+        std::size_t trace_begin, trace_end;
+        std::size_t error_begin, error_end;
+    };
+    bool _memoize;
+    std::unordered_map<uint64_t, MemoEntry> _memo;
+    MemoStats _memo_stats;
     /**
     * @brief espace character definations
     * 
     */
     static const std::map<char, char> _escape_character_map;
+    /**
+     * @brief Grammar unit names of trace kinds, as printed in the buaa parser dump
+     * 
+     */
+    static const char* const _trace_names[];
 
-    std::string parseString(const std::string in);
-    int32_t parseInt(const std::string in);
-    char parseChar(const std::string in);
-    Op parseUnaryOp(std::shared_ptr<ParseResult> buffer);
-    std::tuple<Type*, std::string> parseFuncParam(std::shared_ptr<ParseResult> result);
+    std::string parseString(std::string_view in);
+    int32_t parseInt(std::string_view in);
+    char parseChar(std::string_view in);
+    Op parseUnaryOp();
+    std::tuple<Type*, Ident> parseFuncParam();
 
     const Token& last() { return (*_tokens)[_pos - 1]; }
     bool atEnd() { return _pos >= _tokens->size(); }
@@ -95,44 +174,46 @@ private:
     const Token& peak(uint32_t offset = 1) { 
         return _pos + offset >= _tokens->size() ? (*_tokens)[_tokens->size() - 1] : (*_tokens)[_pos + offset]; 
     }
-    std::shared_ptr<LexerLog> step() {
-        auto ret = std::make_shared<LexerLog>(line(), current().type, current().value);
+    void step() {
+        trace(_pos, TRACE_TOKEN);
         if (!atEnd()) _pos++; 
-        return ret;
     }
     uint32_t line() { return current().line; }
 
-    std::shared_ptr<ParseResult> parseCompUnit();
-    std::shared_ptr<ParseResult> parseMainFuncDef();
-    std::shared_ptr<ParseResult> parseFuncDef();
-    std::shared_ptr<ParseResult> parseFuncFParams();
-    std::shared_ptr<ParseResult> parseBlock();
-    std::shared_ptr<ParseResult> parseBlockItem();
-    std::shared_ptr<ParseResult> parseStmt();
-    std::shared_ptr<ParseResult> parseExpStmt();
-    std::shared_ptr<ParseResult> parseBlockStmt();
-    std::shared_ptr<ParseResult> parseIfStmt();
-    std::shared_ptr<ParseResult> parseForStmt();
-    std::shared_ptr<ParseResult> parseReturnStmt();
-    std::shared_ptr<ParseResult> parseAssignStmt();
-    std::shared_ptr<ParseResult> parsePrintfStmt();
-    std::shared_ptr<ParseResult> parseInitVal(bool is_const);
-    std::shared_ptr<ParseResult> parseDef(bool is_const);
-    std::shared_ptr<ParseResult> parseDecl();
-    std::shared_ptr<ParseResult> parseLAndExp();
-    std::shared_ptr<ParseResult> parseEqExp();
-    std::shared_ptr<ParseResult> parseRelExp();
-    std::shared_ptr<ParseResult> parseLOrExp();
-    std::shared_ptr<ParseResult> parseCondExp();
-    std::shared_ptr<ParseResult> parseMulExp();
-    std::shared_ptr<ParseResult> parseAddExp();
-    std::shared_ptr<ParseResult> parseExp(bool is_const=false);
-    std::shared_ptr<ParseResult> parseFuncRParams();
-    std::shared_ptr<ParseResult> parseUnaryExp();
-    std::shared_ptr<ParseResult> parsePrimary();
-    std::shared_ptr<ParseResult> parseRVal();
-    std::shared_ptr<ParseResult> parseLVal();
-    std::shared_ptr<ParseResult> parseValue();
+    CompNode* parseCompUnit();
+    MainNode* parseMainFuncDef();
+    FuncDefNode* parseFuncDef();
+    FuncFParamsNode* parseFuncFParams();
+    BlockNode* parseBlock();
+    BlockItemNode* parseBlockItem();
+    StmtNode* parseStmt();
+    StmtNode* parseIdentStmt();
+    ExpStmtNode* parseExpStmt();
+    BlockStmtNode* parseBlockStmt();
+    IfStmtNode* parseIfStmt();
+    ForStmtNode* parseForStmt();
+    ReturnStmtNode* parseReturnStmt();
+    AssignStmtNode* parseAssignStmt(LValNode* lval);
+    PrintfStmtNode* parsePrintfStmt();
+    InitValNode* parseInitVal(bool is_const);
+    DefNode* parseDef(bool is_const);
+    DeclNode* parseDecl();
+    ExpNode* parseLAndExp();
+    ExpNode* parseEqExp();
+    ExpNode* parseRelExp();
+    ExpNode* parseLOrExp();
+    ExpNode* parseCondExp();
+    ExpNode* parseMulExp();
+    ExpNode* parseAddExp();
+    ExpNode* parseExp(bool is_const=false);
+    FuncRParamsNode* parseFuncRParams();
+    UnaryExpNode* parseUnaryExp();
+    PrimaryExpNode* parsePrimary();
+    RValNode* parseRVal();
+    LValNode* parseLVal();
+    LValNode* parseLValImpl();
+    ExpNode* parseExpImpl(bool is_const);
+    ValueNode* parseValue();
 
     Type* token2Type(Token token);
 
@@ -153,42 +234,114 @@ private:
      * @return false 
      */
     bool check(TokenType type) { return current().type == type; }
+    /**
+     * @brief Check if current token is in FIRST(Exp)
+     * 
+     * @return true 
+     * @return false 
+     */
+    bool checkExp();
+    /**
+     * @brief Check if tokens from current one start a function definition, type IDENT (
+     * 
+     * @return true 
+     * @return false 
+     */
+    bool matchFuncDef() { return token2Type(current()) && peak(1).type == IDENT && peak(2).type == LEFT_BRACE; }
+    /**
+     * @brief Check if tokens from current one start main function definition, type main (
+     * 
+     * @return true 
+     * @return false 
+     */
+    bool matchMainFuncDef() { return token2Type(current()) && peak(1).type == MAIN && peak(2).type == LEFT_BRACE; }
 
-    void update(std::shared_ptr<ParseResult> buffer, std::shared_ptr<ParseResult> result);
-    void revert(uint32_t pos) { _pos = pos; }
-
-    using ParseFuncPtr = std::shared_ptr<ParseResult> (Parser::*)();
-    using ParseTypeFuncPtr = std::shared_ptr<ParseResult> (Parser::*)(bool);
     /**
-    * @brief Try parsing a node, save results to buffer if success, discard any change if fail
-    * 
-    * @tparam T Node type to parse
-    * @param func Parse function
-    * @param buffer Parse result buffer
-    * @return std::shared_ptr<T> Return nullptr on failure
-    */
-    template<typename T>
-    std::shared_ptr<T> tryParse(ParseFuncPtr func, std::shared_ptr<ParseResult> buffer);
+     * @brief Record a trace item if tracing is on
+     * 
+     * @param token 
+     * @param kind 
+     */
+    void trace(uint32_t token, TraceKind kind) {
+        if (_trace_level != TRACE_NONE) _trace.push_back({token, kind});
+    }
+    /**
+     * @brief Record end of a grammar unit at current token
+     * 
+     * @param kind 
+     */
+    void trace(TraceKind kind) { trace(_pos, kind); }
+    void logError(uint32_t line, const char* message, buaa::ErrorType error) { _errors.push_back({line, message, error}); }
+    /**
+     * @brief Go back to a token position, trace and errors made after it are marked dead
+     * 
+     * @param pos 
+     * @param trace Trace size to keep
+     * @param errors Error count to keep
+     */
+    void revert(uint32_t pos, std::size_t trace, std::size_t errors);
+    /**
+     * @brief Run a parse function through the memo table when memoization is on
+     * 
+     * @tparam T Node type returned
+     * @tparam Args 
+     * @param production Memo key, together with current token position
+     * @param func Parse function
+     * @param args 
+     * @return T* 
+     */
+    template<typename T, typename... Args>
+    T* memo(Production production, T* (Parser::*func)(Args...), Args... args);
+public:
     /**
-    * @brief Try parsing a node with constant flag types, save results to buffer on success, dicard any change on failure
+    * @brief Construct a new Parser
     * 
-    * @tparam T Node type to parse
-    * @param func Parse function
-    * @param is_const constant flag
-    * @param buffer Parse result buffer
-    * @return std::shared_ptr<T> Return nullptr on failure
+    * @param logger 
+    * @param arena Arena ast nodes are allocated from, reset by the owner between compilations
     */
-    template<typename T>
-    std::shared_ptr<T> tryParse(ParseTypeFuncPtr func, bool is_const, std::shared_ptr<ParseResult> buffer);
-public:
-    Parser(std::shared_ptr<Logger> logger);
+    Parser(std::shared_ptr<Logger> logger, std::shared_ptr<tools::Arena> arena);
     /**
     * @brief Parse tokens from lexer to form ast
+    * Predictive recursive descent, every production is chosen by
+    * at most three tokens of lookahead, so parsing never backtracks
     * 
     * @param tokens 
-    * @return std::shared_ptr<CompNode> 
+    * @return CompNode* Allocated in arena, nullptr if parsing aborts
+    */
+    CompNode* parse(std::shared_ptr<std::vector<Token>> tokens);
+    /**
+    * @brief Enable packrat memoization, off by default
+    * IDENT statements are then parsed speculatively as AssignStmt first,
+    * the ExpStmt retry takes LVal and Exp from the memo instead of parsing again
+    * 
+    * @param enable 
+    */
+    void setMemoize(bool enable) { _memoize = enable; }
+    /**
+    * @brief Memo hits and misses of the last parse
+    * 
+    * @return MemoStats 
+    */
+    MemoStats memoStats() { return _memo_stats; }
+    /**
+    * @brief Set how much of the parse is recorded, TRACE_FULL by default
+    * 
+    * @param level 
+    */
+    void setTraceLevel(TraceLevel level) { _trace_level = level; }
+    /**
+    * @brief Compact trace of the last parse, empty under TRACE_NONE
+    * 
+    * @return const std::vector<TraceRecord>& 
+    */
+    const std::vector<TraceRecord>& trace() { return _trace; }
+    /**
+    * @brief Rebuild lexer and parser logs of the last parse from its trace
+    * Token values are views into the source, which must still be alive
+    * 
+    * @return std::vector<std::shared_ptr<Log>> 
     */
-    std::shared_ptr<CompNode> parse(std::shared_ptr<std::vector<Token>> tokens);
+    std::vector<std::shared_ptr<Log>> traceLogs();
 };
 
 }
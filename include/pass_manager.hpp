@@ -0,0 +1,201 @@
+/**
+ * @file pass_manager.hpp
+ * @author fyvoid (fyvo1d@outlook.com)
+ * @brief Passes, the pass manager and cached function analyses
+ * @version 1.0
+ * @date 2024-12-31
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef BLANG_PASS_MANAGER_H
+#define BLANG_PASS_MANAGER_H
+
+#include "dominator_tree.hpp"
+#include "ir.hpp"
+#include "liveness.hpp"
+#include "loop_info.hpp"
+#include "thread_pool.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace blang {
+namespace backend {
+
+using namespace blang::entities;
+
+/**
+ * @brief Analyses cached by AnalysisManager, bits of a preserved set
+ *
+ */
+enum AnalysisKind : uint32_t {
+    ANALYSIS_DOMINATORS = 1 << 0,
+    ANALYSIS_LOOPS = 1 << 1,
+    ANALYSIS_LIVENESS = 1 << 2,
+};
+
+/**
+ * @brief Set of analyses a pass leaves valid
+ *
+ */
+using PreservedAnalyses = uint32_t;
+constexpr PreservedAnalyses PRESERVE_NONE = 0;
+constexpr PreservedAnalyses PRESERVE_ALL = ~PreservedAnalyses(0);
+/**
+ * @brief Blocks and edges untouched, only instructions changed
+ *
+ */
+constexpr PreservedAnalyses PRESERVE_CFG = ANALYSIS_DOMINATORS | ANALYSIS_LOOPS;
+
+/**
+ * @brief Lazily computed analyses of each function, kept until invalidated
+ *
+ */
+class AnalysisManager {
+private:
+    struct Cache {
+        std::shared_ptr<DominatorTree> dominators;
+        std::shared_ptr<LoopInfo> loops;
+        std::shared_ptr<Liveness> liveness;
+    };
+    std::unordered_map<Function*, Cache> _caches;
+    Cache& cache(Function& function);
+public:
+    AnalysisManager() = default;
+    /**
+     * @brief Make a cache entry for every function of module, after that
+     * analyses of different functions can be requested from different threads
+     * 
+     * @param module 
+     */
+    void prepare(IrModule& module);
+    const DominatorTree& dominators(Function& function);
+    const LoopInfo& loops(Function& function);
+    const Liveness& liveness(Function& function);
+    /**
+     * @brief Drop analyses of function not in preserved, loops go with dominators
+     *
+     * @param function
+     * @param preserved
+     */
+    void invalidate(Function& function, PreservedAnalyses preserved);
+    void invalidate(IrModule& module, PreservedAnalyses preserved);
+    void clear() { _caches.clear(); }
+};
+
+/**
+ * @brief What a pass removed
+ *
+ */
+struct PassStats {
+    std::size_t instructs = 0;
+    std::size_t blocks = 0;
+};
+
+class Pass {
+private:
+    std::atomic<std::size_t> _removed_instructs;
+    std::atomic<std::size_t> _removed_blocks;
+protected:
+    /**
+     * @brief Count removed instructions and blocks, safe from parallel function runs
+     *
+     * @param stats
+     */
+    void removed(PassStats stats) {
+        _removed_instructs.fetch_add(stats.instructs, std::memory_order_relaxed);
+        _removed_blocks.fetch_add(stats.blocks, std::memory_order_relaxed);
+    }
+public:
+    Pass() : _removed_instructs(0), _removed_blocks(0) {}
+    virtual ~Pass() {}
+    /**
+     * @brief Instructions and blocks removed by every run of this pass so far
+     *
+     * @return PassStats
+     */
+    PassStats stats() const { return {_removed_instructs.load(), _removed_blocks.load()}; }
+    /**
+     * @brief Name of the pass in a -passes= pipeline
+     *
+     * @return const char*
+     */
+    virtual const char* name() const = 0;
+    /**
+     * @brief Run on a whole module
+     *
+     * @param module
+     * @param analyses
+     * @return PreservedAnalyses Analyses still valid for every function
+     */
+    virtual PreservedAnalyses run(IrModule& module, AnalysisManager& analyses) = 0;
+};
+
+/**
+ * @brief Pass transforming functions independently of each other
+ * Analyses are invalidated after each function
+ *
+ */
+class FunctionPass : public Pass {
+public:
+    /**
+     * @brief Read module level state once before functions are run, maybe in parallel
+     * Function passes never change globals, so it holds for the whole stage
+     *
+     * @param module
+     */
+    virtual void prepare(IrModule& module) {}
+    virtual PreservedAnalyses run(Function& function, AnalysisManager& analyses) = 0;
+    PreservedAnalyses run(IrModule& module, AnalysisManager& analyses) override final;
+};
+
+/**
+ * @brief Runs passes in order and invalidates analyses after each
+ * Consecutive function passes form a stage, every function goes through a
+ * whole stage as one task on a thread pool. Module passes are barriers
+ * between stages. A function only ever sees its own blocks, registers and
+ * analyses, so the result does not depend on the thread count
+ *
+ */
+class PassManager {
+private:
+    /**
+     * @brief Modules with fewer instructions are optimized on the calling thread only
+     * 
+     */
+    static constexpr std::size_t PARALLEL_RUN_INSTRUCTS = 16 * 1024;
+    std::vector<std::shared_ptr<Pass>> _passes;
+    AnalysisManager _analyses;
+    /**
+     * @brief Created on the first parallel run and kept for later modules
+     * 
+     */
+    std::unique_ptr<tools::ThreadPool> _pool;
+    void runStage(std::vector<FunctionPass*>& stage, IrModule& module, std::vector<Function*>& functions, std::size_t workers);
+public:
+    PassManager() = default;
+    void add(std::shared_ptr<Pass> pass) { _passes.push_back(pass); }
+    const std::vector<std::shared_ptr<Pass>>& passes() const { return _passes; }
+    void clear() { _passes.clear(); }
+    /**
+     * @brief Run the pipeline, analyses cached for module are dropped after
+     * Function passes of a module with several functions and enough
+     * instructions run on workers threads. They must not create derived
+     * types, worker threads have no type context installed
+     *
+     * @param module
+     * @param workers
+     */
+    void run(IrModule& module, std::size_t workers=1);
+};
+
+}
+}
+
+#endif
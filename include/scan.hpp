@@ -0,0 +1,87 @@
+/**
+ * @file scan.hpp
+ * @author fyvoid (fyvo1d@outlook.com)
+ * @brief Block at a time scanning kernels for the lexer
+ * @version 1.0
+ * @date 2024-12-20
+ * 
+ * @copyright Copyright (c) 2024
+ * 
+ */
+
+#ifndef BLANG_SCAN_H
+#define BLANG_SCAN_H
+
+#include <cstdint>
+
+namespace blang {
+
+namespace frontend {
+
+namespace scan {
+
+/**
+ * @brief Instruction set used by the kernels
+ * 
+ */
+enum ScanLevel {
+    SCAN_SCALAR, SCAN_SSE2, SCAN_AVX2,
+};
+
+/**
+ * @brief Best level supported by this cpu
+ * 
+ * @return ScanLevel 
+ */
+ScanLevel detect();
+/**
+ * @brief Level currently in use, detect() unless changed by select()
+ * 
+ * @return ScanLevel 
+ */
+ScanLevel level();
+/**
+ * @brief Change level in use, clamped to detect()
+ * Not thread safe, only call while no lexer is running
+ * 
+ * @param level 
+ * @return ScanLevel Level actually selected
+ */
+ScanLevel select(ScanLevel level);
+const char* name(ScanLevel level);
+
+/**
+ * @brief Find the first byte in [p, end) that is not ' ', '\t', '\b' or '\n'
+ * 
+ * @param p 
+ * @param end 
+ * @param lines Increased by the count of '\n' skipped
+ * @return const char* First non blank byte, or end
+ */
+const char* skipBlank(const char* p, const char* end, uint32_t& lines);
+/**
+ * @brief Find the first '\n' or '\r' in [p, end)
+ * 
+ * @param p 
+ * @param end 
+ * @return const char* Line break, or end
+ */
+const char* findLineBreak(const char* p, const char* end);
+/**
+ * @brief Find the first block comment terminator ('*' then '/') in [p, end)
+ * end[0] must be readable
+ * 
+ * @param p 
+ * @param end 
+ * @param lines Increased by the count of '\n' before the match
+ * @return const char* The '*' of the match, or end
+ */
+const char* findCommentEnd(const char* p, const char* end, uint32_t& lines);
+
+}
+
+}
+
+}
+
+#endif
@@ -0,0 +1,84 @@
+/**
+ * @file source.hpp
+ * @author fyvoid (fyvo1d@outlook.com)
+ * @brief Source file buffer for blang
+ * @version 1.0
+ * @date 2024-12-20
+ * 
+ * @copyright Copyright (c) 2024
+ * 
+ */
+
+#ifndef BLANG_SOURCE_H
+#define BLANG_SOURCE_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace blang {
+
+namespace tools {
+
+/**
+ * @brief How a source file is loaded
+ * 
+ */
+enum LoadMode {
+    LOAD_COPY,  // read the file into a heap buffer
+    LOAD_MMAP,  // map the file read only, fall back to copy if mapping fails
+};
+
+/**
+ * @brief Read only source text
+ * Tokens keep views into this buffer, so it must outlive them
+ * The text is always followed by a '\0' sentinel, data()[size()] is readable
+ * 
+ */
+class SourceBuffer {
+private:
+    const char* _data;
+    std::size_t _size;
+    bool _mapped;
+    std::vector<char> _copy;
+    SourceBuffer() : _data(nullptr), _size(0), _mapped(false) {}
+    static std::shared_ptr<SourceBuffer> map(const std::string& filename);
+    static std::shared_ptr<SourceBuffer> read(const std::string& filename);
+public:
+    ~SourceBuffer();
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+    /**
+     * @brief Load a source file
+     * throw std::runtime_error if file cannot be opened or is empty
+     *
+     * @param filename
+     * @param mode
+     * @return std::shared_ptr<SourceBuffer>
+     */
+    static std::shared_ptr<SourceBuffer> load(const std::string& filename, LoadMode mode=LOAD_MMAP);
+    /**
+     * @brief Wrap source text already in memory, the text is copied
+     *
+     * @param text
+     * @return std::shared_ptr<SourceBuffer>
+     */
+    static std::shared_ptr<SourceBuffer> fromString(std::string_view text);
+    /**
+     * @brief Source text, terminated by a '\0' sentinel
+     * 
+     * @return const char* 
+     */
+    const char* data() { return _data; }
+    std::size_t size() { return _size; }
+    bool mapped() { return _mapped; }
+    std::string_view view() { return std::string_view(_data, _size); }
+};
+
+}
+
+}
+
+#endif
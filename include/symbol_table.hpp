@@ -12,13 +12,17 @@
 #ifndef BLANG_SYMBOL_TABLE_H
 #define BLANG_SYMBOL_TABLE_H
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
-#include <cstring>
 #include <memory>
 #include <string>
 #include <tuple>
+#include <type_traits>
 #include <vector>
+#include "arena.hpp"
 #include "ast.hpp"
+#include "ident.hpp"
 #include "ir.hpp"
 #include "type.hpp"
 
@@ -33,15 +37,18 @@ namespace entities {
  */
 class Symbol {
 protected:
-    const std::string _ident;
-    Symbol(const std::string& ident) : _ident(ident) {}
+    const Ident _ident;
+    Symbol(Ident ident) : _ident(ident) {}
     virtual ~Symbol() {}
 public:
-    std::string ident() { return _ident; }
+    Ident ident() { return _ident; }
 };
 
 /**
  * @brief Variable, sub class of Symbol
+ * Compile time content is a typed span in the arena of the compilation,
+ * holding only the leading values up to the last non zero one.
+ * Elements past the span read as zero, so a zero filled array stores nothing
  * 
  */
 class Var : public Symbol {
@@ -49,137 +56,129 @@ private:
     Type* const _type;
     const bool _is_const;
     std::shared_ptr<PtrValue> _value;
-    void* _content;
-    Var(Type* type, const std::string& ident, bool is_const) :
+    tools::Span<int32_t> _ints;
+    tools::Span<char> _chars;
+    Var(Type* type, Ident ident, bool is_const) :
         Symbol(ident), _type(type), _is_const(is_const) {}
-    /**
-     * @brief Construct a new single var
-     * 
-     * @tparam T type of value stored in content
-     * @param type Type of the variable
-     * @param ident 
-     * @param is_const 
-     * @param val initilize value
-     * @return std::shared_ptr<Var> 
-     */
-    template<typename T>
-    static std::shared_ptr<Var> getSingle(Type* type, const std::string& ident, bool is_const, T val) {
-        auto ret = std::shared_ptr<Var>(new Var(type, ident, is_const));
-        ret->_content = (void*) new T(val);
-        return ret;
-    }
-    /**
-     * @brief Construct a new Array var
-     * 
-     * @tparam T type of value stored in content
-     * @param type Type of the variable
-     * @param ident 
-     * @param is_const 
-     * @param val initilize value
-     * @return std::shared_ptr<Var> 
-     */
-    template<typename T>
-    static std::shared_ptr<Var> getArray(Type* type, const std::string& ident, bool is_const, uint32_t length) {
-        auto ret = std::shared_ptr<Var>(new Var(ArrayType::get(type, length), ident, is_const));
-        ret->_content = (void*) new T[length];
-        memset(ret->_content, 0, sizeof(T) * length);
-        return ret;
-    }
-    /**
-     * @brief Construct a new pointer var
-     * 
-     * @tparam T type of value stored in content
-     * @param type Type of the pointed target
-     * @param ident 
-     * @param is_const 
-     * @param val initilize value
-     * @return std::shared_ptr<Var> 
-     */
     template<typename T>
-    static std::shared_ptr<Var> getPtr(Type* type, const std::string& ident, bool is_const) {
-        auto ret = std::shared_ptr<Var>(new Var(PtrType::get(type), ident, is_const));
-        ret->_content = (void*) new T*(0);
-        return ret;
+    tools::Span<T>& span() {
+        if constexpr (std::is_same_v<T, char>) {
+            return _chars;
+        } else {
+            return _ints;
+        }
     }
 public:
-    ~Var();
     /**
      * @brief Get a Int Var
      * 
      * @param ident 
      * @param is_const 
-     * @param val 
      * @return std::shared_ptr<Var> 
      */
-    static std::shared_ptr<Var> getInt(const std::string& ident, bool is_const, int32_t val=0) {
-        return getSingle<int32_t>(IntType::get(), ident, is_const, val);
+    static std::shared_ptr<Var> getInt(Ident ident, bool is_const) {
+        return std::shared_ptr<Var>(new Var(IntType::get(), ident, is_const));
     }
     /**
      * @brief Get a Char Var
      * 
      * @param ident 
      * @param is_const 
-     * @param val 
      * @return std::shared_ptr<Var> 
      */
-    static std::shared_ptr<Var> getChar(const std::string& ident, bool is_const, char val=0) {
-        return getSingle<char>(CharType::get(), ident, is_const, val);
+    static std::shared_ptr<Var> getChar(Ident ident, bool is_const) {
+        return std::shared_ptr<Var>(new Var(CharType::get(), ident, is_const));
     }
     /**
      * @brief Get a Int Array
      * 
      * @param ident 
      * @param is_const 
-     * @param val 
+     * @param length 
      * @return std::shared_ptr<Var> 
      */
-    static std::shared_ptr<Var> getIntArray(const std::string& ident, bool is_const, uint32_t length) {
-        return getArray<int32_t>(IntType::get(), ident, is_const, length);
+    static std::shared_ptr<Var> getIntArray(Ident ident, bool is_const, uint32_t length) {
+        return std::shared_ptr<Var>(new Var(ArrayType::get(IntType::get(), length), ident, is_const));
     }
     /**
      * @brief Get a Char Array
      * 
      * @param ident 
      * @param is_const 
-     * @param val 
+     * @param length 
      * @return std::shared_ptr<Var> 
      */
-    static std::shared_ptr<Var> getCharArray(const std::string& ident, bool is_const, uint32_t length) {
-        return getArray<char>(CharType::get(), ident, is_const, length);
+    static std::shared_ptr<Var> getCharArray(Ident ident, bool is_const, uint32_t length) {
+        return std::shared_ptr<Var>(new Var(ArrayType::get(CharType::get(), length), ident, is_const));
     }
     /**
      * @brief Get a Int Pointer
      * 
      * @param ident 
      * @param is_const 
-     * @param val 
      * @return std::shared_ptr<Var> 
      */
-    static std::shared_ptr<Var> getIntPtr(const std::string& ident, bool is_const) {
-        return getPtr<int32_t>(IntType::get(), ident, is_const);
+    static std::shared_ptr<Var> getIntPtr(Ident ident, bool is_const) {
+        return std::shared_ptr<Var>(new Var(PtrType::get(IntType::get()), ident, is_const));
     }
     /**
      * @brief Get a Char Pointer
      * 
      * @param ident 
      * @param is_const 
-     * @param val 
      * @return std::shared_ptr<Var> 
      */
-    static std::shared_ptr<Var> getCharPtr(const std::string& ident, bool is_const) {
-        return getPtr<char>(CharType::get(), ident, is_const);
+    static std::shared_ptr<Var> getCharPtr(Ident ident, bool is_const) {
+        return std::shared_ptr<Var>(new Var(PtrType::get(CharType::get()), ident, is_const));
     }
 
     Type* type() { return _type; }
     bool is_const() { return _is_const; }
     /**
-     * @brief Try to get content, converted to type T
+     * @brief Set compile time content, trailing zeros are dropped
      * 
-     * @tparam T 
-     * @return T* 
+     * @tparam T int32_t or char, element type of var
+     * @tparam V 
+     * @param arena Arena of current compilation
+     * @param values Converted to T
+     * @param count Values beyond count are ignored
+     */
+    template<typename T, typename V>
+    void init(tools::Arena& arena, const std::vector<V>& values, std::size_t count) {
+        count = std::min(count, values.size());
+        while (count > 0 && static_cast<T>(values[count - 1]) == 0) {
+            count--;
+        }
+        if (count == 0) {
+            span<T>() = tools::Span<T>();
+            return ;
+        }
+        auto data = static_cast<T*>(arena.allocate(sizeof(T) * count, alignof(T)));
+        for (std::size_t i = 0; i < count; i++) {
+            data[i] = static_cast<T>(values[i]);
+        }
+        span<T>() = tools::Span<T>(data, count);
+    }
+    /**
+     * @brief Element of compile time content, index 0 for a single var
+     * 
+     * @tparam T int32_t or char, element type of var
+     * @param index 
+     * @return T 
      */
     template<typename T>
-    T* get() { return static_cast<T*>(_content); }
+    T at(uint32_t index) {
+        auto& content = span<T>();
+        return index < content.size() ? content[index] : static_cast<T>(0);
+    }
+    /**
+     * @brief Stored leading values of compile time content
+     * 
+     * @tparam T int32_t or char, element type of var
+     * @return tools::Span<T> 
+     */
+    template<typename T>
+    tools::Span<T> content() { return span<T>(); }
     std::shared_ptr<PtrValue>& value() { return _value; }
 };
 
@@ -190,125 +189,154 @@ public:
 class Func : public Symbol {
 private:
     Type* const _return_type;
-    const std::vector<std::tuple<Type*, std::string>> _params;
+    const std::vector<std::tuple<Type*, Ident>> _params;
     std::shared_ptr<Function> _function;
     FuncDefNode* const _node;
 public:
-    Func(Type* return_type, const std::string& ident, std::vector<std::tuple<Type*, std::string>> params, FuncDefNode* node) :
+    Func(Type* return_type, Ident ident, std::vector<std::tuple<Type*, Ident>> params, FuncDefNode* node) :
         Symbol(ident), _return_type(return_type), _params(params), _node(node) {}
     Type* return_type() { return _return_type; }
-    const std::vector<std::tuple<Type*, std::string>>& params() { return _params; }
+    const std::vector<std::tuple<Type*, Ident>>& params() { return _params; }
     FuncDefNode* node() { return _node; }
     std::shared_ptr<Function>& function() { return _function; }
 };
 
 /**
- * @brief SymbolTable base class, provide methods to store and acquired symbols
+ * @brief Flat symbol table of one compilation
+ * Scopes are a stack instead of a chain of tables. Every ident maps to
+ * its innermost local var, each local var links to the one it shadows,
+ * so lookups take constant time however deep the nesting is.
+ * Ident ids are dense, ident maps are vectors indexed by id.
+ * Functions and global vars live in the global scope, depth 0
  * 
  */
 class SymbolTable {
-protected:
-    std::vector<std::string> _symbol_order;
-    std::map<std::string, std::shared_ptr<Symbol>> _symbols;
-    static uint32_t _block_counter;
-    const uint32_t _blockn;
-    SymbolTable() : _symbol_order({}), _symbols({}), _blockn(_block_counter) {
-        _block_counter++;
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+    static constexpr uint32_t GLOBAL_BLOCKN = 1;
+    /**
+     * @brief Global symbol, exactly one of var and func is set
+     * 
+     */
+    struct Global {
+        std::shared_ptr<Var> var;
+        std::shared_ptr<Func> func;
+    };
+    struct Local {
+        std::shared_ptr<Var> var;
+        uint32_t depth;
+        /**
+         * @brief Local var of same ident in an outer scope, NONE if none
+         * 
+         */
+        uint32_t shadowed;
+    };
+    struct Scope {
+        uint32_t blockn;
+        /**
+         * @brief Size of local stack when scope is pushed
+         * 
+         */
+        uint32_t locals;
+    };
+    std::vector<Global> _globals;
+    std::vector<uint32_t> _global_slots;
+    std::vector<Local> _locals;
+    std::vector<uint32_t> _local_slots;
+    std::vector<Scope> _scopes;
+    uint32_t _next_blockn;
+    MainNode* _main_node;
+    /**
+     * @brief Get slot of an ident, NONE if not mapped
+     * 
+     * @param slots 
+     * @param ident 
+     * @return uint32_t 
+     */
+    static uint32_t slot(std::vector<uint32_t>& slots, Ident ident) {
+        return ident.id() < slots.size() ? slots[ident.id()] : NONE;
+    }
+    static void setSlot(std::vector<uint32_t>& slots, Ident ident, uint32_t index) {
+        if (ident.id() >= slots.size()) {
+            slots.resize(ident.id() + 1, NONE);
+        }
+        slots[ident.id()] = index;
     }
-protected:
-    bool add(std::shared_ptr<Symbol> symbol);
-    std::shared_ptr<Symbol> get(const std::string& ident);
 public:
-    uint32_t blockn() { return _blockn; }
+    SymbolTable() : _next_blockn(GLOBAL_BLOCKN + 1), _main_node(nullptr) {}
     /**
-     * @brief Add a variable to symbol table
+     * @brief Enter a new block, numbered after all blocks entered before
      * 
-     * @param var 
-     * @return true 
-     * @return false 
      */
-    virtual bool addVar(std::shared_ptr<Var> var) = 0;
+    void pushScope();
     /**
-     * @brief Add a function to symbol table
+     * @brief Leave current block, its vars are dropped
      * 
-     * @param func 
-     * @return true 
-     * @return false 
      */
-    virtual bool addFunc(std::shared_ptr<Func> func) = 0;
+    void popScope();
     /**
-     * @brief Get a variable from symbol table
+     * @brief Nesting depth of current block, 0 for global
      * 
-     * @param ident 
-     * @return std::shared_ptr<Var> 
+     * @return uint32_t 
      */
-    virtual std::shared_ptr<Var> getVar(const std::string& ident) = 0;
+    uint32_t depth() { return static_cast<uint32_t>(_scopes.size()); }
     /**
-     * @brief Get a function from symbol table
+     * @brief Number of current block, 1 for global
+     * 
+     * @return uint32_t 
+     */
+    uint32_t blockn() { return _scopes.empty() ? GLOBAL_BLOCKN : _scopes.back().blockn; }
+    /**
+     * @brief If a symbol is declared in current block, outer blocks not searched
      * 
      * @param ident 
-     * @return std::shared_ptr<Func> 
+     * @return true 
+     * @return false 
      */
-    virtual std::shared_ptr<Func> getFunc(const std::string& ident) = 0;
-    std::vector<std::shared_ptr<Var>> getVars();
-    std::vector<std::shared_ptr<Func>> getFuncs();
-};
-
-/**
- * @brief Global symbol table
- * 
- */
-class GlobalSymbolTable : public SymbolTable {
-private:
-    std::shared_ptr<MainNode> _main_node;
-public:
-    GlobalSymbolTable() : SymbolTable() {}
-    virtual bool addVar(std::shared_ptr<Var> var) override ;
-    virtual bool addFunc(std::shared_ptr<Func> func) override ;
-    virtual std::shared_ptr<Func> getFunc(const std::string& ident) override ;
-    virtual std::shared_ptr<Var> getVar(const std::string& ident) override ;
-    std::shared_ptr<MainNode>& main_node() { return _main_node; }
-};
-
-/**
- * @brief Symbol table of certain block
- * 
- */
-class BlockSymbolTable : public SymbolTable {
-private:
+    bool contains(Ident ident);
     /**
-     * @brief Symbol table of block containing this block
-     * Outest is global symbol table
+     * @brief Add a variable to current block
      * 
+     * @param var 
+     * @return true 
+     * @return false Already declared in current block
      */
-    std::shared_ptr<SymbolTable> _base;
-public:
-    BlockSymbolTable(std::shared_ptr<SymbolTable> base) : _base(base) {}
-    std::shared_ptr<GlobalSymbolTable> getGlobal();
+    bool addVar(std::shared_ptr<Var> var);
     /**
-     * @brief Add a function to global symbol table
+     * @brief Add a function to global scope, whatever the current block is
      * 
      * @param func 
      * @return true 
-     * @return false 
+     * @return false Already declared in global scope
      */
-    virtual bool addFunc(std::shared_ptr<Func> func) override ;
+    bool addFunc(std::shared_ptr<Func> func);
     /**
-     * @brief Get function from global symbol table
+     * @brief Get innermost visible variable
      * 
      * @param ident 
-     * @return std::shared_ptr<Func> 
+     * @return std::shared_ptr<Var> 
      */
-    virtual std::shared_ptr<Func> getFunc(const std::string& ident) override ;
-    virtual bool addVar(std::shared_ptr<Var> var) override ;
+    std::shared_ptr<Var> getVar(Ident ident);
     /**
-     * @brief Try to search for variable from current table
-     * Recursively search outer tables, until global symbol table
+     * @brief Get function from global scope
      * 
      * @param ident 
-     * @return std::shared_ptr<Var> 
+     * @return std::shared_ptr<Func> 
+     */
+    std::shared_ptr<Func> getFunc(Ident ident);
+    /**
+     * @brief Global vars in order of declaration
+     * 
+     * @return std::vector<std::shared_ptr<Var>> 
      */
-    virtual std::shared_ptr<Var> getVar(const std::string& ident) override ;
+    std::vector<std::shared_ptr<Var>> getVars();
+    /**
+     * @brief Functions in order of declaration
+     * 
+     * @return std::vector<std::shared_ptr<Func>> 
+     */
+    std::vector<std::shared_ptr<Func>> getFuncs();
+    MainNode*& main_node() { return _main_node; }
 };
 
 }
@@ -0,0 +1,98 @@
+/**
+ * @file thread_pool.hpp
+ * @author fyvoid (fyvo1d@outlook.com)
+ * @brief Work stealing thread pool for blang
+ * @version 1.0
+ * @date 2024-12-20
+ * 
+ * @copyright Copyright (c) 2024
+ * 
+ */
+
+#ifndef BLANG_THREAD_POOL_H
+#define BLANG_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace blang {
+
+namespace tools {
+
+/**
+ * @brief Work stealing thread pool
+ * Every worker owns a task deque, it pops its own tasks from the back
+ * and steals from the front of other workers' deques when idle
+ * 
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Task type, receives index of the worker running it
+     * 
+     */
+    using Task = std::function<void(std::size_t)>;
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+    std::vector<std::unique_ptr<Queue>> _queues;
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _task_cv;
+    std::condition_variable _done_cv;
+    /**
+     * @brief Tasks submitted but not yet taken by a worker
+     * 
+     */
+    std::size_t _queued;
+    /**
+     * @brief Tasks submitted but not yet finished
+     * 
+     */
+    std::size_t _pending;
+    bool _stop;
+    std::atomic<std::size_t> _next_queue;
+    bool pop(std::size_t worker, Task& task);
+    bool steal(std::size_t worker, Task& task);
+    void run(std::size_t worker);
+public:
+    /**
+     * @brief Construct a new Thread Pool
+     * 
+     * @param workers Worker count, 0 for hardware concurrency
+     */
+    explicit ThreadPool(std::size_t workers=0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    std::size_t size() { return _threads.size(); }
+    /**
+     * @brief Submit a task
+     * Tasks submitted from a worker go to that worker's deque,
+     * others are distributed round robin
+     * Tasks must not throw
+     * 
+     * @param task
+     */
+    void submit(Task task);
+    /**
+     * @brief Block until every submitted task has finished
+     * 
+     */
+    void wait();
+};
+
+}
+
+}
+
+#endif
@@ -12,7 +12,10 @@
 #ifndef BLANG_TOKEN_H
 #define BLANG_TOKEN_H
 
-#include <string>
+#include <cstdint>
+#include <string_view>
+#include "ident.hpp"
+
 namespace blang {
 
 namespace frontend {
@@ -44,12 +47,19 @@ enum TokenType {
 
 /**
  * @brief Token struct wrapper
+ * value is a view into the source buffer (or a static literal),
+ * tokens must not outlive the buffer they were lexed from
  * 
  */
 struct Token {
     TokenType type;
-    std::string value;
+    std::string_view value;
     uint32_t line;
+    /**
+     * @brief Interned identifier, only set for IDENT tokens
+     * 
+     */
+    entities::Ident ident = {};
 };
 
 }
@@ -12,12 +12,12 @@
 #ifndef BLANG_TYPE_H
 #define BLANG_TYPE_H
 
+#include "ir_writer.hpp"
+#include <cstddef>
 #include <cstdint>
-#include <map>
 #include <memory>
 #include <stdexcept>
 #include <string>
-#include <tuple>
 #include <unordered_map>
 #include <vector>
 
@@ -25,6 +25,10 @@ namespace blang {
 
 namespace entities {
 
+class TypeContext;
+class Instruct;
+class Value;
+
 /**
  * @brief Type id enums
  * 
@@ -37,6 +41,7 @@ enum BlangType {
  * @brief Type base class
  * Types are designed with single instance pattern
  * Always use TypeT::get() function to get types, and use Type::is_same(t1, t2) to compare types
+ * Ptr and array types are interned in the TypeContext installed on the calling thread
  * 
  */
 class Type {
@@ -57,12 +62,22 @@ public:
         return t1 == t2;
     }
     virtual ~Type() = default;
+    /**
+     * @brief Print llvm ir style representation
+     * 
+     * @param out 
+     */
+    virtual void write(tools::IrWriter& out) = 0;
     /**
      * @brief Return llvm ir style string representation
      * 
      * @return std::string 
      */
-    virtual std::string to_string() = 0;
+    std::string to_string() {
+        tools::IrWriter out;
+        write(out);
+        return out.take();
+    }
 };
 
 /**
@@ -87,10 +102,10 @@ protected:
     IntType() : ValueType(TYPE_INT) {}
 public:
     static IntType* get() {
-        static IntType* instance = new IntType();
-        return instance;
+        static IntType instance{};
+        return &instance;
     }
-    virtual std::string to_string() { return "i32"; }
+    virtual void write(tools::IrWriter& out) { out << "i32"; }
 };
 
 /**
@@ -102,10 +117,10 @@ protected:
     CharType() : ValueType(TYPE_CHAR) {}
 public:
     static CharType* get() {
-        static CharType* instance = new CharType();
-        return instance;
+        static CharType instance{};
+        return &instance;
     }
-    virtual std::string to_string() { return "i8"; }
+    virtual void write(tools::IrWriter& out) { out << "i8"; }
 };
 
 /**
@@ -117,10 +132,10 @@ protected:
     BoolType() : ValueType(TYPE_BOOL) {}
 public:
     static BoolType* get() {
-        static BoolType* instance = new BoolType();
-        return instance;
+        static BoolType instance{};
+        return &instance;
     }
-    virtual std::string to_string() { return "i1"; }
+    virtual void write(tools::IrWriter& out) { out << "i1"; }
 };
 
 /**
@@ -132,10 +147,10 @@ protected:
     VoidType() : Type(TYPE_VOID) {}
 public:
     static VoidType* get() {
-        static VoidType* instance = new VoidType();
-        return instance;
+        static VoidType instance{};
+        return &instance;
     }
-    virtual std::string to_string() { return "void"; }
+    virtual void write(tools::IrWriter& out) { out << "void"; }
 };
 
 /**
@@ -150,25 +165,20 @@ protected:
             throw std::runtime_error("Ptr type cannot point to type void!");
         }
     }
+    friend class TypeContext;
 public:
     /**
-     * @brief 
+     * @brief Interned in the type context of current thread
      * 
      * @param type Pointed type
      * @return PtrType* 
      */
-    static PtrType* get(Type* type) {
-        static std::unordered_map<Type*, PtrType*> type_map{};
-        if (auto iter = type_map.find(type); iter != type_map.end()) {
-            return iter->second;
-        } else {
-            auto ptr_t = new PtrType(type);
-            type_map.insert({type, ptr_t});
-            return ptr_t;
-        }
-    } 
+    static PtrType* get(Type* type);
     Type* next() { return _next; }
-    virtual std::string to_string() { return _next->to_string() + "*"; }
+    virtual void write(tools::IrWriter& out) {
+        _next->write(out);
+        out << '*';
+    }
 };
 
 /**
@@ -184,44 +194,240 @@ protected:
             throw std::runtime_error("Array type cannot be void!");
         }
     }
+    friend class TypeContext;
 public:
     /**
-     * @brief 
+     * @brief Interned in the type context of current thread
      * 
      * @param type Array element type
      * @param length 
      * @return ArrayType* 
      */
-    static ArrayType* get(Type* type, uint32_t length) {
-        static std::map<std::tuple<Type*, uint32_t>, ArrayType*> type_map{};
-        auto key = std::make_tuple(type, length);
-        if (auto iter = type_map.find(key); iter != type_map.end()) {
-            return iter->second;
-        } else {
-            auto array_t = new ArrayType(type, length);
-            type_map.insert({key, array_t});
-            return array_t;
-        }
-    }
+    static ArrayType* get(Type* type, uint32_t length);
     Type* type() { return _type; }
     uint32_t length() { return _length; }
-    virtual std::string to_string() {
-        return "[" + std::to_string(_length) + " x " + _type->to_string() + "]";
+    virtual void write(tools::IrWriter& out) {
+        out << '[' << _length << " x ";
+        _type->write(out);
+        out << ']';
     }
 };
 
+/**
+ * @brief Owner of derived types of a compilation
+ * Ptr and array types are hash consed on (kind, element, length), so
+ * Type::is_same stays a pointer compare. Every compilation owns a context and
+ * installs it on its thread with TypeContext::Scope, TypeT::get() then
+ * interns into it without locking. Destroying or clearing a context frees its types
+ * 
+ */
+class TypeContext {
+private:
+    enum DerivedKind : uint32_t {
+        DERIVED_PTR, DERIVED_ARRAY,
+    };
+    struct Key {
+        DerivedKind kind;
+        Type* element;
+        uint32_t length;
+        bool operator==(const Key& other) const {
+            return kind == other.kind && element == other.element && length == other.length;
+        }
+    };
+    struct KeyHash {
+        std::size_t operator()(const Key& key) const {
+            auto hash = std::hash<Type*>()(key.element);
+            hash ^= (static_cast<std::size_t>(key.length) << 1 | key.kind) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+            return hash;
+        }
+    };
+    std::unordered_map<Key, std::unique_ptr<Type>, KeyHash> _types;
+    static thread_local TypeContext* _current;
+public:
+    TypeContext() = default;
+    TypeContext(const TypeContext&) = delete;
+    TypeContext& operator=(const TypeContext&) = delete;
+    /**
+     * @brief Get or create a ptr type
+     * 
+     * @param type Pointed type
+     * @return PtrType* Valid until the context is cleared
+     */
+    PtrType* ptr(Type* type);
+    /**
+     * @brief Get or create an array type
+     * 
+     * @param type Array element type
+     * @param length 
+     * @return ArrayType* Valid until the context is cleared
+     */
+    ArrayType* array(Type* type, uint32_t length);
+    /**
+     * @brief Number of derived types interned
+     * 
+     * @return std::size_t 
+     */
+    std::size_t size() { return _types.size(); }
+    /**
+     * @brief Free every derived type
+     * 
+     */
+    void clear() { _types.clear(); }
+    /**
+     * @brief Context installed on current thread
+     * 
+     * @return TypeContext* 
+     */
+    static TypeContext* current();
+    /**
+     * @brief Install a context on current thread for the lifetime of the scope,
+     * the previous one is restored on exit
+     * 
+     */
+    class Scope {
+    private:
+        TypeContext* _prev;
+    public:
+        Scope(TypeContext& context) : _prev(_current) { _current = &context; }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+        ~Scope() { _current = _prev; }
+    };
+};
+
+inline PtrType* PtrType::get(Type* type) {
+    return TypeContext::current()->ptr(type);
+}
+
+inline ArrayType* ArrayType::get(Type* type, uint32_t length) {
+    return TypeContext::current()->array(type, length);
+}
+
+/**
+ * @brief Operand slot of an instruction, an edge of the use-def graph
+ * Every use is linked into the use list of the value it holds, and unlinks
+ * itself when it is set to another value or destructed, so the list of a
+ * value is always exactly the instructions reading it
+ * 
+ */
+class Use {
+private:
+    std::shared_ptr<Value> _value;
+    Instruct* _user;
+    Use* _next;
+    Use** _prev;    // the pointer pointing to this use, head of list or _next of previous use
+    void link();
+    void unlink();
+    friend class Value;
+public:
+    Use() : _value(nullptr), _user(nullptr), _next(nullptr), _prev(nullptr) {}
+    Use(const Use&) = delete;
+    Use& operator=(const Use&) = delete;
+    ~Use() { unlink(); }
+    /**
+     * @brief Bind slot to its instruction and first value, only called once
+     * 
+     * @param user 
+     * @param value may be nullptr
+     */
+    void init(Instruct* user, std::shared_ptr<Value> value);
+    /**
+     * @brief Change value held, moving this use to the use list of value
+     * 
+     * @param value may be nullptr
+     */
+    void set(std::shared_ptr<Value> value);
+    const std::shared_ptr<Value>& get() const { return _value; }
+    Value* operator->() const { return _value.get(); }
+    explicit operator bool() const { return _value != nullptr; }
+    /**
+     * @brief Instruction owning this slot
+     * 
+     * @return Instruct* 
+     */
+    Instruct* user() const { return _user; }
+    /**
+     * @brief Next use of the same value
+     * 
+     * @return Use* 
+     */
+    Use* next() const { return _next; }
+};
+
 /**
  * @brief Value used in llvm ir 
+ * Keeps the list of uses reading it, values are never copied since
+ * uses point back to them
  * 
  */
 class Value {
+private:
+    Use* _uses;
+    bool _shared;
+    friend class Use;
 protected:
     Type* _type;
-    Value(Type* type) : _type(type) {}
+    Value(Type* type) : _uses(nullptr), _shared(false), _type(type) {}
+    /**
+     * @brief Mark a module level value read by several functions, its use list
+     * is then changed under a lock so functions can be optimized in parallel.
+     * Walking the list or replacing its uses still needs the module to itself
+     * 
+     */
+    void markShared() { _shared = true; }
 public:
+    Value(const Value&) = delete;
+    Value& operator=(const Value&) = delete;
+    virtual ~Value() = default;
     Type* getType() { return _type; }
-    virtual std::string to_string() = 0;
-    virtual std::string ident() = 0;
+    /**
+     * @brief Print value with its type, like i32 %1
+     * 
+     * @param out 
+     */
+    virtual void write(tools::IrWriter& out) {
+        _type->write(out);
+        out << ' ';
+        writeIdent(out);
+    }
+    /**
+     * @brief Print value alone, like %1
+     * 
+     * @param out 
+     */
+    virtual void writeIdent(tools::IrWriter& out) = 0;
+    std::string to_string() {
+        tools::IrWriter out;
+        write(out);
+        return out.take();
+    }
+    std::string ident() {
+        tools::IrWriter out;
+        writeIdent(out);
+        return out.take();
+    }
+    /**
+     * @brief Rename a register value, used when numbering registers of a function
+     * 
+     * @param ident 
+     */
+    virtual void setIdent(std::string ident) {
+        throw std::runtime_error("Value " + this->ident() + " cannot be renamed!");
+    }
+    /**
+     * @brief First use of this value, walk the rest with Use::next()
+     * 
+     * @return Use* nullptr if unused
+     */
+    Use* uses() { return _uses; }
+    bool used() { return _uses != nullptr; }
+    std::size_t numUses();
+    /**
+     * @brief Make every use of this value hold with instead, O(1) per use
+     * 
+     * @param with 
+     */
+    void replaceAllUsesWith(std::shared_ptr<Value> with);
 };
 
 /**
@@ -233,8 +439,8 @@ private:
     int32_t _content;
 public:
     IntConstValue(int32_t content) : Value(IntType::get()), _content(content) {}
-    virtual std::string to_string() { return "i32 " + std::to_string(_content); }
-    virtual std::string ident() { return std::to_string(_content); }
+    int32_t value() { return _content; }
+    virtual void writeIdent(tools::IrWriter& out) { out << _content; }
 };
 
 /**
@@ -246,8 +452,8 @@ private:
     char _content;
 public:
     CharConstValue(char content) : Value(CharType::get()), _content(content) {}
-    virtual std::string to_string() { return "i8 " + std::to_string(static_cast<int32_t>(_content)); }
-    virtual std::string ident() { return std::to_string(_content); }    
+    char value() { return _content; }
+    virtual void writeIdent(tools::IrWriter& out) { out << static_cast<int32_t>(_content); }
 };
 
 /**
@@ -259,8 +465,8 @@ private:
     bool _content;
 public:
     BoolConstValue(bool content) : Value(BoolType::get()), _content(content) {}
-    virtual std::string to_string() { return "i1 " + std::to_string(static_cast<int32_t>(_content)); }
-    virtual std::string ident() { return std::to_string(_content); }
+    bool value() { return _content; }
+    virtual void writeIdent(tools::IrWriter& out) { out << static_cast<int32_t>(_content); }
 };
 
 /**
@@ -269,24 +475,32 @@ public:
  */
 class ArrayValue : public Value {
 private:
+    /**
+     * @brief Leading elements, the rest up to length of type are zero
+     * 
+     */
     std::vector<std::shared_ptr<Value>> _content;
 public:
     ArrayValue(Type* type, std::vector<std::shared_ptr<Value>> content) : Value(type), _content(content) {}
-    virtual std::string to_string() {
-        std::string ret = getType()->to_string() + " [";
-        for (int i = 0; i < _content.size() - 1; i++) {
-            ret += _content[i]->to_string() + ", ";
+    virtual void writeIdent(tools::IrWriter& out) {
+        if (_content.empty()) {
+            out << "zeroinitializer";
+            return ;
         }
-        ret += _content[_content.size() - 1]->to_string() + "]";
-        return ret;
-    }
-    virtual std::string ident() {
-        std::string ret = "[";
-        for (int i = 0; i < _content.size() - 1; i++) {
-            ret += _content[i]->to_string() + ", ";
+        auto array_t = static_cast<ArrayType*>(getType());
+        out << '[';
+        for (std::size_t i = 0; i < array_t->length(); i++) {
+            if (i > 0) {
+                out << ", ";
+            }
+            if (i < _content.size()) {
+                _content[i]->write(out);
+            } else {
+                array_t->type()->write(out);
+                out << " 0";
+            }
         }
-        ret += _content[_content.size() - 1]->to_string() + "]";
-        return ret;
+        out << ']';
     }
 };
 
@@ -299,8 +513,8 @@ private:
     std::string _ident;
 public:
     IntValue(std::string ident) : Value(IntType::get()), _ident(ident) {}
-    virtual std::string to_string() { return "i32 %" + _ident; }
-    virtual std::string ident() { return "%" + _ident; }
+    virtual void writeIdent(tools::IrWriter& out) { out << '%' << _ident; }
+    virtual void setIdent(std::string ident) { _ident = ident; }
 };
 
 /**
@@ -312,8 +526,8 @@ private:
     std::string _ident;
 public:
     CharValue(std::string ident) : Value(CharType::get()), _ident(ident) {}
-    virtual std::string to_string() { return "i8 %" + _ident; }
-    virtual std::string ident() { return "%" + _ident; }
+    virtual void writeIdent(tools::IrWriter& out) { out << '%' << _ident; }
+    virtual void setIdent(std::string ident) { _ident = ident; }
 };
 
 /**
@@ -325,8 +539,8 @@ private:
     std::string _ident;
 public:
     BoolValue(std::string ident) : Value(BoolType::get()), _ident(ident) {}
-    virtual std::string to_string() { return "i1 %" + _ident; }
-    virtual std::string ident() { return "%" + _ident; }
+    virtual void writeIdent(tools::IrWriter& out) { out << '%' << _ident; }
+    virtual void setIdent(std::string ident) { _ident = ident; }
 };
 
 /**
@@ -338,13 +552,23 @@ private:
     bool _global;
     std::string _ident;
 public:
-    PtrValue(Type* type, bool global, std::string ident) : Value(type), _global(global), _ident(ident) {}
-    std::string flag() { return _global ? "@" : "%"; }
-    virtual std::string to_string() { return getType()->to_string() + "* " + flag() + _ident; }
-    virtual std::string ident() {
-        return flag() + _ident; 
+    PtrValue(Type* type, bool global, std::string ident) : Value(type), _global(global), _ident(ident) {
+        if (global) {
+            markShared();
+        }
+    }
+    /**
+     * @brief Print pointer with its type, like i32* %1, type of a ptr value is the pointed type
+     * 
+     * @param out 
+     */
+    virtual void write(tools::IrWriter& out) {
+        getType()->write(out);
+        out << "* ";
+        writeIdent(out);
     }
-    std::string def() { return flag() + _ident; }
+    virtual void writeIdent(tools::IrWriter& out) { out << (_global ? '@' : '%') << _ident; }
+    virtual void setIdent(std::string ident) { _ident = ident; }
 };
 
 }
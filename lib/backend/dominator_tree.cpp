@@ -0,0 +1,118 @@
+#include "dominator_tree.hpp"
+#include <stdexcept>
+#include <utility>
+
+namespace blang {
+namespace backend {
+
+DominatorTree::DominatorTree(Function& function) {
+    if (function.blocks().empty()) {
+        return ;
+    }
+
+    // post order by an explicit dfs, deep nesting must not overflow the stack
+    auto entry = function.blocks().front().get();
+    std::vector<Block*> post{};
+    std::vector<std::pair<Block*, std::size_t>> stack{{entry, 0}};
+    _index.emplace(entry, NONE);
+    while (!stack.empty()) {
+        auto& [block, next] = stack.back();
+        if (next < block->succs().size()) {
+            auto succ = block->succs()[next++];
+            if (_index.emplace(succ, NONE).second) {
+                stack.push_back({succ, 0});
+            }
+            continue;
+        }
+        post.push_back(block);
+        stack.pop_back();
+    }
+    _order.assign(post.rbegin(), post.rend());
+    for (uint32_t i = 0; i < _order.size(); i++) {
+        _index[_order[i]] = i;
+    }
+
+    // idoms in rpo numbers, a block is processed once one of its preds has an idom
+    _idom.assign(_order.size(), NONE);
+    _idom[0] = 0;
+    auto intersect = [this](uint32_t a, uint32_t b) {
+        while (a != b) {
+            while (a > b) {
+                a = _idom[a];
+            }
+            while (b > a) {
+                b = _idom[b];
+            }
+        }
+        return a;
+    };
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (uint32_t i = 1; i < _order.size(); i++) {
+            auto new_idom = NONE;
+            for (auto pred : _order[i]->preds()) {
+                auto iter = _index.find(pred);
+                if (iter == _index.end() || _idom[iter->second] == NONE) {
+                    continue;
+                }
+                new_idom = new_idom == NONE ? iter->second : intersect(iter->second, new_idom);
+            }
+            if (new_idom != _idom[i]) {
+                _idom[i] = new_idom;
+                changed = true;
+            }
+        }
+    }
+
+    _children.assign(_order.size(), {});
+    for (uint32_t i = 1; i < _order.size(); i++) {
+        _children[_idom[i]].push_back(_order[i]);
+    }
+
+    _frontier.assign(_order.size(), {});
+    for (uint32_t i = 0; i < _order.size(); i++) {
+        auto& preds = _order[i]->preds();
+        if (preds.size() < 2) {
+            continue;
+        }
+        for (auto pred : preds) {
+            auto iter = _index.find(pred);
+            if (iter == _index.end()) {
+                continue;
+            }
+            for (auto runner = iter->second; runner != _idom[i]; runner = _idom[runner]) {
+                auto& frontier = _frontier[runner];
+                if (frontier.empty() || frontier.back() != _order[i]) {
+                    frontier.push_back(_order[i]);
+                }
+            }
+        }
+    }
+}
+
+uint32_t DominatorTree::index(Block* block) const {
+    auto iter = _index.find(block);
+    if (iter == _index.end()) {
+        throw std::runtime_error("Block " + block->label() + " is unreachable!");
+    }
+    return iter->second;
+}
+
+Block* DominatorTree::idom(Block* block) const {
+    auto i = index(block);
+    return i == 0 ? nullptr : _order[_idom[i]];
+}
+
+bool DominatorTree::dominates(Block* a, Block* b) const {
+    auto ia = index(a);
+    auto ib = index(b);
+    // a dominator always comes first in rpo
+    while (ib > ia) {
+        ib = _idom[ib];
+    }
+    return ia == ib;
+}
+
+}
+}
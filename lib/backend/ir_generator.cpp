@@ -12,13 +12,13 @@
 namespace blang {
 namespace backend {
 
-IrGenerator::IrGenerator(std::shared_ptr<Logger> logger) {
+IrGenerator::IrGenerator(std::shared_ptr<Logger> logger, std::shared_ptr<tools::Arena> arena) {
     _logger = logger;
+    _arena = arena;
 }
 
-std::shared_ptr<IrModule> IrGenerator::gen(std::shared_ptr<GlobalSymbolTable> checked_table) {
-    _global_table = checked_table;
-    _current_table = checked_table;
+std::shared_ptr<IrModule> IrGenerator::gen(std::shared_ptr<SymbolTable> checked_table) {
+    _table = checked_table;
 
     _module = std::make_shared<IrModule>();
     _factory = std::make_shared<IrFactory>(_module);
@@ -31,31 +31,29 @@ std::shared_ptr<IrModule> IrGenerator::gen(std::shared_ptr<GlobalSymbolTable> ch
 }
 
 void IrGenerator::setGlobalVar() {
-    for (auto& var : _global_table->getVars()) {
+    for (auto& var : _table->getVars()) {
         auto type = var->type();
         std::shared_ptr<Value> value;
         std::shared_ptr<PtrValue> ptr;
-        auto ident = var->ident();
+        auto ident = var->ident().str();
         if (Type::is_same(type, IntType::get())) {
-            value = std::make_shared<IntConstValue>(*(var->get<int32_t>()));
+            value = std::make_shared<IntConstValue>(var->at<int32_t>(0));
             ptr = std::make_shared<PtrValue>(var->type(), true, ident);
         } else if (Type::is_same(type, CharType::get())) {
-            value = std::make_shared<CharConstValue>(*(var->get<char>()));
+            value = std::make_shared<CharConstValue>(var->at<char>(0));
             ptr = std::make_shared<PtrValue>(var->type(), true, ident);
         } else if (auto array_t = dynamic_cast<ArrayType*>(type); array_t) {
             if (Type::is_same(array_t->type(), IntType::get())) {
                 std::vector<std::shared_ptr<Value>> vec{};
-                auto array = var->get<int32_t>();
-                for (size_t i = 0; i < array_t->length(); i++) {
-                    vec.push_back(std::make_shared<IntConstValue>(array[i]));
+                for (auto element : var->content<int32_t>()) {
+                    vec.push_back(std::make_shared<IntConstValue>(element));
                 }
                 value = std::make_shared<ArrayValue>(array_t, vec);
                 ptr = std::make_shared<PtrValue>(var->type(), true, ident);
             } else if (Type::is_same(array_t->type(), CharType::get())) {
                 std::vector<std::shared_ptr<Value>> vec{};
-                auto array = var->get<char>();
-                for (size_t i = 0; i < array_t->length(); i++) {
-                    vec.push_back(std::make_shared<CharConstValue>(array[i]));
+                for (auto element : var->content<char>()) {
+                    vec.push_back(std::make_shared<CharConstValue>(element));
                 }
                 value = std::make_shared<ArrayValue>(array_t, vec);
                 ptr = std::make_shared<PtrValue>(var->type(), true, ident);
@@ -68,19 +66,39 @@ void IrGenerator::setGlobalVar() {
 }
 
 void IrGenerator::setFunction() {
-    for (auto& func : _global_table->getFuncs()) {
-        _factory->addFunction(func->return_type(), func->ident(), func->params());
+    for (auto& func : _table->getFuncs()) {
+        std::vector<std::tuple<Type*, std::string>> params{};
+        for (auto& [type, ident] : func->params()) {
+            params.push_back({type, ident.str()});
+        }
+        _factory->addFunction(func->return_type(), func->ident().str(), params);
         func->function() = _module->current_function();
         func->node()->accept(*this);
     }
 }
 
 void IrGenerator::setMain() {
-    auto main = _global_table->main_node();
+    auto main = _table->main_node();
     _factory->addFunction(IntType::get(), "main", {});
     main->accept(*this);
 }
 
+bool IrGenerator::genFolded(ExpNode& node, Type* type) {
+    auto folded = _evaluator.evaluate(node, _table);
+    if (!folded) {
+        return false;
+    }
+
+    if (Type::is_same(type, BoolType::get())) {
+        auto result = std::make_shared<BoolValue>(_factory->next_reg());
+        _factory->addAddInstruct(result, std::make_shared<BoolConstValue>(*folded), std::make_shared<BoolConstValue>(0));
+    } else {
+        auto result = std::make_shared<IntValue>(_factory->next_reg());
+        _factory->addAddInstruct(result, std::make_shared<IntConstValue>(*folded), std::make_shared<IntConstValue>(0));
+    }
+    return true;
+}
+
 void IrGenerator::visit(CompNode& node) {}
 
 void IrGenerator::visit(DeclNode& node) {
@@ -91,36 +109,32 @@ void IrGenerator::visit(DeclNode& node) {
         std::shared_ptr<Var> var;
         std::shared_ptr<Value> init;
         if (def->array_exp()) {
-            auto length = evaluate(*def->array_exp(), _current_table);
+            auto length = evaluate(*def->array_exp(), _table);
             if (Type::is_same(decl_type, IntType::get())) {
                 var = Var::getIntArray(def->ident(), def->is_const(), length);
                 if (def->is_const()) {
-                    auto init_val = getInitVal<int32_t>(*def->init_val());
-                    memcpy(var->get<int32_t>(), init_val.data(), sizeof(int32_t) * std::min(length, static_cast<int32_t>(init_val.size())));
+                    var->init<int32_t>(*_arena, getInitVal<int32_t>(*def->init_val()), std::max(length, 0));
                 }
             } else if (Type::is_same(decl_type, CharType::get())) {
                 var = Var::getCharArray(def->ident(), def->is_const(), length);
                 if (def->is_const()) {
-                    auto init_val = getInitVal<char>(*def->init_val());
-                    memcpy(var->get<char>(), init_val.data(), sizeof(char) * std::min(length, static_cast<int32_t>(init_val.size())));
+                    var->init<char>(*_arena, getInitVal<char>(*def->init_val()), std::max(length, 0));
                 }
             }
         } else {
             if (Type::is_same(decl_type, IntType::get())) {
                 var = Var::getInt(def->ident(), def->is_const());
                 if (def->is_const()) {
-                    auto init_val = getInitVal<int32_t>(*def->init_val());
-                    memcpy(var->get<int32_t>(), init_val.data(), sizeof(int32_t));
+                    var->init<int32_t>(*_arena, getInitVal<int32_t>(*def->init_val()), 1);
                 }
             } else if (Type::is_same(decl_type, CharType::get())) {
                 var = Var::getChar(def->ident(), def->is_const());
                 if (def->is_const()) {
-                    auto init_val = getInitVal<char>(*def->init_val());
-                    memcpy(var->get<char>(), init_val.data(), sizeof(char));
+                    var->init<char>(*_arena, getInitVal<char>(*def->init_val()), 1);
                 }
             }
         }
-        _current_table->addVar(var);
+        _table->addVar(var);
 
         // add instruction
         std::shared_ptr<PtrValue> ptr;
@@ -131,21 +145,7 @@ void IrGenerator::visit(DeclNode& node) {
         } else if (Type::is_same(type, CharType::get())) {
             ptr = std::make_shared<PtrValue>(var->type(), false, ident);
         } else if (auto array_t = dynamic_cast<ArrayType*>(type); array_t) {
-            if (Type::is_same(array_t->type(), IntType::get())) {
-                std::vector<std::shared_ptr<Value>> vec{};
-                auto array = var->get<int32_t>();
-                for (size_t i = 0; i < array_t->length(); i++) {
-                    vec.push_back(std::make_shared<IntConstValue>(array[i]));
-                }
-                ptr = std::make_shared<PtrValue>(var->type(), false, ident);
-            } else if (Type::is_same(array_t->type(), CharType::get())) {
-                std::vector<std::shared_ptr<Value>> vec{};
-                auto array = var->get<char>();
-                for (size_t i = 0; i < array_t->length(); i++) {
-                    vec.push_back(std::make_shared<CharConstValue>(array[i]));
-                }
-                ptr = std::make_shared<PtrValue>(var->type(), false, ident);
-            }
+            ptr = std::make_shared<PtrValue>(var->type(), false, ident);
         }
 
         var->value() = ptr;
@@ -154,20 +154,20 @@ void IrGenerator::visit(DeclNode& node) {
         if (def->init_val()) {
             if (Type::is_same(type, IntType::get())) {
                 def->init_val()->exp()->accept(*this);
-                auto result = _module->current_block()->last()->reg();
+                auto result = _factory->last();
                 if (Type::is_same(result->getType(), CharType::get())) {
                     auto tmp = std::make_shared<IntValue>(_factory->next_reg());
                     _factory->addSextInstruct(tmp, result);
-                    result = tmp;
+                    result = _factory->last();
                 }
                 _factory->addStoreInstruct(result, ptr);
             } else if (Type::is_same(type, CharType::get())) {
                 def->init_val()->exp()->accept(*this);
-                auto result = _module->current_block()->last()->reg();
+                auto result = _factory->last();
                 if (Type::is_same(result->getType(), IntType::get())) {
                     auto reg = std::make_shared<CharValue>(_factory->next_reg());
                     _factory->addTruncInstruct(reg, result);
-                    result = reg;
+                    result = _factory->last();
                 }
                 _factory->addStoreInstruct(result, ptr);
             } else if (auto array_t = dynamic_cast<ArrayType*>(type); array_t) {
@@ -175,11 +175,11 @@ void IrGenerator::visit(DeclNode& node) {
                     int iter = 0;
                     for (auto& exp : def->init_val()->exps()) {
                         exp->accept(*this);
-                        auto result = _module->current_block()->last()->reg();
+                        auto result = _factory->last();
                         if (Type::is_same(result->getType(), CharType::get())) {
                             auto tmp = std::make_shared<IntValue>(_factory->next_reg());
                             _factory->addSextInstruct(tmp, result);
-                            result = tmp;
+                            result = _factory->last();
                         }
                         auto gep_ptr = std::make_shared<PtrValue>(array_t->type(), false, _factory->next_reg());
                         auto elem = std::make_shared<IntConstValue>(0);
@@ -193,11 +193,11 @@ void IrGenerator::visit(DeclNode& node) {
                         int iter = 0;
                         for (auto& exp : def->init_val()->exps()) {
                             exp->accept(*this);
-                            auto result = _module->current_block()->last()->reg();
+                            auto result = _factory->last();
                             if (Type::is_same(result->getType(), IntType::get())) {
                                 auto tmp = std::make_shared<CharValue>(_factory->next_reg());
                                 _factory->addTruncInstruct(tmp, result);
-                                result = tmp;
+                                result = _factory->last();
                             }
                             auto gep_ptr = std::make_shared<PtrValue>(array_t->type(), false, _factory->next_reg());
                             auto elem = std::make_shared<IntConstValue>(0);
@@ -230,11 +230,14 @@ void IrGenerator::visit(InitValNode& node) {}
 
 void IrGenerator::visit(UnaryExpNode& node) {
     std::shared_ptr<Value> result;
+    if (node.unary_exp() && node.op() == entities::OP_NOT && genFolded(node, BoolType::get())) {
+        return ;
+    }
     if (node.unary_exp()) {
         node.unary_exp()->accept(*this);
         switch (node.op()) {
             case entities::OP_NOT: {
-                auto reg = _module->current_block()->last()->reg();
+                auto reg = _factory->last();
                 if (!Type::is_same(reg->getType(), BoolType::get())) {
                     auto tmp = std::make_shared<BoolValue>(_factory->next_reg());
                     if (Type::is_same(reg->getType(), IntType::get())) {
@@ -242,14 +245,14 @@ void IrGenerator::visit(UnaryExpNode& node) {
                     } else if (Type::is_same(reg->getType(), CharType::get())) {
                         _factory->addNeqInstruct(tmp, reg, std::make_shared<CharConstValue>(0));
                     }
-                    reg = tmp;
+                    reg = _factory->last();
                 }
                 result = std::make_shared<BoolValue>(_factory->next_reg());
                 _factory->addEqInstruct(result, reg, std::make_shared<BoolConstValue>(0));
             }
             break;
             case entities::OP_MINUS: {
-                auto reg = _module->current_block()->last()->reg();
+                auto reg = _factory->last();
                 std::shared_ptr<Value> from;
                 if (Type::is_same(reg->getType(), IntType::get())) {
                     result = std::make_shared<IntValue>(_factory->next_reg());
@@ -268,9 +271,9 @@ void IrGenerator::visit(UnaryExpNode& node) {
         }
     } else if (node.primary_exp()) {
         node.primary_exp()->accept(*this);
-        result = _module->current_block()->last()->reg();
+        result = _factory->last();
     } else if (!node.ident().empty()) {
-        auto func = _current_table->getFunc(node.ident());
+        auto func = _table->getFunc(node.ident());
         auto func_params = func->params();
         std::vector<std::shared_ptr<Value>> params{};
         if (node.func_rparams()) {
@@ -278,16 +281,16 @@ void IrGenerator::visit(UnaryExpNode& node) {
             for (auto& param : node.func_rparams()->nodes()) {
                 param->accept(*this);
                 auto [type, ident] = func_params.at(iter);
-                auto result = _module->current_block()->last()->reg();
+                auto result = _factory->last();
                 if (!Type::is_same(result->getType(), type)) {
                     if (Type::is_same(type, IntType::get())) {
                         auto tmp = std::make_shared<IntValue>(_factory->next_reg());
                         _factory->addSextInstruct(tmp, result);
-                        result = tmp;
+                        result = _factory->last();
                     } else if (Type::is_same(type, CharType::get())) {
                         auto tmp = std::make_shared<CharValue>(_factory->next_reg());
                         _factory->addTruncInstruct(tmp, result);
-                        result = tmp;
+                        result = _factory->last();
                     }
                 }
                 params.push_back(result);
@@ -310,6 +313,12 @@ void IrGenerator::visit(UnaryExpNode& node) {
 }
 
 void IrGenerator::visit(BinaryExpNode& node) {
+    auto arith = node.op() == entities::OP_ADD || node.op() == entities::OP_MINUS || node.op() == entities::OP_MUL
+              || node.op() == entities::OP_DIV || node.op() == entities::OP_MOD;
+    if (genFolded(node, arith ? static_cast<Type*>(IntType::get()) : BoolType::get())) {
+        return ;
+    }
+
     auto result_bw = 0;
     switch (node.op()) {
         case entities::OP_ADD:
@@ -327,54 +336,60 @@ void IrGenerator::visit(BinaryExpNode& node) {
             break;
         case entities::OP_AND: {
             auto andn = _factory->next_block();
-            _factory->addBrInstruct("and_entry" + andn);
-
-            _module->current_function()->addBlock("and_entry" + andn);
+            auto and_entry = _module->current_function()->newBlock("and_entry" + andn);
+            auto and_left = _module->current_function()->newBlock("and_left" + andn);
+            auto and_right = _module->current_function()->newBlock("and_right" + andn);
+            auto and_true = _module->current_function()->newBlock("and_true" + andn);
+            auto and_false = _module->current_function()->newBlock("and_false" + andn);
+            auto and_end = _module->current_function()->newBlock("and_end" + andn);
+            _factory->addBrInstruct(and_entry);
+
+            _module->current_function()->addBlock(and_entry);
             auto alloca = std::make_shared<PtrValue>(BoolType::get(), false, _factory->next_reg());
             _factory->addAllocaInstruct(alloca);
-            _factory->addBrInstruct("and_left" + andn);
+            _factory->addBrInstruct(and_left);
 
-            _module->current_function()->addBlock("and_left" + andn);
+            _module->current_function()->addBlock(and_left);
             node.left()->accept(*this);
-            auto reg = _module->current_block()->last()->reg();
+            auto reg = _factory->last();
             if (Type::is_same(reg->getType(), IntType::get())) {
                 auto result = std::make_shared<BoolValue>(_factory->next_reg());
                 _factory->addNeqInstruct(result, reg, std::make_shared<IntConstValue>(0));
-                reg = result;
+                reg = _factory->last();
             } else if (Type::is_same(reg->getType(), CharType::get())) {
                 auto result = std::make_shared<BoolValue>(_factory->next_reg());
                 _factory->addNeqInstruct(result, reg, std::make_shared<CharConstValue>(0));
-                reg = result;
+                reg = _factory->last();
             }
-            _factory->addCondBrInstruct(reg, "and_right" + andn, "and_false" + andn);
+            _factory->addCondBrInstruct(reg, and_right, and_false);
 
-            _module->current_function()->addBlock("and_right" + andn);
+            _module->current_function()->addBlock(and_right);
             node.right()->accept(*this);
-            reg = _module->current_block()->last()->reg();
+            reg = _factory->last();
             if (Type::is_same(reg->getType(), IntType::get())) {
                 auto result = std::make_shared<BoolValue>(_factory->next_reg());
                 _factory->addNeqInstruct(result, reg, std::make_shared<IntConstValue>(0));
-                reg = result;
+                reg = _factory->last();
             } else if (Type::is_same(reg->getType(), CharType::get())) {
                 auto result = std::make_shared<BoolValue>(_factory->next_reg());
                 _factory->addNeqInstruct(result, reg, std::make_shared<CharConstValue>(0));
-                reg = result;
+                reg = _factory->last();
             }
-            _factory->addCondBrInstruct(reg, "and_true" + andn, "and_false" + andn);
+            _factory->addCondBrInstruct(reg, and_true, and_false);
 
-            _module->current_function()->addBlock("and_true" + andn);
+            _module->current_function()->addBlock(and_true);
             auto result = std::make_shared<BoolValue>(_factory->next_reg());
             _factory->addAddInstruct(result, std::make_shared<BoolConstValue>(1), std::make_shared<BoolConstValue>(0));
-            _factory->addStoreInstruct(result, alloca);
-            _factory->addBrInstruct("and_end" + andn);
+            _factory->addStoreInstruct(_factory->last(), alloca);
+            _factory->addBrInstruct(and_end);
 
-            _module->current_function()->addBlock("and_false" + andn);
+            _module->current_function()->addBlock(and_false);
             result = std::make_shared<BoolValue>(_factory->next_reg());
             _factory->addAddInstruct(result, std::make_shared<BoolConstValue>(0), std::make_shared<BoolConstValue>(0));
-            _factory->addStoreInstruct(result, alloca);
-            _factory->addBrInstruct("and_end" + andn);
+            _factory->addStoreInstruct(_factory->last(), alloca);
+            _factory->addBrInstruct(and_end);
 
-            _module->current_function()->addBlock("and_end" + andn);
+            _module->current_function()->addBlock(and_end);
             result = std::make_shared<BoolValue>(_factory->next_reg());
             _factory->addLoadInstruct(alloca, result);
             return ;
@@ -382,54 +397,60 @@ void IrGenerator::visit(BinaryExpNode& node) {
         break;
         case entities::OP_OR: {
             auto orn = _factory->next_block();
-            _factory->addBrInstruct("or_entry" + orn);
-
-            _module->current_function()->addBlock("or_entry" + orn);
+            auto or_entry = _module->current_function()->newBlock("or_entry" + orn);
+            auto or_left = _module->current_function()->newBlock("or_left" + orn);
+            auto or_right = _module->current_function()->newBlock("or_right" + orn);
+            auto or_true = _module->current_function()->newBlock("or_true" + orn);
+            auto or_false = _module->current_function()->newBlock("or_false" + orn);
+            auto or_end = _module->current_function()->newBlock("or_end" + orn);
+            _factory->addBrInstruct(or_entry);
+
+            _module->current_function()->addBlock(or_entry);
             auto alloca = std::make_shared<PtrValue>(BoolType::get(), false, _factory->next_reg());
             _factory->addAllocaInstruct(alloca);
-            _factory->addBrInstruct("or_left" + orn);
+            _factory->addBrInstruct(or_left);
 
-            _module->current_function()->addBlock("or_left" + orn);
+            _module->current_function()->addBlock(or_left);
             node.left()->accept(*this);
-            auto reg = _module->current_block()->last()->reg();
+            auto reg = _factory->last();
             if (Type::is_same(reg->getType(), IntType::get())) {
                 auto result = std::make_shared<BoolValue>(_factory->next_reg());
                 _factory->addNeqInstruct(result, reg, std::make_shared<IntConstValue>(0));
-                reg = result;
+                reg = _factory->last();
             } else if (Type::is_same(reg->getType(), CharType::get())) {
                 auto result = std::make_shared<BoolValue>(_factory->next_reg());
                 _factory->addNeqInstruct(result, reg, std::make_shared<CharConstValue>(0));
-                reg = result;
+                reg = _factory->last();
             }
-            _factory->addCondBrInstruct(reg, "or_true" + orn, "or_right" + orn);
+            _factory->addCondBrInstruct(reg, or_true, or_right);
 
-            _module->current_function()->addBlock("or_right" + orn);
+            _module->current_function()->addBlock(or_right);
             node.right()->accept(*this);
-            reg = _module->current_block()->last()->reg();
+            reg = _factory->last();
             if (Type::is_same(reg->getType(), IntType::get())) {
                 auto result = std::make_shared<BoolValue>(_factory->next_reg());
                 _factory->addNeqInstruct(result, reg, std::make_shared<IntConstValue>(0));
-                reg = result;
+                reg = _factory->last();
             } else if (Type::is_same(reg->getType(), CharType::get())) {
                 auto result = std::make_shared<BoolValue>(_factory->next_reg());
                 _factory->addNeqInstruct(result, reg, std::make_shared<CharConstValue>(0));
-                reg = result;
+                reg = _factory->last();
             }
-            _factory->addCondBrInstruct(reg, "or_true" + orn, "or_false" + orn);
+            _factory->addCondBrInstruct(reg, or_true, or_false);
 
-            _module->current_function()->addBlock("or_true" + orn);
+            _module->current_function()->addBlock(or_true);
             auto result = std::make_shared<BoolValue>(_factory->next_reg());
             _factory->addAddInstruct(result, std::make_shared<BoolConstValue>(1), std::make_shared<BoolConstValue>(0));
-            _factory->addStoreInstruct(result, alloca);
-            _factory->addBrInstruct("or_end" + orn);
+            _factory->addStoreInstruct(_factory->last(), alloca);
+            _factory->addBrInstruct(or_end);
 
-            _module->current_function()->addBlock("or_false" + orn);
+            _module->current_function()->addBlock(or_false);
             result = std::make_shared<BoolValue>(_factory->next_reg());
             _factory->addAddInstruct(result, std::make_shared<BoolConstValue>(0), std::make_shared<BoolConstValue>(0));
-            _factory->addStoreInstruct(result, alloca);
-            _factory->addBrInstruct("or_end" + orn);
+            _factory->addStoreInstruct(_factory->last(), alloca);
+            _factory->addBrInstruct(or_end);
 
-            _module->current_function()->addBlock("or_end" + orn);
+            _module->current_function()->addBlock(or_end);
             result = std::make_shared<BoolValue>(_factory->next_reg());
             _factory->addLoadInstruct(alloca, result);
             return ;
@@ -440,50 +461,50 @@ void IrGenerator::visit(BinaryExpNode& node) {
     }
 
     node.left()->accept(*this);
-    auto left = _module->current_block()->last()->reg();
+    auto left = _factory->last();
     if (result_bw == 32) {
         if (Type::is_same(left->getType(), CharType::get())) {
             auto reg = std::make_shared<IntValue>(_factory->next_reg());
             _factory->addSextInstruct(reg, left);
-            left = _module->current_block()->last()->reg();
+            left = _factory->last();
         } else if (Type::is_same(left->getType(), BoolType::get())) {
             auto reg = std::make_shared<IntValue>(_factory->next_reg());
             _factory->addZextInstruct(reg, left);
-            left = _module->current_block()->last()->reg();
+            left = _factory->last();
         }
     } else if (result_bw == 1) {
         if (Type::is_same(left->getType(), IntType::get())) {
             auto reg = std::make_shared<BoolValue>(_factory->next_reg());
             _factory->addNeqInstruct(reg, left, std::make_shared<IntConstValue>(0));
-            left = _module->current_block()->last()->reg();
+            left = _factory->last();
         } else if (Type::is_same(left->getType(), CharType::get())) {
             auto reg = std::make_shared<BoolValue>(_factory->next_reg());
             _factory->addNeqInstruct(reg, left, std::make_shared<CharConstValue>(0));
-            left = _module->current_block()->last()->reg();
+            left = _factory->last();
         }
     }
 
     node.right()->accept(*this);
-    auto right = _module->current_block()->last()->reg();
+    auto right = _factory->last();
     if (result_bw == 32) {
         if (Type::is_same(right->getType(), CharType::get())) {
             auto reg = std::make_shared<IntValue>(_factory->next_reg());
             _factory->addSextInstruct(reg, right);
-            right = _module->current_block()->last()->reg();
+            right = _factory->last();
         } else if (Type::is_same(right->getType(), BoolType::get())) {
             auto reg = std::make_shared<IntValue>(_factory->next_reg());
             _factory->addZextInstruct(reg, right);
-            right = _module->current_block()->last()->reg();
+            right = _factory->last();
         }
     } else if (result_bw == 1) {
         if (Type::is_same(right->getType(), IntType::get())) {
             auto reg = std::make_shared<BoolValue>(_factory->next_reg());
             _factory->addNeqInstruct(reg, right, std::make_shared<IntConstValue>(0));
-            right = _module->current_block()->last()->reg();
+            right = _factory->last();
         } else if (Type::is_same(right->getType(), CharType::get())) {
             auto reg = std::make_shared<BoolValue>(_factory->next_reg());
             _factory->addNeqInstruct(reg, right, std::make_shared<CharConstValue>(0));
-            right = _module->current_block()->last()->reg();
+            right = _factory->last();
         }
     }
     
@@ -560,14 +581,14 @@ void IrGenerator::visit(PrimaryExpNode& node) {
 
 // load value of this node to a temp register
 void IrGenerator::visit(LValNode& node) {
-    auto var = _current_table->getVar(node.ident());
+    auto var = _table->getVar(node.ident());
     Type* type;
     std::shared_ptr<Value> value;
     if (auto array_t = dynamic_cast<ArrayType*>(var->type()); array_t) {
         std::shared_ptr<Value> offset;
         if (node.exp()) {
             node.exp()->accept(*this);
-            offset = _module->current_block()->last()->reg();
+            offset = _factory->last();
         } else {
             offset = std::make_shared<IntConstValue>(0);
         }
@@ -583,7 +604,7 @@ void IrGenerator::visit(LValNode& node) {
         std::shared_ptr<Value> offset;
         if (node.exp()) {
             node.exp()->accept(*this);
-            offset = _module->current_block()->last()->reg();
+            offset = _factory->last();
         } else {
             offset = std::make_shared<IntConstValue>(0);
         }
@@ -619,8 +640,7 @@ void IrGenerator::visit(ValueNode& node) {
 }
 
 void IrGenerator::visit(FuncDefNode& node) {
-    auto tmp = _current_table;
-    _current_table = std::make_shared<BlockSymbolTable>(_current_table);
+    _table->pushScope();
     if (node.params()) {
         node.params()->accept(*this);
     }
@@ -628,14 +648,13 @@ void IrGenerator::visit(FuncDefNode& node) {
     if (Type::is_same(node.type(), VoidType::get())) {
         _factory->addRetInstruct(nullptr);
     }
-    _current_table = tmp;
+    _table->popScope();
 }
 
 void IrGenerator::visit(MainNode& node) {
-    auto tmp = _current_table;
-    _current_table = std::make_shared<BlockSymbolTable>(_current_table);
+    _table->pushScope();
     node.block()->accept(*this);
-    _current_table = tmp;
+    _table->popScope();
 }
 
 void IrGenerator::visit(BlockNode& node) {
@@ -657,12 +676,12 @@ void IrGenerator::visit(BlockItemNode& node) {
 
 void IrGenerator::visit(AssignStmtNode& node) {
     auto lval = node.lval();
-    auto var = _current_table->getVar(lval->ident());
+    auto var = _table->getVar(lval->ident());
     Type* type;
     std::shared_ptr<Value> ptr;
     if (auto array_t = dynamic_cast<ArrayType*>(var->type()); array_t) {
         lval->exp()->accept(*this);
-        auto offset = _module->current_block()->last()->reg();
+        auto offset = _factory->last();
         auto result = std::make_shared<PtrValue>(array_t->type(), false, _factory->next_reg());
         auto elem = std::make_shared<IntConstValue>(0);
         _factory->addGepInstruct(result, var->value(), elem, std::static_pointer_cast<IntConstValue>(offset));
@@ -670,7 +689,7 @@ void IrGenerator::visit(AssignStmtNode& node) {
         ptr = result;
     } else if (auto ptr_t = dynamic_cast<PtrType*>(var->type()); ptr_t) {
         lval->exp()->accept(*this);
-        auto offset = _module->current_block()->last()->reg();
+        auto offset = _factory->last();
         auto result = std::make_shared<PtrValue>(ptr_t->next(), false, _factory->next_reg());
         _factory->addGepInstruct(result, var->value(), nullptr, std::static_pointer_cast<IntConstValue>(offset));
         type = ptr_t->next();
@@ -681,17 +700,17 @@ void IrGenerator::visit(AssignStmtNode& node) {
     }
 
     node.rval()->accept(*this);
-    auto value = _module->current_block()->last()->reg();
+    auto value = _factory->last();
 
     if (!Type::is_same(type, value->getType())) {
         if (Type::is_same(type, CharType::get())) {
             auto result = std::make_shared<CharValue>(_factory->next_reg());
             _factory->addTruncInstruct(result, value);
-            value = result;
+            value = _factory->last();
         } else if (Type::is_same(type, IntType::get())) {
             auto result = std::make_shared<IntValue>(_factory->next_reg());
             _factory->addSextInstruct(result, value);
-            value = result;
+            value = _factory->last();
         }
     }
 
@@ -701,18 +720,18 @@ void IrGenerator::visit(AssignStmtNode& node) {
 void IrGenerator::visit(ReturnStmtNode& node) {
     if (node.exp()) {
         node.exp()->accept(*this);
-        auto ret_value = _module->current_block()->last()->reg();
+        auto ret_value = _factory->last();
         if (Type::is_same(_module->current_function()->ret_type(), CharType::get())) {
             if (Type::is_same(ret_value->getType(), IntType::get())) {
                 auto result = std::make_shared<CharValue>(_factory->next_reg());
                 _factory->addTruncInstruct(result, ret_value);
-                ret_value = result;
+                ret_value = _factory->last();
             }
         } else if (Type::is_same(_module->current_function()->ret_type(), IntType::get())) {
             if (Type::is_same(ret_value->getType(), CharType::get())) {
                 auto result = std::make_shared<IntValue>(_factory->next_reg());
                 _factory->addSextInstruct(result, ret_value);
-                ret_value = result;
+                ret_value = _factory->last();
             }
         }
         _factory->addRetInstruct(ret_value);
@@ -758,21 +777,21 @@ void IrGenerator::visit(PrintfStmtNode& node) {
         }
         if (d_next < c_next && d_next != std::string::npos) {
             params[param_count++]->accept(*this);
-            auto reg = _module->current_block()->last()->reg();
+            auto reg = _factory->last();
             if (!Type::is_same(reg->getType(), IntType::get())) {
                 auto result = std::make_shared<IntValue>(_factory->next_reg());
                 _factory->addSextInstruct(result, reg);
-                reg = result;
+                reg = _factory->last();
             }
             _factory->addCallExternalInstruct(nullptr, "putint", {reg});
             pos = next + 2;
         } else if (c_next < d_next && c_next != std::string::npos) {
             params[param_count++]->accept(*this);
-            auto reg = _module->current_block()->last()->reg();
+            auto reg = _factory->last();
             if (!Type::is_same(reg->getType(), IntType::get())) {
                 auto result = std::make_shared<IntValue>(_factory->next_reg());
                 _factory->addSextInstruct(result, reg);
-                reg = result;
+                reg = _factory->last();
             }
             _factory->addCallExternalInstruct(nullptr, "putchar", {reg});
             pos = next + 2;
@@ -781,11 +800,11 @@ void IrGenerator::visit(PrintfStmtNode& node) {
 }
 
 void IrGenerator::visit(BreakStmtNode& node) {
-    _factory->addBrInstruct(_for_end_labels.at(_for_end_labels.size() - 1));
+    _factory->addBrInstruct(_for_end_blocks.back());
 }
 
 void IrGenerator::visit(ContinueStmtNode& node) {
-    _factory->addBrInstruct(_for_out_labels.at(_for_out_labels.size() - 1));
+    _factory->addBrInstruct(_for_out_blocks.back());
 }
 
 void IrGenerator::visit(ExpStmtNode& node) {
@@ -796,21 +815,24 @@ void IrGenerator::visit(ExpStmtNode& node) {
 
 void IrGenerator::visit(ForStmtNode& node) {
     auto forn = _factory->next_block();
-    _factory->addBrInstruct("for_entry" + forn);
-    _module->current_function()->addBlock("for_entry" + forn);
-    auto for_entry = _module->current_block();
+    auto for_entry = _module->current_function()->newBlock("for_entry" + forn);
+    auto for_in = _module->current_function()->newBlock("for_in" + forn);
+    auto for_body = _module->current_function()->newBlock("for_body" + forn);
+    auto for_out = _module->current_function()->newBlock("for_out" + forn);
+    auto for_end = _module->current_function()->newBlock("for_end" + forn);
+    _factory->addBrInstruct(for_entry);
+    _module->current_function()->addBlock(for_entry);
     if (node.for_in()) {
         node.for_in()->accept(*this);
     }
-    _factory->addBrInstruct("for_in" + forn);
-    _for_out_labels.push_back("for_out" + forn);
-    _for_end_labels.push_back("for_end" + forn);
+    _factory->addBrInstruct(for_in);
+    _for_out_blocks.push_back(for_out);
+    _for_end_blocks.push_back(for_end);
 
-    _module->current_function()->addBlock("for_in" + forn);
-    auto for_in = _module->current_function()->current_block();
+    _module->current_function()->addBlock(for_in);
     if (node.cond()) {
         node.cond()->accept(*this);
-        auto result = _module->current_block()->last()->reg();
+        auto result = _factory->last();
         if (!Type::is_same(result->getType(), BoolType::get())) {
             std::shared_ptr<Value> value;
             if (Type::is_same(result->getType(), CharType::get())) {
@@ -821,69 +843,71 @@ void IrGenerator::visit(ForStmtNode& node) {
             auto tmp = result;
             result = std::make_shared<BoolValue>(_factory->next_reg());
             _factory->addNeqInstruct(result, tmp, value);
+            result = _factory->last();
         }
-        _factory->addCondBrInstruct(result, "for_body" + forn, "for_end" + forn);
+        _factory->addCondBrInstruct(result, for_body, for_end);
     } else {
-        _factory->addBrInstruct("for_body" + forn);
+        _factory->addBrInstruct(for_body);
     }
 
-    _module->current_function()->addBlock("for_body" + forn);
-    auto for_body = _module->current_function()->current_block();
+    _module->current_function()->addBlock(for_body);
     node.stmt()->accept(*this);
-    _factory->addBrInstruct("for_out" + forn);
+    _factory->addBrInstruct(for_out);
 
-    _module->current_function()->addBlock("for_out" + forn);
-    auto for_out = _module->current_function()->current_block();
+    _module->current_function()->addBlock(for_out);
     if (node.for_out()) {
         node.for_out()->accept(*this);
     }
-    _factory->addBrInstruct("for_in" + forn);
+    _factory->addBrInstruct(for_in);
 
-    _for_out_labels.pop_back();
-    _for_end_labels.pop_back();
+    _for_out_blocks.pop_back();
+    _for_end_blocks.pop_back();
 
-    _module->current_function()->addBlock("for_end" + forn);
+    _module->current_function()->addBlock(for_end);
 }
 
 void IrGenerator::visit(IfStmtNode& node) {
     auto ifn = _factory->next_block();
-    _factory->addBrInstruct("if_entry" + ifn);
-    _module->current_function()->addBlock("if_entry" + ifn);
-    auto if_entry = _module->current_block();
+    auto if_entry = _module->current_function()->newBlock("if_entry" + ifn);
+    auto if_body = _module->current_function()->newBlock("if_body" + ifn);
+    auto else_body = _module->current_function()->newBlock("else_body" + ifn);
+    auto if_end = _module->current_function()->newBlock("if_end" + ifn);
+    _factory->addBrInstruct(if_entry);
+    _module->current_function()->addBlock(if_entry);
     node.cond()->accept(*this);
-    auto result = _module->current_block()->last()->reg();
+    auto result = _factory->last();
     if (!Type::is_same(result->getType(), BoolType::get())) {
         auto tmp = result;
         result = std::make_shared<BoolValue>(_factory->next_reg());
         _factory->addNeqInstruct(result, tmp, std::make_shared<IntConstValue>(0));
+        result = _factory->last();
     }
 
     if (node.else_stmt()) {
-        _factory->addCondBrInstruct(result, "if_body" + ifn, "else_body" + ifn);
+        _factory->addCondBrInstruct(result, if_body, else_body);
     } else {
-        _factory->addCondBrInstruct(result, "if_body" + ifn, "if_end" + ifn);
+        _factory->addCondBrInstruct(result, if_body, if_end);
     }
 
-    _module->current_function()->addBlock("if_body" + ifn);
+    _module->current_function()->addBlock(if_body);
     node.if_stmt()->accept(*this);
-    _factory->addBrInstruct("if_end" + ifn);
+    _factory->addBrInstruct(if_end);
 
     if (node.else_stmt()) {
-        _module->current_function()->addBlock("else_body" + ifn);
+        _module->current_function()->addBlock(else_body);
         node.else_stmt()->accept(*this);
-        _factory->addBrInstruct("if_end" + ifn);
+        _factory->addBrInstruct(if_end);
     }
 
-    _module->current_function()->addBlock("if_end" + ifn);
+    _module->current_function()->addBlock(if_end);
 }
 
 void IrGenerator::visit(BlockStmtNode& node) {
-    auto tmp = _current_table;
-    _current_table = std::make_shared<BlockSymbolTable>(_current_table);
+    _table->pushScope();
 
     node.block()->accept(*this);
     
-    _current_table = tmp;
+    _table->popScope();
 }
 
 void IrGenerator::visit(RValNode& node) {
@@ -916,27 +940,27 @@ void IrGenerator::visit(FuncFParamsNode& node) {
             auto base_t = ptr_t->next();
             if (Type::is_same(base_t, IntType::get())) {
                 var = Var::getIntPtr(ident, false);
-                var->value() = std::make_shared<PtrValue>(base_t, false, ident);
+                var->value() = std::make_shared<PtrValue>(base_t, false, ident.str());
             } else if (Type::is_same(base_t, CharType::get())) {
                 var = Var::getCharPtr(ident, false);
-                var->value() = std::make_shared<PtrValue>(base_t, false, ident);
+                var->value() = std::make_shared<PtrValue>(base_t, false, ident.str());
             }
         } else {
             if (Type::is_same(type, IntType::get())) {
                 var = Var::getInt(ident, false);
-                value = std::make_shared<IntValue>(ident);
+                value = std::make_shared<IntValue>(ident.str());
                 var->value() = std::make_shared<PtrValue>(IntType::get(), false, _factory->next_reg());
                 _factory->addAllocaInstruct(var->value());
                 _factory->addStoreInstruct(value, var->value());
             } else if (Type::is_same(type, CharType::get())) {
                 var = Var::getChar(ident, false);
-                value = std::make_shared<CharValue>(ident);
+                value = std::make_shared<CharValue>(ident.str());
                 var->value() = std::make_shared<PtrValue>(CharType::get(), false, _factory->next_reg());
                 _factory->addAllocaInstruct(var->value());
                 _factory->addStoreInstruct(value, var->value());
             }
         }
-        _current_table->addVar(var);
+        _table->addVar(var);
     }
 }
 
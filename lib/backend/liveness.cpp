@@ -0,0 +1,84 @@
+#include "liveness.hpp"
+
+namespace blang {
+namespace backend {
+
+Liveness::Liveness(Function& function) : _words(0) {
+    auto& blocks = function.blocks();
+    for (uint32_t i = 0; i < blocks.size(); i++) {
+        _blocks.emplace(blocks[i].get(), i);
+        for (auto& instruct : blocks[i]->instructions()) {
+            if (instruct->defines()) {
+                _index.emplace(instruct->reg().get(), static_cast<uint32_t>(_index.size()));
+            }
+        }
+    }
+    _words = (_index.size() + 63) / 64;
+    auto set = [](std::vector<uint64_t>& bits, uint32_t bit) { bits[bit / 64] |= uint64_t(1) << (bit % 64); };
+
+    // upward exposed uses, defs, and uses by phis of successors
+    std::vector<std::vector<uint64_t>> uses(blocks.size(), std::vector<uint64_t>(_words));
+    std::vector<std::vector<uint64_t>> defs(blocks.size(), std::vector<uint64_t>(_words));
+    std::vector<std::vector<uint64_t>> phi_uses(blocks.size(), std::vector<uint64_t>(_words));
+    for (uint32_t i = 0; i < blocks.size(); i++) {
+        for (auto& instruct : blocks[i]->instructions()) {
+            if (auto phi = dyn_cast<PhiInstruct>(instruct); phi) {
+                for (std::size_t j = 0; j < phi->size(); j++) {
+                    auto value = _index.find(phi->incoming(j).get());
+                    auto pred = _blocks.find(phi->block(j));
+                    if (value != _index.end() && pred != _blocks.end()) {
+                        set(phi_uses[pred->second], value->second);
+                    }
+                }
+            } else {
+                for (auto& use : instruct->operands()) {
+                    auto value = _index.find(use.get().get());
+                    if (value != _index.end() && !test(defs[i], value->second)) {
+                        set(uses[i], value->second);
+                    }
+                }
+            }
+            if (instruct->defines()) {
+                set(defs[i], _index[instruct->reg().get()]);
+            }
+        }
+    }
+
+    // in = uses | (out & ~defs), out = phi uses | in of successors
+    _live_in.assign(blocks.size(), std::vector<uint64_t>(_words));
+    _live_out.assign(blocks.size(), std::vector<uint64_t>(_words));
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto i = blocks.size(); i-- > 0;) {
+            auto& out = _live_out[i];
+            auto& in = _live_in[i];
+            for (auto succ : blocks[i]->succs()) {
+                auto& succ_in = _live_in[_blocks.at(succ)];
+                for (std::size_t w = 0; w < _words; w++) {
+                    out[w] |= succ_in[w];
+                }
+            }
+            for (std::size_t w = 0; w < _words; w++) {
+                out[w] |= phi_uses[i][w];
+                auto next = uses[i][w] | (out[w] & ~defs[i][w]);
+                if (next != in[w]) {
+                    in[w] = next;
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+bool Liveness::lookup(const std::vector<std::vector<uint64_t>>& sets, Block* block, Value* value) const {
+    auto index = _index.find(value);
+    auto block_index = _blocks.find(block);
+    if (index == _index.end() || block_index == _blocks.end()) {
+        return false;
+    }
+    return test(sets[block_index->second], index->second);
+}
+
+}
+}
@@ -0,0 +1,66 @@
+#include "loop_info.hpp"
+#include <algorithm>
+#include <unordered_set>
+
+namespace blang {
+namespace backend {
+
+LoopInfo::LoopInfo(Function& function, const DominatorTree& dominators) {
+    std::unordered_map<Block*, std::shared_ptr<Loop>> by_header{};
+    for (auto block : dominators.order()) {
+        for (auto succ : block->succs()) {
+            if (!dominators.dominates(succ, block)) {
+                continue;
+            }
+            auto& loop = by_header[succ];
+            if (!loop) {
+                loop = std::make_shared<Loop>(Loop{succ, {succ}, nullptr, 1});
+                _loops.push_back(loop);
+            }
+            // walk back from the latch to the header, everything met is in the loop
+            std::unordered_set<Block*> seen(loop->blocks.begin(), loop->blocks.end());
+            std::vector<Block*> work{};
+            if (seen.insert(block).second) {
+                loop->blocks.push_back(block);
+                work.push_back(block);
+            }
+            while (!work.empty()) {
+                auto current = work.back();
+                work.pop_back();
+                for (auto pred : current->preds()) {
+                    if (dominators.reachable(pred) && seen.insert(pred).second) {
+                        loop->blocks.push_back(pred);
+                        work.push_back(pred);
+                    }
+                }
+            }
+        }
+    }
+
+    // loops with distinct headers are disjoint or strictly nested, so larger loops are outer
+    std::stable_sort(_loops.begin(), _loops.end(), [](const std::shared_ptr<Loop>& a, const std::shared_ptr<Loop>& b) {
+        return a->blocks.size() > b->blocks.size();
+    });
+    for (auto& loop : _loops) {
+        if (auto iter = _innermost.find(loop->header); iter != _innermost.end()) {
+            loop->parent = iter->second;
+            loop->depth = iter->second->depth + 1;
+        }
+        for (auto block : loop->blocks) {
+            _innermost[block] = loop.get();
+        }
+    }
+}
+
+Loop* LoopInfo::loopOf(Block* block) const {
+    auto iter = _innermost.find(block);
+    return iter == _innermost.end() ? nullptr : iter->second;
+}
+
+uint32_t LoopInfo::depth(Block* block) const {
+    auto loop = loopOf(block);
+    return loop ? loop->depth : 0;
+}
+
+}
+}
@@ -1,78 +1,758 @@
 #include "optimizer.hpp"
+#include "dominator_tree.hpp"
 #include "ir.hpp"
+#include <algorithm>
+#include <functional>
 #include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 
 using namespace blang::entities;
 
 namespace blang {
 namespace backend {
 
-Optimizer::Optimizer() : _passes({
-    std::make_shared<EmptyBlockPass>()
-}) {}
+/**
+ * @brief Every pass a pipeline can name, in the order passNames() lists them
+ * 
+ */
+static const std::vector<std::pair<std::string, std::function<std::shared_ptr<Pass>()>>> PASS_REGISTRY = {
+    {"empty-block", [] { return std::make_shared<EmptyBlockPass>(); }},
+    {"mem2reg", [] { return std::make_shared<Mem2RegPass>(); }},
+    {"sccp", [] { return std::make_shared<SCCPPass>(); }},
+    {"adce", [] { return std::make_shared<ADCEPass>(); }},
+    {"unreachable", [] { return std::make_shared<UnreachableBlockPass>(); }},
+};
 
-std::shared_ptr<IrModule> Optimizer::optim(std::shared_ptr<IrModule> module) {
-    _module = module;
-    for (auto& pass : _passes) {
-        module = pass->optim(module);
+Optimizer::Optimizer() : _passes() {
+    setPipeline(DEFAULT_PIPELINE);
+}
+
+void Optimizer::setPipeline(const std::string& pipeline) {
+    PassManager passes{};
+    std::size_t start = 0;
+    while (start < pipeline.size()) {
+        auto end = pipeline.find(',', start);
+        if (end == std::string::npos) {
+            end = pipeline.size();
+        }
+        auto name = pipeline.substr(start, end - start);
+        auto iter = std::find_if(PASS_REGISTRY.begin(), PASS_REGISTRY.end(), [&name](auto& entry) {
+            return entry.first == name;
+        });
+        if (iter == PASS_REGISTRY.end()) {
+            throw std::runtime_error("Unknown pass " + name + "!");
+        }
+        passes.add(iter->second());
+        start = end + 1;
     }
+    _passes = std::move(passes);
+}
+
+std::vector<std::string> Optimizer::passNames() {
+    std::vector<std::string> names{};
+    for (auto& [name, create] : PASS_REGISTRY) {
+        names.push_back(name);
+    }
+    return names;
+}
+
+std::vector<std::pair<std::string, PassStats>> Optimizer::stats() const {
+    std::vector<std::pair<std::string, PassStats>> stats{};
+    for (auto& pass : _passes.passes()) {
+        stats.push_back({pass->name(), pass->stats()});
+    }
+    return stats;
+}
+
+std::shared_ptr<IrModule> Optimizer::optim(std::shared_ptr<IrModule> module, std::size_t workers) {
+    _passes.run(*module, workers);
     return module;
 }
 
-void EmptyBlockPass::resetPreBlock(std::shared_ptr<Function> function, std::string from, std::string to) {
-    for (auto& block : function->blocks()) {
-        for (auto& label : block->next()) {
-            if (label == from) {
-                for (auto iter = block->instructions().begin(); iter < block->instructions().end(); iter++) {
-                    if (auto br = std::dynamic_pointer_cast<BrInstruct>(*iter)) {
-                        if (br->label() == from) {
-                            auto next = block->instructions().erase(iter);
-                            block->instructions().insert(next, std::make_shared<BrInstruct>(to));
-                            iter = next - 1;
-                        }
-                    } else if (auto condbr = std::dynamic_pointer_cast<CondBrInstruct>(*iter)) {
-                        auto true_label = condbr->true_label();
-                        auto false_label = condbr->false_label();
-                        bool flag = false;
-                        if (true_label == from) {
-                            true_label = to;
-                            flag = true;
-                        }
-                        if (false_label == from) {
-                            false_label = to;
-                            flag = true;
-                        }
-                        if (flag) {
-                            auto next = block->instructions().erase(iter);
-                            block->instructions().insert(next, std::make_shared<CondBrInstruct>(condbr->cond(), true_label, false_label));
-                            iter = next - 1;
+/**
+ * @brief Remove the entry of pred from every phi of block, once per edge removed
+ * 
+ * @param block 
+ * @param pred 
+ */
+static void removeIncoming(Block* block, Block* pred) {
+    for (auto& instruct : block->instructions()) {
+        auto phi = dyn_cast<PhiInstruct>(instruct);
+        if (!phi) {
+            break;
+        }
+        for (std::size_t i = 0; i < phi->size(); i++) {
+            if (phi->block(i) == pred) {
+                phi->removeIncoming(i);
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Remove blocks not kept, their edges and the phi entries of those edges go with them
+ * No kept block may use a value defined in a removed one
+ * 
+ * @tparam Keep bool(Block*)
+ * @param function 
+ * @param keep 
+ * @return PassStats Instructions and blocks removed
+ */
+template<typename Keep>
+static PassStats eraseBlocks(Function& function, Keep keep) {
+    auto stats = PassStats();
+    std::vector<std::shared_ptr<Block>> kept{};
+    for (auto& block : function.blocks()) {
+        if (keep(block.get())) {
+            kept.push_back(block);
+            continue;
+        }
+        auto succs = block->succs();
+        for (auto succ : succs) {
+            block->unlink(succ);
+            if (keep(succ)) {
+                removeIncoming(succ, block.get());
+            }
+        }
+        for (auto& instruct : block->instructions()) {
+            instruct->dropOperands();
+        }
+        stats.instructs += block->instructions().size();
+        stats.blocks++;
+    }
+    if (stats.blocks > 0) {
+        function.blocks() = kept;
+    }
+    return stats;
+}
+
+PreservedAnalyses EmptyBlockPass::run(Function& function, AnalysisManager& analyses) {
+    bool changed = false;
+    auto& blocks = function.blocks();
+    std::vector<std::shared_ptr<Block>> kept{};
+    kept.reserve(blocks.size());
+    for (auto& block : blocks) {
+        // entry block stays, it cannot be branched to
+        if (block != blocks.front() && block->instructions().size() == 1) {
+            if (auto br = dyn_cast<BrInstruct>(block->instructions().front()); br && br->target() != block.get()
+                && (br->target()->instructions().empty() || !isa<PhiInstruct>(br->target()->instructions().front()))) {
+                auto target = br->target();
+                auto preds = block->preds();
+                for (auto pred : preds) {
+                    pred->retarget(block.get(), target);
+                }
+                block->unlink(target);
+                removed({1, 1});
+                changed = true;
+                continue;
+            }
+        }
+        kept.push_back(block);
+    }
+    blocks = kept;
+
+    return changed ? PRESERVE_NONE : PRESERVE_ALL;
+}
+
+/**
+ * @brief Whether a scalar alloca is only loaded from and stored to
+ * 
+ * @param var 
+ * @return true 
+ * @return false 
+ */
+static bool promotable(const std::shared_ptr<Value>& var) {
+    auto type = var->getType();
+    if (type != IntType::get() && type != CharType::get() && type != BoolType::get()) {
+        return false;
+    }
+    for (auto use = var->uses(); use; use = use->next()) {
+        if (isa<LoadInstruct>(use->user())) {
+            continue;
+        }
+        if (auto store = dyn_cast<StoreInstruct>(use->user()); store && store->from() != var) {
+            continue;
+        }
+        return false;
+    }
+
+    return true;
+}
+
+static std::shared_ptr<Value> zeroOf(Type* type) {
+    if (type == IntType::get()) {
+        return std::make_shared<IntConstValue>(0);
+    } else if (type == CharType::get()) {
+        return std::make_shared<CharConstValue>(0);
+    }
+    return std::make_shared<BoolConstValue>(false);
+}
+
+static std::shared_ptr<Value> regOf(Type* type, std::string ident) {
+    if (type == IntType::get()) {
+        return std::make_shared<IntValue>(ident);
+    } else if (type == CharType::get()) {
+        return std::make_shared<CharValue>(ident);
+    }
+    return std::make_shared<BoolValue>(ident);
+}
+
+PreservedAnalyses Mem2RegPass::run(Function& function, AnalysisManager& analyses) {
+    std::vector<std::shared_ptr<Value>> vars{};
+    std::unordered_map<Value*, uint32_t> var_index{};
+    for (auto& block : function.blocks()) {
+        for (auto& instruct : block->instructions()) {
+            if (isa<AllocaInstruct>(instruct) && promotable(instruct->reg())) {
+                var_index.emplace(instruct->reg().get(), static_cast<uint32_t>(vars.size()));
+                vars.push_back(instruct->reg());
+            }
+        }
+    }
+    if (vars.empty()) {
+        return PRESERVE_ALL;
+    }
+
+    auto& tree = analyses.dominators(function);
+    auto var_of = [&var_index](const std::shared_ptr<Value>& ptr) {
+        auto iter = var_index.find(ptr.get());
+        return iter == var_index.end() ? UINT32_MAX : iter->second;
+    };
+
+    // blocks storing to each variable, unreachable ones place no phi
+    std::vector<std::vector<Block*>> defs(vars.size());
+    for (auto block : tree.order()) {
+        for (auto& instruct : block->instructions()) {
+            if (auto store = dyn_cast<StoreInstruct>(instruct); store) {
+                if (auto var = var_of(store->to()); var != UINT32_MAX && (defs[var].empty() || defs[var].back() != block)) {
+                    defs[var].push_back(block);
+                }
+            }
+        }
+    }
+
+    // phis on iterated dominance frontiers, stamps hold var + 1 of the last visit
+    std::unordered_map<Block*, std::vector<std::pair<uint32_t, PhiInstruct*>>> phis{};
+    std::unordered_map<Block*, std::vector<std::shared_ptr<Instruct>>> placed{};
+    std::unordered_map<Block*, uint32_t> phi_stamp{};
+    std::unordered_map<Block*, uint32_t> work_stamp{};
+    for (uint32_t var = 0; var < vars.size(); var++) {
+        auto work = defs[var];
+        for (auto block : work) {
+            work_stamp[block] = var + 1;
+        }
+        while (!work.empty()) {
+            auto block = work.back();
+            work.pop_back();
+            for (auto frontier : tree.frontier(block)) {
+                if (phi_stamp[frontier] == var + 1) {
+                    continue;
+                }
+                phi_stamp[frontier] = var + 1;
+                auto phi = std::make_shared<PhiInstruct>(regOf(vars[var]->getType(), function.next_reg()), frontier->preds());
+                phis[frontier].push_back({var, phi.get()});
+                placed[frontier].push_back(phi);
+                if (work_stamp[frontier] != var + 1) {
+                    work_stamp[frontier] = var + 1;
+                    work.push_back(frontier);
+                }
+            }
+        }
+    }
+    for (auto& [block, block_phis] : placed) {
+        block->instructions().insert(block->instructions().begin(), block_phis.begin(), block_phis.end());
+    }
+
+    // current value of each variable, undo log restores it when leaving a subtree
+    std::vector<std::shared_ptr<Value>> zeros{};
+    for (auto& var : vars) {
+        zeros.push_back(zeroOf(var->getType()));
+    }
+    auto current = zeros;
+    std::vector<std::pair<uint32_t, std::shared_ptr<Value>>> undo{};
+    auto set = [&current, &undo](uint32_t var, std::shared_ptr<Value> value) {
+        undo.push_back({var, current[var]});
+        current[var] = std::move(value);
+    };
+    auto rename = [&](Block* block) {
+        if (auto iter = phis.find(block); iter != phis.end()) {
+            for (auto& [var, phi] : iter->second) {
+                set(var, phi->reg());
+            }
+        }
+        auto& instructions = block->instructions();
+        auto kept = std::remove_if(instructions.begin(), instructions.end(), [&](std::shared_ptr<Instruct>& instruct) {
+            if (auto load = dyn_cast<LoadInstruct>(instruct); load) {
+                if (auto var = var_of(load->from()); var != UINT32_MAX) {
+                    load->reg()->replaceAllUsesWith(current[var]);
+                    load->dropOperands();
+                    return true;
+                }
+            } else if (auto store = dyn_cast<StoreInstruct>(instruct); store) {
+                if (auto var = var_of(store->to()); var != UINT32_MAX) {
+                    set(var, store->from());
+                    store->dropOperands();
+                    return true;
+                }
+            } else if (isa<AllocaInstruct>(instruct)) {
+                return var_of(instruct->reg()) != UINT32_MAX;
+            }
+            return false;
+        });
+        removed({static_cast<std::size_t>(instructions.end() - kept), 0});
+        instructions.erase(kept, instructions.end());
+        for (auto succ : block->succs()) {
+            if (auto iter = phis.find(succ); iter != phis.end()) {
+                for (auto& [var, phi] : iter->second) {
+                    for (std::size_t i = 0; i < phi->size(); i++) {
+                        if (phi->block(i) == block) {
+                            phi->setIncoming(i, current[var]);
                         }
                     }
                 }
+            }
+        }
+    };
+
+    struct Frame {
+        Block* block;
+        std::size_t child;
+        std::size_t undo_size;
+    };
+    std::vector<Frame> stack{};
+    auto entry = function.blocks().front().get();
+    stack.push_back({entry, 0, undo.size()});
+    rename(entry);
+    while (!stack.empty()) {
+        auto& frame = stack.back();
+        auto& children = tree.children(frame.block);
+        if (frame.child < children.size()) {
+            auto child = children[frame.child++];
+            stack.push_back({child, 0, undo.size()});
+            rename(child);
+            continue;
+        }
+        while (undo.size() > frame.undo_size) {
+            current[undo.back().first] = std::move(undo.back().second);
+            undo.pop_back();
+        }
+        stack.pop_back();
+    }
+    // never executed, but their loads and stores go with the allocas and they feed phis of reachable blocks
+    for (auto& block : function.blocks()) {
+        if (!tree.reachable(block.get())) {
+            current = zeros;
+            rename(block.get());
+            undo.clear();
+        }
+    }
+
+    // drop phis nothing reads but themselves, which may leave their incoming phis unread
+    std::unordered_map<Value*, PhiInstruct*> phi_of{};
+    std::vector<PhiInstruct*> work{};
+    for (auto& [block, block_phis] : phis) {
+        for (auto& [var, phi] : block_phis) {
+            phi_of.emplace(phi->reg().get(), phi);
+            work.push_back(phi);
+        }
+    }
+    std::unordered_set<Instruct*> dead{};
+    while (!work.empty()) {
+        auto phi = work.back();
+        work.pop_back();
+        if (dead.count(phi)) {
+            continue;
+        }
+        bool read = false;
+        for (auto use = phi->reg()->uses(); use; use = use->next()) {
+            if (use->user() != phi) {
+                read = true;
                 break;
             }
         }
+        if (read) {
+            continue;
+        }
+        dead.insert(phi);
+        for (std::size_t i = 0; i < phi->size(); i++) {
+            if (auto iter = phi_of.find(phi->incoming(i).get()); iter != phi_of.end() && iter->second != phi) {
+                work.push_back(iter->second);
+            }
+        }
+        phi->dropOperands();
+    }
+    if (!dead.empty()) {
+        for (auto& [block, block_phis] : placed) {
+            auto& instructions = block->instructions();
+            instructions.erase(std::remove_if(instructions.begin(), instructions.end(), [&dead](std::shared_ptr<Instruct>& instruct) {
+                return dead.count(instruct.get()) > 0;
+            }), instructions.end());
+        }
     }
+
+    return PRESERVE_CFG;
 }
 
-std::shared_ptr<IrModule> EmptyBlockPass::optim(std::shared_ptr<IrModule> module) {
-    for (auto& [ident, function] : module->functions()) {
-        for (auto iter = function->blocks().begin(); iter < function->blocks().end(); iter++) {
-            auto block = *iter;
-            if (block->instructions().size() == 1) {
-                if (auto br = std::dynamic_pointer_cast<BrInstruct>(
-                    block->instructions().at(0)
-                ); br) {
-                    resetPreBlock(function, block->label(), br->label());
-                    auto next = function->blocks().erase(iter);
-                    iter = next - 1;
+/**
+ * @brief Value of a register in sccp, unknown until evaluated, then a
+ * constant, then overdefined once it is seen to take two values
+ * 
+ */
+struct LatticeValue {
+    enum State { UNKNOWN, CONSTANT, OVERDEFINED } state = UNKNOWN;
+    int32_t value = 0;
+    bool operator==(const LatticeValue& rhs) const { return state == rhs.state && value == rhs.value; }
+    bool operator!=(const LatticeValue& rhs) const { return !(*this == rhs); }
+};
+
+/**
+ * @brief Constant as constValue reads it back from makeConst(type, value)
+ * 
+ * @param type 
+ * @param value 
+ * @return int32_t 
+ */
+static int32_t wrapConst(Type* type, int32_t value) {
+    if (type == CharType::get()) {
+        return static_cast<char>(value);
+    } else if (type == BoolType::get()) {
+        return value & 1 ? -1 : 0;
+    }
+    return value;
+}
+
+/**
+ * @brief Solver state of one function, registers and edges found so far
+ * 
+ */
+class SCCPSolver {
+private:
+    const std::unordered_map<Value*, int32_t>& _globals;
+    std::unordered_map<Value*, LatticeValue> _values;
+    std::unordered_map<Instruct*, Block*> _parent;
+    std::unordered_set<Block*> _executable;
+    std::unordered_map<Block*, std::vector<Block*>> _edges;
+    std::vector<Block*> _block_work;
+    std::vector<Instruct*> _inst_work;
+
+    LatticeValue get(const std::shared_ptr<Value>& value) {
+        if (auto iter = _values.find(value.get()); iter != _values.end()) {
+            return iter->second;
+        }
+        if (auto constant = constValue(value); constant) {
+            return {LatticeValue::CONSTANT, *constant};
+        }
+        return {LatticeValue::OVERDEFINED, 0};
+    }
+    void update(Instruct* instruct, LatticeValue next) {
+        auto reg = instruct->reg();
+        auto& current = _values[reg.get()];
+        if (current == next) {
+            return ;
+        }
+        current = next;
+        for (auto use = reg->uses(); use; use = use->next()) {
+            _inst_work.push_back(use->user());
+        }
+    }
+    void markEdge(Block* from, Block* to) {
+        auto& targets = _edges[from];
+        if (std::find(targets.begin(), targets.end(), to) != targets.end()) {
+            return ;
+        }
+        targets.push_back(to);
+        if (_executable.insert(to).second) {
+            _block_work.push_back(to);
+            return ;
+        }
+        // a new edge into a reached block only changes its phis
+        for (auto& instruct : to->instructions()) {
+            if (!isa<PhiInstruct>(instruct)) {
+                break;
+            }
+            _inst_work.push_back(instruct.get());
+        }
+    }
+    void visit(Instruct* instruct) {
+        auto block = _parent.at(instruct);
+        auto type = instruct->typeId();
+        if (auto phi = dyn_cast<PhiInstruct>(instruct); phi) {
+            auto result = LatticeValue();
+            for (std::size_t i = 0; i < phi->size() && result.state != LatticeValue::OVERDEFINED; i++) {
+                if (!edgeTaken(phi->block(i), block)) {
+                    continue;
+                }
+                auto incoming = get(phi->incoming(i));
+                if (incoming.state == LatticeValue::UNKNOWN) {
+                    continue;
+                }
+                if (result.state == LatticeValue::UNKNOWN) {
+                    result = incoming;
+                } else if (result != incoming) {
+                    result = {LatticeValue::OVERDEFINED, 0};
+                }
+            }
+            update(instruct, result);
+        } else if (auto arith = dyn_cast<ArithInstruct>(instruct); arith) {
+            auto left = get(arith->left());
+            auto right = get(arith->right());
+            if (left.state == LatticeValue::OVERDEFINED || right.state == LatticeValue::OVERDEFINED) {
+                update(instruct, {LatticeValue::OVERDEFINED, 0});
+            } else if (left.state == LatticeValue::CONSTANT && right.state == LatticeValue::CONSTANT) {
+                auto result_t = arith->reg()->getType();
+                auto folded = foldConstants(type, result_t, left.value, right.value);
+                update(instruct, folded ? LatticeValue{LatticeValue::CONSTANT, wrapConst(result_t, *folded)} : LatticeValue{LatticeValue::OVERDEFINED, 0});
+            }
+        } else if (type == INSTRUCT_SEXT || type == INSTRUCT_ZEXT || type == INSTRUCT_TRUNC) {
+            auto source = get(instruct->operand(0));
+            if (source.state == LatticeValue::CONSTANT) {
+                auto result_t = instruct->reg()->getType();
+                auto folded = foldConstantCast(type, instruct->operand(0)->getType(), source.value);
+                update(instruct, {LatticeValue::CONSTANT, wrapConst(result_t, folded)});
+            } else if (source.state == LatticeValue::OVERDEFINED) {
+                update(instruct, {LatticeValue::OVERDEFINED, 0});
+            }
+        } else if (auto load = dyn_cast<LoadInstruct>(instruct); load) {
+            auto iter = _globals.find(load->from().get());
+            update(instruct, iter != _globals.end() ? LatticeValue{LatticeValue::CONSTANT, iter->second} : LatticeValue{LatticeValue::OVERDEFINED, 0});
+        } else if (auto br = dyn_cast<BrInstruct>(instruct); br) {
+            markEdge(block, br->target());
+        } else if (auto condbr = dyn_cast<CondBrInstruct>(instruct); condbr) {
+            auto cond = get(condbr->cond());
+            if (cond.state == LatticeValue::CONSTANT) {
+                markEdge(block, cond.value ? condbr->true_block() : condbr->false_block());
+            } else if (cond.state == LatticeValue::OVERDEFINED) {
+                markEdge(block, condbr->true_block());
+                markEdge(block, condbr->false_block());
+            }
+        } else if (instruct->defines()) {
+            update(instruct, {LatticeValue::OVERDEFINED, 0});
+        }
+    }
+public:
+    SCCPSolver(Function& function, const std::unordered_map<Value*, int32_t>& globals) : _globals(globals) {
+        for (auto& block : function.blocks()) {
+            for (auto& instruct : block->instructions()) {
+                _parent.emplace(instruct.get(), block.get());
+                if (instruct->defines()) {
+                    _values.emplace(instruct->reg().get(), LatticeValue());
+                }
+            }
+        }
+    }
+    void solve(Function& function) {
+        auto entry = function.blocks().front().get();
+        _executable.insert(entry);
+        _block_work.push_back(entry);
+        while (!_block_work.empty() || !_inst_work.empty()) {
+            while (!_block_work.empty() || !_inst_work.empty()) {
+                while (!_inst_work.empty()) {
+                    auto instruct = _inst_work.back();
+                    _inst_work.pop_back();
+                    if (_executable.count(_parent.at(instruct))) {
+                        visit(instruct);
+                    }
+                }
+                if (!_block_work.empty()) {
+                    auto block = _block_work.back();
+                    _block_work.pop_back();
+                    for (auto& instruct : block->instructions()) {
+                        visit(instruct.get());
+                    }
+                }
+            }
+            // a condition never evaluated takes both edges, so no reached branch points to a removed block
+            for (auto& block : function.blocks()) {
+                if (!executable(block.get()) || block->instructions().empty()) {
+                    continue;
+                }
+                if (auto condbr = dyn_cast<CondBrInstruct>(block->instructions().back());
+                    condbr && get(condbr->cond()).state == LatticeValue::UNKNOWN) {
+                    markEdge(block.get(), condbr->true_block());
+                    markEdge(block.get(), condbr->false_block());
                 }
             }
         }
     }
+    bool executable(Block* block) { return _executable.count(block) > 0; }
+    bool edgeTaken(Block* from, Block* to) {
+        auto iter = _edges.find(from);
+        return iter != _edges.end() && std::find(iter->second.begin(), iter->second.end(), to) != iter->second.end();
+    }
+    LatticeValue value(Value* reg) {
+        auto iter = _values.find(reg);
+        return iter == _values.end() ? LatticeValue{LatticeValue::OVERDEFINED, 0} : iter->second;
+    }
+};
 
-    return module;
+void SCCPPass::prepare(IrModule& module) {
+    _globals.clear();
+    for (auto& instruct : module.global()) {
+        if (auto def = dyn_cast<DefInstruct>(instruct); def && def->is_const()) {
+            if (auto init = constValue(def->init()); init) {
+                _globals.emplace(def->reg().get(), *init);
+            }
+        }
+    }
+}
+
+PreservedAnalyses SCCPPass::run(Function& function, AnalysisManager& analyses) {
+    if (function.blocks().empty()) {
+        return PRESERVE_ALL;
+    }
+    auto solver = SCCPSolver(function, _globals);
+    solver.solve(function);
+
+    bool changed = false;
+    bool cfg_changed = false;
+    // constant registers, values of a reached block only, the rest goes with its block
+    for (auto& block : function.blocks()) {
+        if (!solver.executable(block.get())) {
+            continue;
+        }
+        auto& instructions = block->instructions();
+        auto kept = std::remove_if(instructions.begin(), instructions.end(), [&solver](std::shared_ptr<Instruct>& instruct) {
+            if (!instruct->defines()) {
+                return false;
+            }
+            auto reg = instruct->reg();
+            auto lattice = solver.value(reg.get());
+            if (lattice.state != LatticeValue::CONSTANT) {
+                return false;
+            }
+            reg->replaceAllUsesWith(makeConst(reg->getType(), lattice.value));
+            instruct->dropOperands();
+            return true;
+        });
+        changed = changed || kept != instructions.end();
+        removed({static_cast<std::size_t>(instructions.end() - kept), 0});
+        instructions.erase(kept, instructions.end());
+    }
+
+    // cond brs with one edge taken
+    for (auto& block : function.blocks()) {
+        if (!solver.executable(block.get()) || block->instructions().empty()) {
+            continue;
+        }
+        auto condbr = dyn_cast<CondBrInstruct>(block->instructions().back());
+        if (!condbr || condbr->true_block() == condbr->false_block()) {
+            continue;
+        }
+        auto true_taken = solver.edgeTaken(block.get(), condbr->true_block());
+        auto false_taken = solver.edgeTaken(block.get(), condbr->false_block());
+        if (true_taken == false_taken) {
+            continue;
+        }
+        auto taken = true_taken ? condbr->true_block() : condbr->false_block();
+        auto dropped = true_taken ? condbr->false_block() : condbr->true_block();
+        block->unlink(dropped);
+        removeIncoming(dropped, block.get());
+        condbr->dropOperands();
+        block->instructions().back() = std::make_shared<BrInstruct>(taken);
+        cfg_changed = true;
+    }
+
+    // blocks never reached
+    auto erased = eraseBlocks(function, [&solver](Block* block) { return solver.executable(block); });
+    removed(erased);
+    cfg_changed = cfg_changed || erased.blocks > 0;
+
+    // phis left with a single incoming value
+    for (auto& block : function.blocks()) {
+        auto& instructions = block->instructions();
+        auto kept_phis = std::remove_if(instructions.begin(), instructions.end(), [](std::shared_ptr<Instruct>& instruct) {
+            auto phi = dyn_cast<PhiInstruct>(instruct);
+            if (!phi || phi->size() != 1 || phi->incoming(0) == phi->reg()) {
+                return false;
+            }
+            phi->reg()->replaceAllUsesWith(phi->incoming(0));
+            phi->dropOperands();
+            return true;
+        });
+        changed = changed || kept_phis != instructions.end();
+        removed({static_cast<std::size_t>(instructions.end() - kept_phis), 0});
+        instructions.erase(kept_phis, instructions.end());
+    }
+
+    if (cfg_changed) {
+        return PRESERVE_NONE;
+    }
+    return changed ? PRESERVE_CFG : PRESERVE_ALL;
 }
 
+PreservedAnalyses ADCEPass::run(Function& function, AnalysisManager& analyses) {
+    std::unordered_map<Value*, Instruct*> defs{};
+    std::unordered_set<Instruct*> live{};
+    std::vector<Instruct*> work{};
+    for (auto& block : function.blocks()) {
+        for (auto& instruct : block->instructions()) {
+            if (instruct->defines()) {
+                defs.emplace(instruct->reg().get(), instruct.get());
+            }
+            switch (instruct->typeId()) {
+                case INSTRUCT_DEF:
+                case INSTRUCT_STORE:
+                case INSTRUCT_CALL:
+                case INSTRUCT_CALL_EXTERNAL:
+                case INSTRUCT_RET:
+                case INSTRUCT_BR:
+                case INSTRUCT_CONDBR:
+                    live.insert(instruct.get());
+                    work.push_back(instruct.get());
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    while (!work.empty()) {
+        auto instruct = work.back();
+        work.pop_back();
+        for (auto& use : instruct->operands()) {
+            if (auto iter = defs.find(use.get().get()); iter != defs.end() && live.insert(iter->second).second) {
+                work.push_back(iter->second);
+            }
+        }
+    }
+    // dead instructions only feed each other, unhook all of them before any is freed
+    std::size_t dead = 0;
+    for (auto& block : function.blocks()) {
+        for (auto& instruct : block->instructions()) {
+            if (!live.count(instruct.get())) {
+                instruct->dropOperands();
+                dead++;
+            }
+        }
+    }
+    if (dead == 0) {
+        return PRESERVE_ALL;
+    }
+    for (auto& block : function.blocks()) {
+        auto& instructions = block->instructions();
+        instructions.erase(std::remove_if(instructions.begin(), instructions.end(), [&live](std::shared_ptr<Instruct>& instruct) {
+            return !live.count(instruct.get());
+        }), instructions.end());
+    }
+    removed({dead, 0});
+
+    return PRESERVE_CFG;
+}
+
+PreservedAnalyses UnreachableBlockPass::run(Function& function, AnalysisManager& analyses) {
+    if (function.blocks().empty()) {
+        return PRESERVE_ALL;
+    }
+    auto& dominators = analyses.dominators(function);
+    if (dominators.order().size() == function.blocks().size()) {
+        return PRESERVE_ALL;
+    }
+    removed(eraseBlocks(function, [&dominators](Block* block) { return dominators.reachable(block); }));
+
+    return PRESERVE_NONE;
+}
+
+}
 }
-}
\ No newline at end of file
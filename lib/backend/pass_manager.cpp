@@ -0,0 +1,169 @@
+#include "pass_manager.hpp"
+#include <algorithm>
+#include <exception>
+
+namespace blang {
+namespace backend {
+
+AnalysisManager::Cache& AnalysisManager::cache(Function& function) {
+    // a prepared module never inserts, so lookups of different functions do not race
+    auto iter = _caches.find(&function);
+    if (iter == _caches.end()) {
+        iter = _caches.emplace(&function, Cache()).first;
+    }
+    return iter->second;
+}
+
+void AnalysisManager::prepare(IrModule& module) {
+    for (auto& [ident, function] : module.functions()) {
+        _caches.emplace(function.get(), Cache());
+    }
+}
+
+const DominatorTree& AnalysisManager::dominators(Function& function) {
+    auto& cache = this->cache(function);
+    if (!cache.dominators) {
+        cache.dominators = std::make_shared<DominatorTree>(function);
+    }
+    return *cache.dominators;
+}
+
+const LoopInfo& AnalysisManager::loops(Function& function) {
+    auto& cache = this->cache(function);
+    if (!cache.loops) {
+        cache.loops = std::make_shared<LoopInfo>(function, dominators(function));
+    }
+    return *cache.loops;
+}
+
+const Liveness& AnalysisManager::liveness(Function& function) {
+    auto& cache = this->cache(function);
+    if (!cache.liveness) {
+        cache.liveness = std::make_shared<Liveness>(function);
+    }
+    return *cache.liveness;
+}
+
+void AnalysisManager::invalidate(Function& function, PreservedAnalyses preserved) {
+    auto iter = _caches.find(&function);
+    if (iter == _caches.end()) {
+        return ;
+    }
+    auto& cache = iter->second;
+    if (!(preserved & ANALYSIS_DOMINATORS)) {
+        cache.dominators = nullptr;
+        cache.loops = nullptr;
+    }
+    if (!(preserved & ANALYSIS_LOOPS)) {
+        cache.loops = nullptr;
+    }
+    if (!(preserved & ANALYSIS_LIVENESS)) {
+        cache.liveness = nullptr;
+    }
+}
+
+void AnalysisManager::invalidate(IrModule& module, PreservedAnalyses preserved) {
+    for (auto& [ident, function] : module.functions()) {
+        invalidate(*function, preserved);
+    }
+}
+
+PreservedAnalyses FunctionPass::run(IrModule& module, AnalysisManager& analyses) {
+    prepare(module);
+    for (auto& [ident, function] : module.functions()) {
+        analyses.invalidate(*function, run(*function, analyses));
+    }
+    return PRESERVE_ALL;
+}
+
+void PassManager::run(IrModule& module, std::size_t workers) {
+    // large functions first, so no worker is left with one at the end
+    std::vector<Function*> functions{};
+    std::vector<std::size_t> sizes{};
+    std::size_t instructs = 0;
+    for (auto& [ident, function] : module.functions()) {
+        std::size_t size = 0;
+        for (auto& block : function->blocks()) {
+            size += block->instructions().size();
+        }
+        functions.push_back(function.get());
+        sizes.push_back(size);
+        instructs += size;
+    }
+    std::vector<std::size_t> order(functions.size());
+    for (std::size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&sizes](std::size_t a, std::size_t b) {
+        return sizes[a] > sizes[b];
+    });
+    std::vector<Function*> by_size{};
+    for (auto i : order) {
+        by_size.push_back(functions[i]);
+    }
+    workers = std::min(workers, functions.size());
+    if (instructs < PARALLEL_RUN_INSTRUCTS) {
+        workers = 1;
+    }
+    _analyses.prepare(module);
+
+    std::vector<FunctionPass*> stage{};
+    for (auto& pass : _passes) {
+        if (auto function_pass = dynamic_cast<FunctionPass*>(pass.get()); function_pass) {
+            stage.push_back(function_pass);
+            continue;
+        }
+        runStage(stage, module, by_size, workers);
+        _analyses.invalidate(module, pass->run(module, _analyses));
+        // a module pass may add functions
+        _analyses.prepare(module);
+    }
+    runStage(stage, module, by_size, workers);
+    _analyses.clear();
+}
+
+void PassManager::runStage(std::vector<FunctionPass*>& stage, IrModule& module, std::vector<Function*>& functions, std::size_t workers) {
+    if (stage.empty()) {
+        return ;
+    }
+    for (auto pass : stage) {
+        pass->prepare(module);
+    }
+    auto pipeline = [this, &stage](Function& function) {
+        for (auto pass : stage) {
+            _analyses.invalidate(function, pass->run(function, _analyses));
+        }
+    };
+    if (workers <= 1) {
+        for (auto function : functions) {
+            pipeline(*function);
+        }
+        stage.clear();
+        return ;
+    }
+
+    if (!_pool || _pool->size() != workers) {
+        _pool = std::make_unique<tools::ThreadPool>(workers);
+    }
+    // the error of the first function in submission order is reported, whichever thread hit it first
+    auto errors = std::vector<std::exception_ptr>(functions.size());
+    for (std::size_t i = 0; i < functions.size(); i++) {
+        _pool->submit([&pipeline, &functions, &errors, i](std::size_t worker) {
+            try {
+                pipeline(*functions[i]);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+    }
+    _pool->wait();
+    stage.clear();
+    for (auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+}
+}
@@ -0,0 +1,59 @@
+#include "batch_compiler.hpp"
+#include <algorithm>
+#include <exception>
+#include <thread>
+
+namespace blang {
+
+BatchCompiler::BatchCompiler(std::size_t workers, tools::LoadMode load_mode, int error_fd) : _pool(workers) {
+    // cores left over by a small batch optimize and print functions of large modules in parallel
+    auto function_workers = std::max<std::size_t>(std::thread::hardware_concurrency() / _pool.size(), 1);
+    for (std::size_t i = 0; i < _pool.size(); i++) {
+        _compilers.push_back(std::make_unique<Blang>(load_mode, function_workers));
+        _compilers.back()->logger()->setSink(error_fd);
+    }
+}
+
+void BatchCompiler::setPasses(const std::string& pipeline) {
+    for (auto& compiler : _compilers) {
+        compiler->setPasses(pipeline);
+    }
+}
+
+std::vector<std::pair<std::string, backend::PassStats>> BatchCompiler::passStats() const {
+    auto stats = _compilers.front()->passStats();
+    for (std::size_t i = 1; i < _compilers.size(); i++) {
+        auto worker_stats = _compilers[i]->passStats();
+        for (std::size_t pass = 0; pass < stats.size(); pass++) {
+            stats[pass].second.instructs += worker_stats[pass].second.instructs;
+            stats[pass].second.blocks += worker_stats[pass].second.blocks;
+        }
+    }
+    return stats;
+}
+
+std::size_t BatchCompiler::compile(std::vector<BatchJob>& jobs) {
+    for (auto& job : jobs) {
+        _pool.submit([this, &job](std::size_t worker) {
+            try {
+                _compilers[worker]->compile(job.input, job.output);
+                job.success = true;
+            } catch (std::exception& err) {
+                job.success = false;
+                job.message = err.what();
+            }
+        });
+    }
+    _pool.wait();
+
+    std::size_t failed = 0;
+    for (auto& job : jobs) {
+        if (!job.success) {
+            failed++;
+        }
+    }
+
+    return failed;
+}
+
+}
@@ -5,48 +5,37 @@
 #include <iostream>
 #include <memory>
 #include <vector>
-#include <fstream>
+#include "ir_writer.hpp"
+#include "source.hpp"
 
 namespace blang {
 
-Blang::Blang() :
+Blang::Blang(tools::LoadMode load_mode, std::size_t function_workers) :
     _logger(std::make_shared<Logger>()),
-    _lexer(_logger),
-    _parser(_logger),
-    _syntax_checker(_logger),
-    _ir_generator(_logger),
-    _optimizer()
-{}
-
-std::shared_ptr<std::vector<char>> Blang::load_file(const std::string& filename) {
-    std::ifstream file(filename, std::ios::binary);
-
-    if (!file) {
-        throw std::runtime_error("failed to open file: " + filename);
-    }
-
-    file.seekg(0, std::ios::end);
-    auto file_size = file.tellg();
-
-    if (file_size <= 0) {
-        throw std::runtime_error("file may be empty!");
-    }
-
-    file.seekg(0, std::ios::beg);
-    auto file_buffer_ptr = std::make_shared<std::vector<char>>(
-        std::vector<char>(static_cast<std::size_t>(file_size))
-        );
-    file.read(file_buffer_ptr->data(), file_size);
-
-    file.close();
-
-    return file_buffer_ptr;
+    _idents(std::make_shared<entities::IdentTable>()),
+    _arena(std::make_shared<tools::Arena>()),
+    _lexer(_logger, _idents),
+    _parser(_logger, _arena),
+    _syntax_checker(_logger, _arena),
+    _ir_generator(_logger, _arena),
+    _optimizer(),
+    _load_mode(load_mode),
+    _function_workers(function_workers)
+{
+    // nothing reads the lexer/parser dump of a compilation
+    _parser.setTraceLevel(TRACE_NONE);
 }
 
-std::shared_ptr<std::vector<char>> Blang::compile(const std::string& filename) {
-    auto file_buffer = load_file(filename);
+std::shared_ptr<std::vector<char>> Blang::compile(const std::string& filename, const std::string& output_file) {
+    _logger->clear();
+    _idents->clear();
+    _arena->reset();
+    _types.clear();
+    auto type_scope = entities::TypeContext::Scope(_types);
 
-    auto tokens = _lexer.lexTokens(file_buffer);
+    auto source = tools::SourceBuffer::load(filename, _load_mode);
+
+    auto tokens = _lexer.lexTokens(source);
 
     auto comp_unit = _parser.parse(tokens);
 
@@ -54,13 +43,11 @@ std::shared_ptr<std::vector<char>> Blang::compile(const std::string& filename) {
 
     auto llvm_module = _ir_generator.gen(global_table);
 
-    //auto optimized_module = _optimizer.optim(llvm_module);
-
-    auto output = llvm_module->to_string();
+    llvm_module = _optimizer.optim(llvm_module, _function_workers);
 
-    std::ofstream ir_out("./llvm_ir.txt");
-    ir_out << output;
-    ir_out.close();
+    auto ir_out = tools::IrWriter(output_file);
+    llvm_module->write(ir_out, _function_workers);
+    ir_out.flush();
 
     auto ret = std::make_shared<std::vector<char>>();
 
@@ -0,0 +1,31 @@
+#include "ident.hpp"
+
+namespace blang {
+
+namespace entities {
+
+IdentTable::IdentTable() {
+    clear();
+}
+
+Ident IdentTable::intern(std::string_view name) {
+    if (auto iter = _ids.find(name); iter != _ids.end()) {
+        return Ident(iter->second, &_names[iter->second]);
+    }
+
+    auto id = static_cast<uint32_t>(_names.size());
+    auto& stored = _names.emplace_back(name);
+    _ids.insert({std::string_view(stored), id});
+
+    return Ident(id, &stored);
+}
+
+void IdentTable::clear() {
+    _ids.clear();
+    _names.clear();
+    _names.emplace_back();  // id 0 is the empty ident
+}
+
+}
+
+}
@@ -1,75 +1,270 @@
 #include "ir.hpp"
 #include "type.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
 #include <memory>
+#include <optional>
 #include <string>
+#include <thread>
 
 namespace blang {
 namespace entities {
 
-std::string Block::to_string() {
-    std::string ret = _label + ":\n";
+bool Instruct::defines() {
+    switch (_type) {
+        case INSTRUCT_DEF:
+        case INSTRUCT_STORE:
+        case INSTRUCT_RET:
+        case INSTRUCT_BR:
+        case INSTRUCT_CONDBR:
+            return false;
+        default:
+            // call of a void function has no result
+            return reg() != nullptr;
+    }
+}
+
+void Instruct::dropOperands() {
+    for (auto& use : _operands) {
+        use.set(nullptr);
+    }
+}
+
+void Instruct::shrinkOperands(std::size_t size) {
+    for (auto i = size; i < _operands.size(); i++) {
+        _operands[i].set(nullptr);
+    }
+    _operands = tools::Span<Use>(_operands.data(), size);
+}
+
+void PhiInstruct::removeIncoming(std::size_t index) {
+    auto last = size() - 1;
+    if (index != last) {
+        setIncoming(index, incoming(last));
+        _blocks[index] = _blocks[last];
+    }
+    _blocks.pop_back();
+    shrinkOperands(last);
+}
+
+void BrInstruct::write(tools::IrWriter& out) {
+    out << "br label %" << _target->label();
+}
+
+void CondBrInstruct::write(tools::IrWriter& out) {
+    out << "br i1 ";
+    cond()->writeIdent(out);
+    out << ", label %" << _true_block->label() << ", label %" << _false_block->label();
+}
+
+void PhiInstruct::write(tools::IrWriter& out) {
+    _result->writeIdent(out);
+    out << " = phi ";
+    _result->getType()->write(out);
+    for (std::size_t i = 0; i < _blocks.size(); i++) {
+        out << (i > 0 ? ", [ " : " [ ");
+        incoming(i)->writeIdent(out);
+        out << ", %" << _blocks[i]->label() << " ]";
+    }
+}
+
+void writeCall(tools::IrWriter& out, const std::shared_ptr<Value>& result, std::string_view function, tools::Span<Use> params) {
+    if (result) {
+        result->writeIdent(out);
+        out << " = call ";
+        result->getType()->write(out);
+        out << ' ';
+    } else {
+        out << "call void ";
+    }
+    out << '@' << function << '(';
+    for (std::size_t i = 0; i < params.size(); i++) {
+        if (i > 0) {
+            out << ", ";
+        }
+        params[i]->write(out);
+    }
+    out << ')';
+}
+
+void Block::link(Block* to) {
+    _succs.push_back(to);
+    to->_preds.push_back(this);
+}
+
+void Block::unlink(Block* to) {
+    if (auto iter = std::find(_succs.begin(), _succs.end(), to); iter != _succs.end()) {
+        _succs.erase(iter);
+    }
+    if (auto iter = std::find(to->_preds.begin(), to->_preds.end(), this); iter != to->_preds.end()) {
+        to->_preds.erase(iter);
+    }
+}
+
+void Block::retarget(Block* from, Block* to) {
+    if (_instructions.empty()) {
+        return ;
+    }
+    auto& terminator = _instructions.back();
+    if (auto br = dyn_cast<BrInstruct>(terminator); br && br->target() == from) {
+        br->setTarget(to);
+        unlink(from);
+        link(to);
+    } else if (auto condbr = dyn_cast<CondBrInstruct>(terminator); condbr) {
+        if (condbr->true_block() == from) {
+            condbr->setTrueBlock(to);
+            unlink(from);
+            link(to);
+        }
+        if (condbr->false_block() == from) {
+            condbr->setFalseBlock(to);
+            unlink(from);
+            link(to);
+        }
+    }
+}
+
+void Block::write(tools::IrWriter& out) {
+    out << _label << ":\n";
     for (auto& instruct : _instructions) {
-        ret += "    " + instruct->to_string() + "\n";
+        out << "    ";
+        instruct->write(out);
+        out << '\n';
     }
-    return ret;
+}
+
+std::string Block::to_string() {
+    tools::IrWriter out;
+    write(out);
+    return out.take();
+}
+
+void Function::addBlock(std::shared_ptr<Block> block) {
+    _blocks.push_back(block);
+    _current_block = block;
 }
 
 void Function::addBlock(std::string label) {
     if (label.empty()) {
         label = _ident + "_label" + std::to_string(_blocks.size());
     }
-    auto block = std::make_shared<Block>(label);
-    _blocks.push_back(block);
-    _current_block = block;
+    addBlock(newBlock(label));
 }
 
-std::string Function::to_string() {
-    std::string ret = "define ";
-    ret += _ret_type->to_string() + " @" + _ident + "(";
-
-    auto param_iter = _params.begin();
-    if (!_params.empty()) {
-        while ((param_iter + 1) != _params.end()) {
-            auto [type, ident] = *param_iter;
-            ret += type->to_string() + " %" + ident + ", ";
-            param_iter++;
+void Function::numberRegs() {
+    uint64_t number = 0;
+    for (auto& block : _blocks) {
+        for (auto& instruct : block->instructions()) {
+            if (instruct->defines()) {
+                instruct->reg()->setIdent(std::to_string(number++));
+            }
         }
-        auto [type, ident] = *param_iter;
-        ret += type->to_string() + " %" + ident;
     }
-    ret += ") {\n";
+}
+
+void Function::write(tools::IrWriter& out) {
+    numberRegs();
+
+    out << "define ";
+    _ret_type->write(out);
+    out << " @" << _ident << '(';
+    for (std::size_t i = 0; i < _params.size(); i++) {
+        auto& [type, ident] = _params[i];
+        if (i > 0) {
+            out << ", ";
+        }
+        type->write(out);
+        out << " %" << ident;
+    }
+    out << ") {\n";
 
     for (auto& block : _blocks) {
-        ret += block->to_string();
+        block->write(out);
     }
 
-    ret += "}\n";
-    return ret;
+    out << "}\n";
 }
 
-std::string IrModule::to_string() {
-    std::string ret = std::string("declare i32 @getint()\n")
-                        + "declare i32 @getchar()\n"
-                        + "declare void @putint(i32)\n"
-                        + "declare void @putchar(i32)\n"
-                        + "declare void @putstr(i8*)\n";
+std::string Function::to_string() {
+    tools::IrWriter out;
+    write(out);
+    return out.take();
+}
+
+void IrModule::write(tools::IrWriter& out, std::size_t workers) {
+    out << "declare i32 @getint()\n"
+        << "declare i32 @getchar()\n"
+        << "declare void @putint(i32)\n"
+        << "declare void @putchar(i32)\n"
+        << "declare void @putstr(i8*)\n";
 
     for (auto& instruct : _global) {
-        ret += instruct->to_string() + "\n";
+        instruct->write(out);
+        out << '\n';
     }
 
-    for (auto& [type, function] : _functions) {
-        ret += function->to_string();
+    std::vector<Function*> functions{};
+    std::size_t instructs = 0;
+    for (auto& [ident, function] : _functions) {
+        functions.push_back(function.get());
+        for (auto& block : function->blocks()) {
+            instructs += block->instructions().size();
+        }
+    }
+    // starting threads costs more than printing a small module
+    workers = std::min(workers, functions.size());
+    if (workers <= 1 || instructs < PARALLEL_WRITE_INSTRUCTS) {
+        for (auto function : functions) {
+            function->write(out);
+        }
+        return ;
     }
 
-    return ret;
+    // functions only read globals and each other's names, so they print independently
+    auto buffers = std::vector<tools::IrWriter>(functions.size());
+    auto errors = std::vector<std::exception_ptr>(workers);
+    std::atomic<std::size_t> next{0};
+    auto run = [&](std::size_t worker) {
+        try {
+            for (auto i = next++; i < functions.size(); i = next++) {
+                functions[i]->write(buffers[i]);
+            }
+        } catch (...) {
+            errors[worker] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> threads{};
+    for (std::size_t worker = 1; worker < workers; worker++) {
+        threads.emplace_back(run, worker);
+    }
+    run(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    for (auto& buffer : buffers) {
+        out << buffer.str();
+    }
+}
+
+std::string IrModule::to_string() {
+    tools::IrWriter out;
+    write(out);
+    return out.take();
 }
 
 void IrFactory::addDefInstruct(bool is_const, std::shared_ptr<PtrValue> var, std::shared_ptr<Value> init) {
     if (!_module->current_block()) {
         _module->global().push_back(std::make_shared<DefInstruct>(is_const, var, init));
     } else {
-        _module->current_block()->push_back(std::make_shared<DefInstruct>(is_const, var, init));
+        push(std::make_shared<DefInstruct>(is_const, var, init));
     }
 }
 
@@ -81,111 +276,245 @@ void IrFactory::addFunction(Type* ret_type, std::string ident, std::vector<std::
 }
 
 void IrFactory::addLoadInstruct(std::shared_ptr<Value> from, std::shared_ptr<Value> to) {
-    _module->current_block()->push_back(std::make_shared<LoadInstruct>(from, to));
+    push(std::make_shared<LoadInstruct>(from, to));
 }
 
 void IrFactory::addStoreInstruct(std::shared_ptr<Value> from, std::shared_ptr<PtrValue> to) {
-    _module->current_block()->push_back(std::make_shared<StoreInstruct>(from, to));
+    push(std::make_shared<StoreInstruct>(from, to));
 }
 
 void IrFactory::addAllocaInstruct(std::shared_ptr<PtrValue> var) {
-    _module->current_block()->push_back(std::make_shared<AllocaInstruct>(var));
+    push(std::make_shared<AllocaInstruct>(var));
 }
 
 void IrFactory::addAddInstruct(std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) {
-    _module->current_block()->push_back(std::make_shared<AddInstruct>(reg, left, right));
+    addBinary<AddInstruct>(INSTRUCT_ADD, reg, left, right);
 }
 
 void IrFactory::addSubInstruct(std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) {
-    _module->current_block()->push_back(std::make_shared<SubInstruct>(reg, left, right));
+    addBinary<SubInstruct>(INSTRUCT_SUB, reg, left, right);
 }
 
 void IrFactory::addMulInstruct(std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) {
-    _module->current_block()->push_back(std::make_shared<MulInstruct>(reg, left, right));
+    addBinary<MulInstruct>(INSTRUCT_MUL, reg, left, right);
 }
 
 void IrFactory::addDivInstruct(std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) {
-    _module->current_block()->push_back(std::make_shared<DivInstruct>(reg, left, right));
+    addBinary<DivInstruct>(INSTRUCT_DIV, reg, left, right);
 }
 
 void IrFactory::addModInstruct(std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) {
-    _module->current_block()->push_back(std::make_shared<ModInstruct>(reg, left, right));
+    addBinary<ModInstruct>(INSTRUCT_MOD, reg, left, right);
 }
 
 void IrFactory::addRetInstruct(std::shared_ptr<Value> ret_value) {
-    _module->current_block()->push_back(std::make_shared<RetInstruct>(ret_value));
+    push(std::make_shared<RetInstruct>(ret_value));
     _module->current_block()->ended() = true;
 }
 
 void IrFactory::addCallInstruct(std::shared_ptr<Value> result, std::shared_ptr<Function> function, std::vector<std::shared_ptr<Value>> params) {
-    _module->current_block()->push_back(std::make_shared<CallInstruct>(result, function, params));
+    push(std::make_shared<CallInstruct>(result, function, params));
 }
 
 void IrFactory::addAndInstruct(std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) {
-    _module->current_block()->push_back(std::make_shared<AndInstruct>(reg, left, right));
+    addBinary<AndInstruct>(INSTRUCT_AND, reg, left, right);
 }
 
 void IrFactory::addOrInstruct(std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) {
-    _module->current_block()->push_back(std::make_shared<OrInstruct>(reg, left, right));
+    addBinary<OrInstruct>(INSTRUCT_OR, reg, left, right);
 }
 
 void IrFactory::addEqInstruct(std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) {
-    _module->current_block()->push_back(std::make_shared<EqInstruct>(reg, left, right));
+    addBinary<EqInstruct>(INSTRUCT_EQ, reg, left, right);
 }
 
 void IrFactory::addNeqInstruct(std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) {
-    _module->current_block()->push_back(std::make_shared<NeqInstruct>(reg, left, right));
+    addBinary<NeqInstruct>(INSTRUCT_NEQ, reg, left, right);
 }
 
 void IrFactory::addGeInstruct(std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) {
-    _module->current_block()->push_back(std::make_shared<GeInstruct>(reg, left, right));
+    addBinary<GeInstruct>(INSTRUCT_GE, reg, left, right);
 }
 
 void IrFactory::addGtInstruct(std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) {
-    _module->current_block()->push_back(std::make_shared<GtInstruct>(reg, left, right));
+    addBinary<GtInstruct>(INSTRUCT_GT, reg, left, right);
 }
 
 void IrFactory::addLtInstruct(std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) {
-    _module->current_block()->push_back(std::make_shared<LtInstruct>(reg, left, right));
+    addBinary<LtInstruct>(INSTRUCT_LT, reg, left, right);
 }
 
 void IrFactory::addLeInstruct(std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) {
-    _module->current_block()->push_back(std::make_shared<LeInstruct>(reg, left, right));
+    addBinary<LeInstruct>(INSTRUCT_LE, reg, left, right);
 }
 
 void IrFactory::addGepInstruct(std::shared_ptr<PtrValue> result, std::shared_ptr<PtrValue> ptr, std::shared_ptr<IntConstValue> elem, std::shared_ptr<IntConstValue> offset) {
-    _module->current_block()->push_back(std::make_shared<GEPInstruct>(result, ptr, elem, offset));
+    push(std::make_shared<GEPInstruct>(result, ptr, elem, offset));
 }
 
-void IrFactory::addBrInstruct(std::string label) {
-    _module->current_block()->next().push_back(label);
-    _module->current_block()->push_back(std::make_shared<BrInstruct>(label));
-    _module->current_block()->ended() = true;
+void IrFactory::addBrInstruct(const std::shared_ptr<Block>& target) {
+    auto block = _module->current_block();
+    if (push(std::make_shared<BrInstruct>(target.get()))) {
+        block->link(target.get());
+    }
+    block->ended() = true;
 }
 
-void IrFactory::addCondBrInstruct(std::shared_ptr<Value> cond, std::string true_label, std::string false_label) {
-    _module->current_block()->next().push_back(true_label);
-    _module->current_block()->next().push_back(false_label);
-    _module->current_block()->push_back(std::make_shared<CondBrInstruct>(cond, true_label, false_label));
-    _module->current_block()->ended() = true;
+void IrFactory::addCondBrInstruct(std::shared_ptr<Value> cond, const std::shared_ptr<Block>& true_block, const std::shared_ptr<Block>& false_block) {
+    auto block = _module->current_block();
+    if (push(std::make_shared<CondBrInstruct>(cond, true_block.get(), false_block.get()))) {
+        block->link(true_block.get());
+        block->link(false_block.get());
+    }
+    block->ended() = true;
 }
 
 void IrFactory::addSextInstruct(std::shared_ptr<Value> result, std::shared_ptr<Value> operand) {
-    _module->current_block()->push_back(std::make_shared<SextInstruct>(result, operand));
+    addCast<SextInstruct>(INSTRUCT_SEXT, result, operand);
 }
 
 void IrFactory::addZextInstruct(std::shared_ptr<Value> result, std::shared_ptr<Value> operand) {
-    _module->current_block()->push_back(std::make_shared<ZextInstruct>(result, operand));
+    addCast<ZextInstruct>(INSTRUCT_ZEXT, result, operand);
 }
 
 void IrFactory::addTruncInstruct(std::shared_ptr<Value> result, std::shared_ptr<Value> operand) {
-    _module->current_block()->push_back(std::make_shared<TruncInstruct>(result, operand));
+    addCast<TruncInstruct>(INSTRUCT_TRUNC, result, operand);
 }
 
 void IrFactory::addCallExternalInstruct(std::shared_ptr<Value> result, std::string function, std::vector<std::shared_ptr<Value>> params) {
-    _module->current_block()->push_back(std::make_shared<CallExternalInstruct>(result, function, params));
+    push(std::make_shared<CallExternalInstruct>(result, function, params));
 }
 
+bool IrFactory::push(std::shared_ptr<Instruct> instruct) {
+    _last = instruct->reg();
+    return _module->current_block()->push_back(instruct);
 }
 
-}
\ No newline at end of file
+std::optional<int32_t> constValue(const std::shared_ptr<Value>& value) {
+    if (auto int_v = dynamic_cast<IntConstValue*>(value.get()); int_v) {
+        return int_v->value();
+    } else if (auto char_v = dynamic_cast<CharConstValue*>(value.get()); char_v) {
+        return char_v->value();
+    } else if (auto bool_v = dynamic_cast<BoolConstValue*>(value.get()); bool_v) {
+        return bool_v->value() ? -1 : 0;
+    }
+    return std::nullopt;
+}
+
+std::shared_ptr<Value> makeConst(Type* type, int32_t value) {
+    if (Type::is_same(type, CharType::get())) {
+        return std::make_shared<CharConstValue>(static_cast<char>(value));
+    } else if (Type::is_same(type, BoolType::get())) {
+        return std::make_shared<BoolConstValue>(value & 1);
+    }
+    return std::make_shared<IntConstValue>(value);
+}
+
+std::optional<int32_t> foldConstants(InstructType type, Type* result_t, int32_t left, int32_t right) {
+    // wrap like llvm instead of overflowing
+    auto ul = static_cast<uint32_t>(left);
+    auto ur = static_cast<uint32_t>(right);
+    switch (type) {
+        case INSTRUCT_ADD:  return static_cast<int32_t>(ul + ur);
+        case INSTRUCT_SUB:  return static_cast<int32_t>(ul - ur);
+        case INSTRUCT_MUL:  return static_cast<int32_t>(ul * ur);
+        case INSTRUCT_DIV:
+        case INSTRUCT_MOD:
+            // keep the trap of the program
+            if (right == 0 || (right == -1 && (left == INT32_MIN || (Type::is_same(result_t, CharType::get()) && left == INT8_MIN)))) {
+                return std::nullopt;
+            }
+            return type == INSTRUCT_DIV ? left / right : left % right;
+        case INSTRUCT_AND:  return left & right;
+        case INSTRUCT_OR:   return left | right;
+        case INSTRUCT_EQ:   return left == right;
+        case INSTRUCT_NEQ:  return left != right;
+        case INSTRUCT_GE:   return left >= right;
+        case INSTRUCT_GT:   return left >  right;
+        case INSTRUCT_LE:   return left <= right;
+        case INSTRUCT_LT:   return left <  right;
+        default:
+            return std::nullopt;
+    }
+}
+
+int32_t foldConstantCast(InstructType type, Type* operand_t, int32_t value) {
+    if (type == INSTRUCT_ZEXT) {
+        if (Type::is_same(operand_t, CharType::get())) {
+            return static_cast<uint8_t>(value);
+        } else if (Type::is_same(operand_t, BoolType::get())) {
+            return value & 1;
+        }
+    }
+    return value;
+}
+
+std::shared_ptr<Value> IrFactory::foldBinary(InstructType type, std::shared_ptr<Value> reg, std::shared_ptr<Value> left, std::shared_ptr<Value> right) {
+    auto result_t = reg->getType();
+    auto l = constValue(left);
+    auto r = constValue(right);
+
+    if (l && r) {
+        auto folded = foldConstants(type, result_t, *l, *r);
+        return folded ? makeConst(result_t, *folded) : nullptr;
+    }
+
+    // identities, the remaining operand must already be of result type
+    auto left_same = Type::is_same(left->getType(), result_t);
+    auto right_same = Type::is_same(right->getType(), result_t);
+    switch (type) {
+        case INSTRUCT_ADD:
+        case INSTRUCT_OR:
+            if (r && *r == 0 && left_same) {
+                return left;
+            } else if (l && *l == 0 && right_same) {
+                return right;
+            }
+            break;
+        case INSTRUCT_SUB:
+            if (r && *r == 0 && left_same) {
+                return left;
+            }
+            break;
+        case INSTRUCT_MUL:
+            if ((r && *r == 0) || (l && *l == 0)) {
+                return makeConst(result_t, 0);
+            } else if (r && *r == 1 && left_same) {
+                return left;
+            } else if (l && *l == 1 && right_same) {
+                return right;
+            }
+            break;
+        case INSTRUCT_DIV:
+            if (r && *r == 1 && left_same) {
+                return left;
+            }
+            break;
+        case INSTRUCT_MOD:
+            if (r && *r == 1) {
+                return makeConst(result_t, 0);
+            }
+            break;
+        case INSTRUCT_AND:
+            if ((r && *r == 0) || (l && *l == 0)) {
+                return makeConst(result_t, 0);
+            }
+            break;
+        default:
+            break;
+    }
+
+    return nullptr;
+}
+
+std::shared_ptr<Value> IrFactory::foldCast(InstructType type, std::shared_ptr<Value> result, std::shared_ptr<Value> operand) {
+    auto value = constValue(operand);
+    if (!value) {
+        return nullptr;
+    }
+    return makeConst(result->getType(), foldConstantCast(type, operand->getType(), *value));
+}
+
+}
+
+}
@@ -7,120 +7,95 @@ namespace blang {
 
 namespace entities {
 
-Var::~Var() {
-    if (Type::is_same(_type, IntType::get())) {
-        delete (int32_t*) _content;
-    } else if (Type::is_same(_type, CharType::get())) {
-        delete (char*) _content;
-    } else if (auto array_t = dynamic_cast<ArrayType*>(_type); array_t) {
-        if (Type::is_same(array_t->type(), IntType::get())) {
-            delete [] (int32_t*) _content;
-        } else if (Type::is_same(array_t->type(), CharType::get())) {
-            delete [] (char*) _content;
-        }
-    } else if (auto ptr_t = dynamic_cast<PtrType*>(_type); ptr_t) {
-        if (Type::is_same(ptr_t->next(), IntType::get())) {
-            delete [] (int32_t**) _content;
-        } else if (Type::is_same(ptr_t->next(), CharType::get())) {
-            delete [] (char**) _content;
-        }
-    }
+void SymbolTable::pushScope() {
+    _scopes.push_back({_next_blockn++, static_cast<uint32_t>(_locals.size())});
 }
 
-uint32_t SymbolTable::_block_counter = 1;
-
-bool SymbolTable::add(std::shared_ptr<Symbol> symbol) {
-    if (auto s = get(symbol->ident()); s == nullptr) {
-        _symbol_order.push_back(symbol->ident());
-        _symbols.insert({symbol->ident(), symbol});
-        return true;
+void SymbolTable::popScope() {
+    auto begin = _scopes.back().locals;
+    while (_locals.size() > begin) {
+        auto& local = _locals.back();
+        setSlot(_local_slots, local.var->ident(), local.shadowed);
+        _locals.pop_back();
     }
-
-    return false;
+    _scopes.pop_back();
 }
 
-std::shared_ptr<Symbol> SymbolTable::get(const std::string& ident) {
-    if (auto iter = _symbols.find(ident); iter != _symbols.end()) {
-        return iter->second;
+bool SymbolTable::contains(Ident ident) {
+    if (_scopes.empty()) {
+        return slot(_global_slots, ident) != NONE;
     }
-    
-    return nullptr;
+    auto index = slot(_local_slots, ident);
+    return index != NONE && _locals[index].depth == depth();
 }
 
-std::vector<std::shared_ptr<Var>> SymbolTable::getVars() {
-    std::vector<std::shared_ptr<Var>> ret{};
-    for (auto& [ident, symbol] : _symbols) {
-        if (auto var = std::dynamic_pointer_cast<Var>(symbol); var) {
-            ret.push_back(var);
-        }
+bool SymbolTable::addVar(std::shared_ptr<Var> var) {
+    if (contains(var->ident())) {
+        return false;
     }
 
-    return ret;
-}
-
-std::vector<std::shared_ptr<Func>> SymbolTable::getFuncs() {
-    std::vector<std::shared_ptr<Func>> ret{};
-    for (auto& ident : _symbol_order) {
-        if (auto func = std::dynamic_pointer_cast<Func>(_symbols.at(ident)); func) {
-            ret.push_back(func);
-        }
+    if (_scopes.empty()) {
+        setSlot(_global_slots, var->ident(), static_cast<uint32_t>(_globals.size()));
+        _globals.push_back({var, nullptr});
+    } else {
+        auto shadowed = slot(_local_slots, var->ident());
+        setSlot(_local_slots, var->ident(), static_cast<uint32_t>(_locals.size()));
+        _locals.push_back({var, depth(), shadowed});
     }
 
-    return ret;
-}
-
-bool GlobalSymbolTable::addVar(std::shared_ptr<Var> var) {
-    return add(var);
+    return true;
 }
 
-bool GlobalSymbolTable::addFunc(std::shared_ptr<Func> func) {
-    return add(func);
-}
+bool SymbolTable::addFunc(std::shared_ptr<Func> func) {
+    if (slot(_global_slots, func->ident()) != NONE) {
+        return false;
+    }
 
-std::shared_ptr<Func> GlobalSymbolTable::getFunc(const std::string& ident) {
-    return std::dynamic_pointer_cast<Func>(get(ident));
-}
+    setSlot(_global_slots, func->ident(), static_cast<uint32_t>(_globals.size()));
+    _globals.push_back({nullptr, func});
 
-std::shared_ptr<Var> GlobalSymbolTable::getVar(const std::string& ident) {
-    return std::dynamic_pointer_cast<Var>(get(ident));
+    return true;
 }
 
-std::shared_ptr<GlobalSymbolTable> BlockSymbolTable::getGlobal() {
-    auto table = _base;
-    std::shared_ptr<BlockSymbolTable> block;
-    while ((block = std::dynamic_pointer_cast<BlockSymbolTable>(table)) != nullptr) {
-        table = block->_base;
+std::shared_ptr<Var> SymbolTable::getVar(Ident ident) {
+    if (auto index = slot(_local_slots, ident); index != NONE) {
+        return _locals[index].var;
+    }
+    if (auto index = slot(_global_slots, ident); index != NONE) {
+        return _globals[index].var;
     }
 
-    return std::dynamic_pointer_cast<GlobalSymbolTable>(table);
+    return nullptr;
 }
 
-bool BlockSymbolTable::addFunc(std::shared_ptr<Func> func) {
-    return getGlobal()->addFunc(func);
-}
+std::shared_ptr<Func> SymbolTable::getFunc(Ident ident) {
+    if (auto index = slot(_global_slots, ident); index != NONE) {
+        return _globals[index].func;
+    }
 
-std::shared_ptr<Func> BlockSymbolTable::getFunc(const std::string& ident) {
-    return getGlobal()->getFunc(ident);
+    return nullptr;
 }
 
-bool BlockSymbolTable::addVar(std::shared_ptr<Var> var) {
-    return add(var);
+std::vector<std::shared_ptr<Var>> SymbolTable::getVars() {
+    std::vector<std::shared_ptr<Var>> ret{};
+    for (auto& global : _globals) {
+        if (global.var) {
+            ret.push_back(global.var);
+        }
+    }
+
+    return ret;
 }
 
-std::shared_ptr<Var> BlockSymbolTable::getVar(const std::string& ident) {
-    if (auto var = std::dynamic_pointer_cast<Var>(get(ident)); var) {
-        return var;
-    }
-    auto table = _base;
-    std::shared_ptr<BlockSymbolTable> block;
-    while ((block = std::dynamic_pointer_cast<BlockSymbolTable>(table)) != nullptr) {
-        if (auto var = block->getVar(ident); var) {
-            return var;
+std::vector<std::shared_ptr<Func>> SymbolTable::getFuncs() {
+    std::vector<std::shared_ptr<Func>> ret{};
+    for (auto& global : _globals) {
+        if (global.func) {
+            ret.push_back(global.func);
         }
-        table = block->_base;
     }
 
-    return std::dynamic_pointer_cast<GlobalSymbolTable>(table)->getVar(ident);
+    return ret;
 }
 
 }
@@ -0,0 +1,111 @@
+#include "type.hpp"
+#include <mutex>
+
+namespace blang {
+
+namespace entities {
+
+thread_local TypeContext* TypeContext::_current = nullptr;
+
+PtrType* TypeContext::ptr(Type* type) {
+    auto key = Key{DERIVED_PTR, type, 0};
+    if (auto iter = _types.find(key); iter != _types.end()) {
+        return static_cast<PtrType*>(iter->second.get());
+    }
+
+    auto ptr_t = new PtrType(type);
+    _types.emplace(key, std::unique_ptr<Type>(ptr_t));
+    return ptr_t;
+}
+
+ArrayType* TypeContext::array(Type* type, uint32_t length) {
+    auto key = Key{DERIVED_ARRAY, type, length};
+    if (auto iter = _types.find(key); iter != _types.end()) {
+        return static_cast<ArrayType*>(iter->second.get());
+    }
+
+    auto array_t = new ArrayType(type, length);
+    _types.emplace(key, std::unique_ptr<Type>(array_t));
+    return array_t;
+}
+
+TypeContext* TypeContext::current() {
+    if (!_current) {
+        throw std::runtime_error("No type context installed on current thread!");
+    }
+    return _current;
+}
+
+/**
+ * @brief Guards use lists of shared values, few values are shared so one lock is enough
+ * 
+ */
+static std::mutex shared_uses_mutex;
+
+void Use::link() {
+    if (!_value) {
+        return ;
+    }
+    auto lock = _value->_shared ? std::unique_lock<std::mutex>(shared_uses_mutex) : std::unique_lock<std::mutex>();
+    _next = _value->_uses;
+    if (_next) {
+        _next->_prev = &_next;
+    }
+    _prev = &_value->_uses;
+    _value->_uses = this;
+}
+
+void Use::unlink() {
+    // neighbours unlinking on other threads rewrite _prev, read it under the lock
+    auto lock = _value && _value->_shared ? std::unique_lock<std::mutex>(shared_uses_mutex) : std::unique_lock<std::mutex>();
+    if (!_prev) {
+        return ;
+    }
+    *_prev = _next;
+    if (_next) {
+        _next->_prev = _prev;
+    }
+    _next = nullptr;
+    _prev = nullptr;
+}
+
+void Use::init(Instruct* user, std::shared_ptr<Value> value) {
+    _user = user;
+    set(std::move(value));
+}
+
+void Use::set(std::shared_ptr<Value> value) {
+    unlink();
+    _value = std::move(value);
+    link();
+}
+
+std::size_t Value::numUses() {
+    std::size_t ret = 0;
+    for (auto use = _uses; use; use = use->_next) {
+        ret++;
+    }
+
+    return ret;
+}
+
+void Value::replaceAllUsesWith(std::shared_ptr<Value> with) {
+    if (with.get() == this) {
+        return ;
+    }
+    // uses may hold the last reference to this value, keep it alive until the list is empty
+    std::shared_ptr<Value> keep = nullptr;
+    while (_uses) {
+        auto use = _uses;
+        use->unlink();
+        if (!keep) {
+            keep = std::move(use->_value);
+        }
+        use->_value = with;
+        use->link();
+    }
+}
+
+}
+
+}
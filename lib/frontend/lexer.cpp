@@ -1,22 +1,106 @@
 #include "lexer.hpp"
 #include "buaa.hpp"
 #include "logger.hpp"
+#include "scan.hpp"
 #include "token.hpp"
 
-#include <cctype>
-#include <map>
+#include <array>
+#include <cstdint>
 #include <memory>
+#include <string_view>
 #include <vector>
 
 namespace blang {
 
 namespace frontend {
 
+namespace {
+
+/**
+ * @brief Character classes driving the scanner
+ * 
+ */
+enum CharClass : uint8_t {
+    CLASS_OTHER, CLASS_BLANK, CLASS_LF, CLASS_CR, CLASS_DIGIT, CLASS_ALPHA,
+    CLASS_SINGLE, CLASS_SLASH, CLASS_OPERATOR, CLASS_QUOTE, CLASS_APOS, CLASS_NUL,
+};
+
+constexpr std::array<uint8_t, 256> buildCharClasses() {
+    std::array<uint8_t, 256> table{};
+    for (int c = 'a'; c <= 'z'; c++) table[c] = CLASS_ALPHA;
+    for (int c = 'A'; c <= 'Z'; c++) table[c] = CLASS_ALPHA;
+    for (int c = '0'; c <= '9'; c++) table[c] = CLASS_DIGIT;
+    table['_'] = CLASS_ALPHA;
+    table[' '] = table['\t'] = table['\b'] = CLASS_BLANK;
+    table['\n'] = CLASS_LF;
+    table['\r'] = CLASS_CR;
+    for (char c : {'+', '-', '*', '%', '(', ')', '[', ']', '{', '}', ';', ','}) {
+        table[static_cast<uint8_t>(c)] = CLASS_SINGLE;
+    }
+    table['/'] = CLASS_SLASH;
+    for (char c : {'!', '&', '|', '=', '>', '<'}) {
+        table[static_cast<uint8_t>(c)] = CLASS_OPERATOR;
+    }
+    table['"'] = CLASS_QUOTE;
+    table['\''] = CLASS_APOS;
+    table['\0'] = CLASS_NUL;
+    return table;
+}
+
+constexpr std::array<bool, 256> buildIdentChars() {
+    std::array<bool, 256> table{};
+    for (int c = 'a'; c <= 'z'; c++) table[c] = true;
+    for (int c = 'A'; c <= 'Z'; c++) table[c] = true;
+    for (int c = '0'; c <= '9'; c++) table[c] = true;
+    table['_'] = true;
+    return table;
+}
+
+/**
+ * @brief Token of a single character, or of an operator not followed by '='
+ * 
+ */
+constexpr std::array<TokenType, 256> buildSingleTokens() {
+    std::array<TokenType, 256> table{};
+    for (auto& type : table) type = EOF_TOKEN;
+    table['+'] = ADD; table['-'] = MINUS; table['*'] = MULTIPLY;
+    table['/'] = DIVIDE; table['%'] = MOD;
+    table['('] = LEFT_BRACE; table[')'] = RIGHT_BRACE;
+    table['['] = LEFT_SQUARE; table[']'] = RIGHT_SQUARE;
+    table['{'] = LEFT_BRAKET; table['}'] = RIGHT_BRAKET;
+    table[';'] = SEMICOLON; table[','] = COMMA;
+    table['!'] = NOT; table['='] = ASSIGN;
+    table['>'] = GREATER; table['<'] = LESSER;
+    return table;
+}
+
+/**
+ * @brief Token of an operator followed by '='
+ * 
+ */
+constexpr std::array<TokenType, 256> buildEqualTokens() {
+    std::array<TokenType, 256> table{};
+    for (auto& type : table) type = EOF_TOKEN;
+    table['!'] = NOT_EQUAL; table['='] = EQUAL;
+    table['>'] = GREATER_EQUAL; table['<'] = LESSER_EQUAL;
+    return table;
+}
+
+constexpr auto char_classes = buildCharClasses();
+constexpr auto ident_chars = buildIdentChars();
+constexpr auto single_tokens = buildSingleTokens();
+constexpr auto equal_tokens = buildEqualTokens();
+
+struct Keyword {
+    std::string_view text;
+    TokenType type;
+};
+
 /**
  * @brief Keywords to token enum
  * 
  */
-std::map<std::string, TokenType> keyword_map = {
+constexpr Keyword keywords[] = {
     {"int", INT},
     {"char", CHAR},
     {"void", VOID},
@@ -33,220 +117,218 @@ std::map<std::string, TokenType> keyword_map = {
     {"main", MAIN},
 };
 
-Lexer::Lexer(std::shared_ptr<Logger> logger) {
+constexpr uint32_t KEYWORD_SLOTS = 16;
+
+/**
+ * @brief Hash on length, first and last character, perfect for keywords
+ * 
+ */
+constexpr uint32_t keywordHash(std::string_view text) {
+    return (static_cast<uint32_t>(text.size())
+            + static_cast<uint8_t>(text.front())
+            + 12u * static_cast<uint8_t>(text.back())) % KEYWORD_SLOTS;
+}
+
+constexpr std::array<Keyword, KEYWORD_SLOTS> buildKeywordTable() {
+    std::array<Keyword, KEYWORD_SLOTS> table{};
+    for (auto& slot : table) slot = {"", IDENT};
+    for (auto& keyword : keywords) {
+        table[keywordHash(keyword.text)] = keyword;
+    }
+    return table;
+}
+
+constexpr bool keywordHashIsPerfect() {
+    bool used[KEYWORD_SLOTS] = {};
+    for (auto& keyword : keywords) {
+        auto slot = keywordHash(keyword.text);
+        if (used[slot]) return false;
+        used[slot] = true;
+    }
+    return true;
+}
+
+static_assert(keywordHashIsPerfect(), "keyword hash collides, adjust keywordHash");
+
+constexpr auto keyword_table = buildKeywordTable();
+
+}
+
+Lexer::Lexer(std::shared_ptr<Logger> logger, std::shared_ptr<entities::IdentTable> idents) {
     _logger = logger;
-    _pos = 0;
+    _idents = idents;
     _line = 1;
 }
 
-std::shared_ptr<std::vector<Token>> Lexer::lexTokens(std::shared_ptr<std::vector<char>> input_buffer) {
+std::shared_ptr<std::vector<Token>> Lexer::lexTokens(std::shared_ptr<tools::SourceBuffer> source) {
     auto tokens = std::make_shared<std::vector<Token>>();
-    _buffer = input_buffer;
-    _pos = 0;
+    _source = source;
+    _cur = source->data();
+    _end = _cur + source->size();
     _line = 1;
-
-    while (!atEnd()) {
-        while ((current() == ' ' || current() == '\t' || current() == '\b') && !atEnd()) {
-            step();
-        }
-        if (current() == '\n' || current() == '\r') {
-            if (current() == '\r') step();
-            step();
-            _line++;
-            continue;
-        }
-        if (atEnd()) {
-            break;
-        }
-        // clear comments
-        if (current() == '/') {
-            if (peak() == '/') {
-                while (peak() != '\n' && peak() != '\r' && !atEnd()) {
-                    step();
+    tokens->reserve(source->size() / 8);
+
+    while (true) {
+        switch (char_classes[static_cast<uint8_t>(*_cur)]) {
+            case CLASS_BLANK:
+            case CLASS_LF:
+                // single separators are common, only hand longer runs to the kernel
+                _line += *_cur == '\n';
+                _cur++;
+                if (auto next = char_classes[static_cast<uint8_t>(*_cur)];
+                    next == CLASS_BLANK || next == CLASS_LF) {
+                    _cur = scan::skipBlank(_cur, _end, _line);
                 }
-                if (peak() == '\r') step();
-                step();
-                continue;
-            } else if (peak() == '*') {
-                step();
-                while (true) {
-                    if (current() == '\n' || current() == '\r') {
-                        if (current() == '\r') step();
-                        _line++;
-                    }
-                    if (peak() == '*') {
-                        step();
-                        if (peak() == '/') {
-                            step();
-                            break;
-                        }
-                        continue;
-                    }
-                    step();
+                break;
+            case CLASS_CR:
+                _cur += _cur[1] == '\n' ? 2 : 1;
+                _line++;
+                break;
+            case CLASS_SLASH:
+                if (_cur[1] == '/') {
+                    skipLineComment();
+                } else if (_cur[1] == '*') {
+                    skipBlockComment();
+                } else {
+                    tokens->push_back(lexToken());
                 }
-                step();
-                continue;
-            }
+                break;
+            case CLASS_NUL:
+                if (atEnd()) {
+                    return tokens;
+                }
+                tokens->push_back(lexToken());
+                break;
+            default:
+                tokens->push_back(lexToken());
+                break;
         }
-        tokens->push_back(lexToken());
-        step();
     }
+}
 
-    return tokens;
+void Lexer::skipLineComment() {
+    _cur = scan::findLineBreak(_cur + 2, _end);
+}
+
+void Lexer::skipBlockComment() {
+    auto p = scan::findCommentEnd(_cur + 2, _end, _line);
+    _cur = p < _end ? p + 2 : _end;
 }
 
 Token Lexer::lexToken() {
-    auto ch = current();
-
-    switch (ch) {
-        case '+': return {ADD, "+", _line};
-        case '-': return {MINUS, "-", _line};
-        case '*': return {MULTIPLY, "*", _line};
-        case '%': return {MOD, "%", _line};
-        case '/': return {DIVIDE, "/", _line,};
-
-        case '!': {
-            if (peak() == '=') {
-                step();
-                return {NOT_EQUAL, "!=", _line};
+    auto begin = _cur;
+    auto ch = static_cast<uint8_t>(*_cur);
+
+    switch (char_classes[ch]) {
+        case CLASS_SINGLE:
+        case CLASS_SLASH:
+            _cur++;
+            return {single_tokens[ch], std::string_view(begin, 1), _line};
+
+        case CLASS_OPERATOR: {
+            if (ch == '&' || ch == '|') {
+                auto and_op = ch == '&';
+                if (_cur[1] == ch) {
+                    _cur += 2;
+                } else {
+                    _cur++;
+                    if (and_op) {
+                        _logger->logError(_line, "& error", buaa::ERROR_LOGICAL_AND);
+                    } else {
+                        _logger->logError(_line, "| error", buaa::ERROR_LOGICAL_OR);
+                    }
+                }
+                return and_op ? Token{AND, "&&", _line} : Token{OR, "||", _line};
             }
-            return {NOT, "!", _line};
-        }
-
-        case '&': {
-            if (peak() == '&') {
-                step();
-            } else {
-                _logger->logError(std::make_shared<ErrorLog>(_line, "& error", buaa::ERROR_LOGICAL_AND));
+            if (_cur[1] == '=') {
+                _cur += 2;
+                return {equal_tokens[ch], std::string_view(begin, 2), _line};
             }
-            return {AND, "&&", _line};
+            _cur++;
+            return {single_tokens[ch], std::string_view(begin, 1), _line};
         }
-        case '|': {
-            if (peak() == '|') {
-                step();
-            } else {
-                _logger->logError(std::make_shared<ErrorLog>(_line, "| error", buaa::ERROR_LOGICAL_OR));
-            }
-            return {OR, "||", _line};
+
+        case CLASS_QUOTE: {
+            auto str = lexString();
+            return {STRING, str, _line};
         }
 
-        case '=': {
-            if (peak() == '=') {
-                step();
-                return {EQUAL, "==", _line};
-            } else {
-                return {ASSIGN, "=", _line};
-            }
+        case CLASS_APOS: {
+            auto str = lexChar();
+            return {CHAR_CONSTANT, str, _line};
         }
 
-        case '>': {
-            if (peak() == '=') {
-                step();
-                return {GREATER_EQUAL, ">=", _line};
-            } else {
-                return {GREATER, ">", _line};
-            }
+        case CLASS_DIGIT: {
+            auto number = lexNumber();
+            return {INT_CONSTANT, number, _line};
         }
-        case '<': {
-            if (peak() == '=') {
-                step();
-                return {LESSER_EQUAL, "<=", _line};
-            } else {
-                return {LESSER, "<", _line};
+
+        case CLASS_ALPHA: {
+            auto ident = lexIdent();
+            auto type = matchKeyword(ident);
+            if (type != IDENT) {
+                return {type, ident, _line};
             }
+            return {IDENT, ident, _line, _idents->intern(ident)};
         }
 
-        case '(': return {LEFT_BRACE, "(", _line};
-        case ')': return {RIGHT_BRACE, ")", _line};
-        case '[': return {LEFT_SQUARE, "[", _line};
-        case ']': return {RIGHT_SQUARE, "]", _line};
-        case '{': return {LEFT_BRAKET, "{", _line};
-        case '}': return {RIGHT_BRAKET, "}", _line};
-        case ';': return {SEMICOLON, ";", _line};
-        case ',': return {COMMA, ",", _line};
-
-        case '"':
-            return {STRING, lexString(), _line};
-
-        case '\'':
-            return {CHAR_CONSTANT, lexChar(), _line};
-
         default:
-            if (ch >= '0' && ch <= '9') {
-                auto number = lexNumber();
-                return {INT_CONSTANT, number, _line};
-            }
-
-            if (std::isalpha(ch) || ch == '_') {
-                auto ident = lexIdent();
-                auto match = matchKeyword(ident);
-                if (match.type != IDENT) {
-                    return match;
-                }
-                else return {IDENT, ident, _line};
-            }
-
+            break;
     }
 
+    _cur++;
     return {EOF_TOKEN, "", _line};
 }
 
-Token Lexer::matchKeyword(const std::string& ident) {
-    auto iter = keyword_map.find(ident);
-    if (iter != keyword_map.end()) {
-        return {iter->second, iter->first, _line};
-    } else {
-        return {IDENT, ident, _line};
-    }
+TokenType Lexer::matchKeyword(std::string_view ident) {
+    auto& slot = keyword_table[keywordHash(ident)];
+    return slot.text == ident ? slot.type : IDENT;
 }
 
-std::string Lexer::lexString() {
-    std::string str = std::string();
-    while (peak() != '"') {
-        auto ch = peak();
-        str += ch;
-        step();
+std::string_view Lexer::lexString() {
+    auto begin = _cur + 1;
+    auto p = begin;
+    while (*p != '"' && p < _end) {
+        p++;
     }
-    step(); // consume '"' at string end
+    _cur = p < _end ? p + 1 : p;   // consume '"' at string end
 
-    return str;
+    return std::string_view(begin, p - begin);
 }
 
-std::string Lexer::lexChar() {
-    auto ret = std::string(1, peak());
-    char character = peak();
-    step();
-    if (character == '\\') {
-        ret += std::string(1, peak());
-        step();
+std::string_view Lexer::lexChar() {
+    auto begin = _cur + 1;
+    auto p = begin;
+    if (*p == '\\' && p + 1 < _end) {
+        p++;
+    }
+    if (p < _end) {
+        p++;
     }
-    step();
+    auto ret = std::string_view(begin, p - begin);
+    _cur = p < _end ? p + 1 : p;   // consume closing '\''
 
     return ret;
 }
 
-std::string Lexer::lexNumber() {
-    std::string str = "";
-    str += current();
-    while (peak() >= '0' && peak() <= '9') {
-        str += peak();
-        step();
+std::string_view Lexer::lexNumber() {
+    auto begin = _cur;
+    while (char_classes[static_cast<uint8_t>(*_cur)] == CLASS_DIGIT) {
+        _cur++;
     }
 
-    return str;
+    return std::string_view(begin, _cur - begin);
 }
 
-std::string Lexer::lexIdent() {
-    std::string ret = std::string();
-    ret += current();
-    while (std::isalnum(peak()) || peak() == '_') {
-            ret += peak();
-            step();
-        }
+std::string_view Lexer::lexIdent() {
+    auto begin = _cur;
+    while (ident_chars[static_cast<uint8_t>(*_cur)]) {
+        _cur++;
+    }
 
-    return ret;
+    return std::string_view(begin, _cur - begin);
 }
 
 }
 
-}
\ No newline at end of file
+}
@@ -4,6 +4,8 @@
 #include "logger.hpp"
 #include "token.hpp"
 #include "type.hpp"
+#include <algorithm>
+#include <charconv>
 #include <initializer_list>
 #include <memory>
 #include <tuple>
@@ -21,13 +23,53 @@ const std::map<char, char> Parser::_escape_character_map
     {'0', '\0'},
     };
 
-Parser::Parser(std::shared_ptr<Logger> logger) {
+const char* const Parser::_trace_names[] = {
+    "",
+    "CompUnit",
+    "MainFuncDef",
+    "FuncType",
+    "FuncDef",
+    "FuncFParams",
+    "FuncFParam",
+    "Block",
+    "Stmt",
+    "ForStmt",
+    "Exp",
+    "ConstExp",
+    "Cond",
+    "LVal",
+    "PrimaryExp",
+    "Character",
+    "Number",
+    "UnaryOp",
+    "UnaryExp",
+    "FuncRParams",
+    "MulExp",
+    "AddExp",
+    "RelExp",
+    "EqExp",
+    "LAndExp",
+    "LOrExp",
+    "ConstDecl",
+    "VarDecl",
+    "ConstDef",
+    "VarDef",
+    "ConstInitVal",
+    "InitVal",
+};
+
+Parser::Parser(std::shared_ptr<Logger> logger, std::shared_ptr<tools::Arena> arena) {
     _logger = logger;
+    _arena = arena;
     _pos = 0;
+    _trace_level = TRACE_FULL;
+    _memoize = false;
+    _memo_stats = {0, 0};
 }
 
-std::string Parser::parseString(const std::string in) {
+std::string Parser::parseString(std::string_view in) {
     std::string ret = "";
+    ret.reserve(in.size());
     for (auto iter = in.begin(), end = in.end(); iter != end; iter++) {
         if (*iter == '\\') {
             iter++;
@@ -40,11 +82,13 @@ std::string Parser::parseString(const std::string in) {
     return ret;
 }
 
-int32_t Parser::parseInt(const std::string in) {
-    return std::stoll(in);
+int32_t Parser::parseInt(std::string_view in) {
+    int64_t ret = 0;
+    std::from_chars(in.data(), in.data() + in.size(), ret);
+    return static_cast<int32_t>(ret);
 }
 
-char Parser::parseChar(const std::string in) {
+char Parser::parseChar(std::string_view in) {
     if (in[0] == '\\') {
         return _escape_character_map.find(in[1])->second;
     } else {
@@ -83,584 +127,655 @@ bool Parser::match(std::initializer_list<TokenType> list) {
 
     return true;
 }
-
-void Parser::update(std::shared_ptr<ParseResult> buffer, std::shared_ptr<ParseResult> result) {
-    for (auto& log : result->log_buffer) {
-        buffer->log(log);
-    }
-    for (auto& error : result->error_buffer) {
-        buffer->logError(error);
+bool Parser::checkExp() {
+    switch (current().type) {
+        case IDENT:
+        case INT_CONSTANT:
+        case CHAR_CONSTANT:
+        case LEFT_BRACE:
+        case ADD:
+        case MINUS:
+        case NOT:
+            return true;
+        default:
+            return false;
     }
 }
 
-#define CHECK_AND_STEP(type, result) if (check(type)) result->log(step()); else return result
-
-std::shared_ptr<CompNode> Parser::parse(std::shared_ptr<std::vector<Token>> tokens) {
-    _pos = 0;
-    this->_tokens = tokens;
-    auto result = parseCompUnit();
-    for (auto& log : result->log_buffer) {
-        _logger->log(log);
+void Parser::revert(uint32_t pos, std::size_t trace, std::size_t errors) {
+    _pos = pos;
+    if (trace < _trace.size()) {
+        _dead_trace.emplace_back(trace, _trace.size());
     }
-    for (auto& error : result->error_buffer) {
-        _logger->logError(error);
+    if (errors < _errors.size()) {
+        _dead_errors.emplace_back(errors, _errors.size());
     }
-
-    return result->get<CompNode>();
 }
 
+/**
+ * @brief Remove dead ranges from buffer, keeping order of the rest
+ * 
+ */
 template<typename T>
-std::shared_ptr<T> Parser::tryParse(ParseFuncPtr func, std::shared_ptr<ParseResult> buffer) {
-    auto pos = _pos;
-    if (auto result = (this->*func)(); result->get<T>()) {
-        update(buffer, result);
-        return result->get<T>();
-    } else {
-        revert(pos);
+static void removeDead(std::vector<T>& buffer, std::vector<std::pair<std::size_t, std::size_t>>& dead) {
+    if (dead.empty()) {
+        return;
+    }
+    std::sort(dead.begin(), dead.end());
+    std::size_t i = 0;
+    std::size_t out = 0;
+    for (auto& [begin, end] : dead) {
+        for (; i < begin; i++) {
+            buffer[out++] = buffer[i];
+        }
+        i = std::max(i, end);
     }
-
-    return nullptr;
+    for (; i < buffer.size(); i++) {
+        buffer[out++] = buffer[i];
+    }
+    buffer.resize(out);
+    dead.clear();
 }
 
-template<typename T>
-std::shared_ptr<T> Parser::tryParse(ParseTypeFuncPtr func, bool is_const, std::shared_ptr<ParseResult> buffer) {
-    auto pos = _pos;
-    if (auto result = (this->*func)(is_const); result->get<T>()) {
-        update(buffer, result);
-        return result->get<T>();
-    } else {
-        revert(pos);
+template<typename T, typename... Args>
+T* Parser::memo(Production production, T* (Parser::*func)(Args...), Args... args) {
+    if (!_memoize) {
+        return (this->*func)(args...);
     }
 
-    return nullptr;
+    auto key = (static_cast<uint64_t>(production) << 32) | _pos;
+    if (auto iter = _memo.find(key); iter != _memo.end()) {
+        auto& entry = iter->second;
+        _memo_stats.hits++;
+        _pos = entry.end;
+        for (auto i = entry.trace_begin; i < entry.trace_end; i++) {
+            auto record = _trace[i];
+            _trace.push_back(record);
+        }
+        for (auto i = entry.error_begin; i < entry.error_end; i++) {
+            auto error = _errors[i];
+            _errors.push_back(error);
+        }
+        return static_cast<T*>(entry.node);
+    }
+
+    _memo_stats.misses++;
+    auto trace = _trace.size();
+    auto errors = _errors.size();
+    auto node = (this->*func)(args...);
+    _memo.emplace(key, MemoEntry{node, _pos, trace, _trace.size(), errors, _errors.size()});
+
+    return node;
 }
 
-std::shared_ptr<ParseResult> Parser::parseCompUnit() {
-    auto ret = std::make_shared<ParseResult>();
+#define CHECK_AND_STEP(type) if (check(type)) step(); else return nullptr
 
-    auto sline = line();
-    auto comp_unit = std::shared_ptr<CompNode>();
-    if (auto func_def = tryParse<FuncDefNode>(&Parser::parseFuncDef, ret); func_def) {
-        comp_unit = std::make_shared<CompNode>(sline, func_def);
-    } else if (auto main_func_def = tryParse<MainNode>(&Parser::parseMainFuncDef, ret); main_func_def) {
-        comp_unit = std::make_shared<CompNode>(sline, main_func_def);
-    } else if (auto decl = tryParse<DeclNode>(&Parser::parseDecl, ret); decl) {
-        comp_unit = std::make_shared<CompNode>(sline, decl);
-    } else {
-        return ret;
+CompNode* Parser::parse(std::shared_ptr<std::vector<Token>> tokens) {
+    _pos = 0;
+    this->_tokens = tokens;
+    _trace.clear();
+    _errors.clear();
+    _dead_trace.clear();
+    _dead_errors.clear();
+    _pending_lval = nullptr;
+    _memo.clear();
+    _memo_stats = {0, 0};
+
+    auto comp_unit = parseCompUnit();
+    removeDead(_trace, _dead_trace);
+    removeDead(_errors, _dead_errors);
+    if (_trace_level == TRACE_FULL) {
+        for (auto& record : _trace) {
+            auto& token = (*_tokens)[std::min<std::size_t>(record.token, _tokens->size() - 1)];
+            if (record.kind == TRACE_TOKEN) {
+                _logger->logLexer(token.line, token.type, token.value);
+            } else {
+                _logger->logParser(token.line, _trace_names[record.kind]);
+            }
+        }
+    }
+    for (auto& error : _errors) {
+        _logger->logError(error.line, error.message, error.error);
     }
+    _errors.clear();
+    _memo.clear();
+
+    return comp_unit;
+}
+
+std::vector<std::shared_ptr<Log>> Parser::traceLogs() {
+    auto ret = std::vector<std::shared_ptr<Log>>();
+    ret.reserve(_trace.size());
 
-    while (!atEnd()) {
-        sline = line();
-        if (auto func_def = tryParse<FuncDefNode>(&Parser::parseFuncDef, ret); func_def) {
-            comp_unit = std::make_shared<CompNode>(sline, func_def, comp_unit);
-        } else if (auto decl = tryParse<DeclNode>(&Parser::parseDecl, ret); decl) {
-            comp_unit = std::make_shared<CompNode>(sline, decl, comp_unit);
-        } else if (auto main_func_def = tryParse<MainNode>(&Parser::parseMainFuncDef, ret); main_func_def) {
-            comp_unit = std::make_shared<CompNode>(sline, main_func_def, comp_unit);
+    for (auto& record : _trace) {
+        auto& token = (*_tokens)[std::min<std::size_t>(record.token, _tokens->size() - 1)];
+        if (record.kind == TRACE_TOKEN) {
+            ret.push_back(std::make_shared<LexerLog>(token.line, token.type, std::string(token.value)));
         } else {
-            return ret;
+            ret.push_back(std::make_shared<ParserLog>(token.line, _trace_names[record.kind]));
         }
     }
 
-    ret->node = comp_unit;
-
-    ret->log(std::make_shared<ParserLog>(line(), "CompUnit"));
-
     return ret;
 }
 
-std::shared_ptr<ParseResult> Parser::parseMainFuncDef() {
-    auto ret = std::make_shared<ParseResult>();
+CompNode* Parser::parseCompUnit() {
+    CompNode* comp_unit = nullptr;
+    do {
+        auto sline = line();
+        if (matchFuncDef()) {
+            auto func_def = parseFuncDef();
+            comp_unit = _arena->make<CompNode>(sline, func_def, comp_unit);
+        } else if (matchMainFuncDef()) {
+            auto main_func_def = parseMainFuncDef();
+            comp_unit = _arena->make<CompNode>(sline, main_func_def, comp_unit);
+        } else if (auto decl = parseDecl(); decl) {
+            comp_unit = _arena->make<CompNode>(sline, decl, comp_unit);
+        } else {
+            return nullptr; // abort
+        }
+    } while (!atEnd());
 
-    Type* type = token2Type(current());
-    if (!type) {
-        return ret; // abort
-    }
-    ret->log(step());   // type
+    trace(TRACE_COMP_UNIT);
+
+    return comp_unit;
+}
+
+MainNode* Parser::parseMainFuncDef() {
+    step();   // type
     auto sline = line();
-    CHECK_AND_STEP(MAIN, ret);
-    CHECK_AND_STEP(LEFT_BRACE, ret);
+    CHECK_AND_STEP(MAIN);
+    CHECK_AND_STEP(LEFT_BRACE);
     if (check(RIGHT_BRACE)) {
-        ret->log(step());
+        step();
     } else {
-        ret->logError(std::make_shared<ErrorLog>(last().line, "right brace not found!", buaa::ERROR_MISSING_BRACE));
+        logError(last().line, "right brace not found!", buaa::ERROR_MISSING_BRACE);
     }
 
-    auto block = tryParse<BlockNode>(&Parser::parseBlock, ret);
-    ret->log(std::make_shared<ParserLog>(line(), "MainFuncDef"));
+    auto block = parseBlock();
+    trace(TRACE_MAIN_FUNC_DEF);
 
-    ret->node = std::make_shared<MainNode>(sline, block);
-
-    return ret;
+    return _arena->make<MainNode>(sline, block);
 }
 
-std::shared_ptr<ParseResult> Parser::parseFuncDef() {
-    auto ret = std::make_shared<ParseResult>();
-
+FuncDefNode* Parser::parseFuncDef() {
     Type* type = token2Type(current());
-    if (!type) {
-        return ret; // abort
-    }
-    ret->log(step());   // type
-    if (!check(IDENT)) {
-        return ret; // abort
-    }
-    ret->log(std::make_shared<ParserLog>(line(), "FuncType"));
-    auto ident = current().value;
+    step();   // type
+    trace(TRACE_FUNC_TYPE);
+    auto ident = current().ident;
     auto sline = line();
-    ret->log(step());   // ident
+    step();   // ident
 
-    auto params = std::shared_ptr<FuncFParamsNode>();
-    CHECK_AND_STEP(LEFT_BRACE, ret);
+    FuncFParamsNode* params = nullptr;
+    CHECK_AND_STEP(LEFT_BRACE);
     if (!check(RIGHT_BRACE)) {
-        if (auto result = tryParse<FuncFParamsNode>(&Parser::parseFuncFParams, ret); result) {
-            params = result;
-        }
+        params = parseFuncFParams();
         if (check(RIGHT_BRACE)) {
-            ret->log(step());
+            step();
         } else {
-            ret->logError(std::make_shared<ErrorLog>(last().line, "right brace missing!", buaa::ERROR_MISSING_BRACE));
+            logError(last().line, "right brace missing!", buaa::ERROR_MISSING_BRACE);
         }
     } else {
-        ret->log(step());
+        step();
     }
 
-    auto block = tryParse<BlockNode>(&Parser::parseBlock, ret);
-
-    ret->log(std::make_shared<ParserLog>(line(), "FuncDef"));
+    auto block = parseBlock();
 
-    ret->node = std::make_shared<FuncDefNode>(sline, type, ident, block, params);
+    trace(TRACE_FUNC_DEF);
 
-    return ret;
+    return _arena->make<FuncDefNode>(sline, type, ident, block, params);
 }
 
-std::tuple<Type*, std::string> Parser::parseFuncParam(std::shared_ptr<ParseResult> result) {
+std::tuple<Type*, Ident> Parser::parseFuncParam() {
     auto type = token2Type(current());
-    result->log(step());   // type
-    auto ident = current().value;
-    result->log(step());   // ident
+    step();   // type
+    auto ident = current().ident;
+    step();   // ident
     if (check(LEFT_SQUARE)) {
-        result->log(step());
+        step();
         if (check(RIGHT_SQUARE)) {
-            result->log(step());
+            step();
         } else {
-            result->logError(std::make_shared<ErrorLog>(last().line, "no right square!", buaa::ERROR_MISSING_SQUARE));
+            logError(last().line, "no right square!", buaa::ERROR_MISSING_SQUARE);
         }
         type = PtrType::get(type);
     }
 
-    result->log(std::make_shared<ParserLog>(line(), "FuncFParam"));
+    trace(TRACE_FUNC_F_PARAM);
 
     return std::make_tuple(type, ident);
 }
 
-std::shared_ptr<ParseResult> Parser::parseFuncFParams() {
-    auto ret = std::make_shared<ParseResult>();
-
-    auto sline = line();
-
-    auto params = std::vector<std::tuple<Type*, std::string>>();
+FuncFParamsNode* Parser::parseFuncFParams() {
+    auto params = std::vector<std::tuple<Type*, Ident>>();
     if (check(LEFT_BRAKET)) {
-        return ret; // abort
+        return nullptr; // no params, right brace missing
     }
-    params.push_back(parseFuncParam(ret));
+    params.push_back(parseFuncParam());
 
     while (check(COMMA)) {
-        ret->log(step());
-        params.push_back(parseFuncParam(ret));
+        step();
+        params.push_back(parseFuncParam());
     }
 
-    ret->log(std::make_shared<ParserLog>(line(), "FuncFParams"));
-
-    ret->node = std::make_shared<FuncFParamsNode>(line(), params);
+    trace(TRACE_FUNC_F_PARAMS);
 
-    return ret;
+    return _arena->make<FuncFParamsNode>(line(), _arena->span(params));
 }
 
-std::shared_ptr<ParseResult> Parser::parseBlock() {
-    auto ret = std::make_shared<ParseResult>();
+BlockNode* Parser::parseBlock() {
+    CHECK_AND_STEP(LEFT_BRAKET);
 
-    CHECK_AND_STEP(LEFT_BRAKET, ret);
-
-    auto items = std::vector<std::shared_ptr<BlockItemNode>>();
+    auto items = std::vector<BlockItemNode*>();
     while (current().type != RIGHT_BRAKET) {
         if (atEnd()) {
-            return ret; // abort
+            return nullptr; // abort
+        }
+        auto pos = _pos;
+        auto item = parseBlockItem();
+        if (!item && pos == _pos) {
+            return nullptr; // abort, no production starts with current token
         }
-        items.push_back(tryParse<BlockItemNode>(&Parser::parseBlockItem, ret));
+        items.push_back(item);
     }
-    CHECK_AND_STEP(RIGHT_BRAKET, ret);
-
-    ret->log(std::make_shared<ParserLog>(line(), "Block"));
+    CHECK_AND_STEP(RIGHT_BRAKET);
 
-    ret->node = std::make_shared<BlockNode>(last().line, items);
+    trace(TRACE_BLOCK);
 
-    return ret;
+    return _arena->make<BlockNode>(last().line, _arena->span(items));
 }
 
-std::shared_ptr<ParseResult> Parser::parseBlockItem() {
-    auto ret = std::make_shared<ParseResult>();
-
+BlockItemNode* Parser::parseBlockItem() {
     auto sline = line();
-    if (auto decl = tryParse<DeclNode>(&Parser::parseDecl, ret); decl) {
-        ret->node = std::make_shared<BlockItemNode>(sline, decl);
-    } else if (auto stmt = tryParse<StmtNode>(&Parser::parseStmt, ret); stmt) {
-        ret->node = std::make_shared<BlockItemNode>(sline, stmt);
+    if (check(CONST) || token2Type(current())) {
+        if (auto decl = parseDecl(); decl) {
+            return _arena->make<BlockItemNode>(sline, decl);
+        }
+    } else if (auto stmt = parseStmt(); stmt) {
+        return _arena->make<BlockItemNode>(sline, stmt);
     }
 
-    return ret;
+    return nullptr;
 }
 
-std::shared_ptr<ParseResult> Parser::parseExpStmt() {
-    auto ret = std::make_shared<ParseResult>();
+ExpStmtNode* Parser::parseExpStmt() {
+    if (!_pending_lval && check(SEMICOLON)) {
+        step();
+        return _arena->make<ExpStmtNode>(last().line);
+    }
 
+    auto sline = _pending_lval ? _pending_lval->line() : line();
+    auto exp = parseExp();
+    if (!exp) {
+        return nullptr; // abort
+    }
     if (check(SEMICOLON)) {
-        ret->log(step());
-        ret->node = std::make_shared<ExpStmtNode>(last().line);
+        step();
     } else {
-        auto sline = line();
-        if (auto exp = tryParse<ExpNode>(&Parser::parseExp, false, ret); exp) {
-            if (check(SEMICOLON)) {
-                ret->log(step());
-            } else {
-                ret->logError(std::make_shared<ErrorLog>(last().line, "exp stmt no semi", buaa::ERROR_MISSING_SEMICOLON));
-            }
-            ret->node = std::make_shared<ExpStmtNode>(sline, exp);
-        } else {
-            return ret; // abort
-        }
+        logError(last().line, "exp stmt no semi", buaa::ERROR_MISSING_SEMICOLON);
     }
 
-    return ret;
+    return _arena->make<ExpStmtNode>(sline, exp);
 }
 
-std::shared_ptr<ParseResult> Parser::parseBlockStmt() {
-    auto ret = std::make_shared<ParseResult>();
-
+BlockStmtNode* Parser::parseBlockStmt() {
     auto sline = line();
-    if (auto block = tryParse<BlockNode>(&Parser::parseBlock, ret); block) {
-        ret->node = std::make_shared<BlockStmtNode>(sline, block);
-    } else {
-        return ret; // abort
+    if (auto block = parseBlock(); block) {
+        return _arena->make<BlockStmtNode>(sline, block);
     }
 
-    return ret;
+    return nullptr; // abort
 }
 
-std::shared_ptr<ParseResult> Parser::parseIfStmt() {
-    auto ret = std::make_shared<ParseResult>();
-
+IfStmtNode* Parser::parseIfStmt() {
     auto sline = line();
-    CHECK_AND_STEP(IF, ret);
-    CHECK_AND_STEP(LEFT_BRACE, ret);
+    CHECK_AND_STEP(IF);
+    CHECK_AND_STEP(LEFT_BRACE);
 
-    auto cond = tryParse<ExpNode>(&Parser::parseCondExp, ret);
+    auto cond = parseCondExp();
     if (check(RIGHT_BRACE)) {
-        ret->log(step());
+        step();
     } else {
-        ret->logError(std::make_shared<ErrorLog>(last().line, "if no right brace", buaa::ERROR_MISSING_BRACE));
+        logError(last().line, "if no right brace", buaa::ERROR_MISSING_BRACE);
     }
 
-    auto if_stmt = tryParse<StmtNode>(&Parser::parseStmt, ret);
-    auto else_stmt = std::shared_ptr<StmtNode>();
+    auto if_stmt = parseStmt();
+    StmtNode* else_stmt = nullptr;
     if (check(ELSE)) {
-        ret->log(step());
-        else_stmt = tryParse<StmtNode>(&Parser::parseStmt, ret);
+        step();
+        else_stmt = parseStmt();
     }
 
-    ret->node = std::make_shared<IfStmtNode>(sline, cond, if_stmt, else_stmt);
-
-    return ret;
+    return _arena->make<IfStmtNode>(sline, cond, if_stmt, else_stmt);
 }
 
-std::shared_ptr<ParseResult> Parser::parseForStmt() {
-    auto ret = std::make_shared<ParseResult>();
-
+ForStmtNode* Parser::parseForStmt() {
     auto sline = line();
-    CHECK_AND_STEP(FOR, ret);
-    CHECK_AND_STEP(LEFT_BRACE, ret);
+    CHECK_AND_STEP(FOR);
+    CHECK_AND_STEP(LEFT_BRACE);
 
-    auto for_in = std::shared_ptr<StmtNode>();
-    auto cond = std::shared_ptr<ExpNode>();
-    auto for_out = std::shared_ptr<StmtNode>();
-    auto for_stmt = std::shared_ptr<StmtNode>();
+    StmtNode* for_in = nullptr;
+    ExpNode* cond = nullptr;
+    StmtNode* for_out = nullptr;
+    StmtNode* for_stmt = nullptr;
 
     if (check(SEMICOLON)) {
-        ret->log(step());
+        step();
     } else {
         auto sline = line();
-        auto lval = tryParse<LValNode>(&Parser::parseLVal, ret);
-        CHECK_AND_STEP(ASSIGN, ret);
-        auto rval = tryParse<RValNode>(&Parser::parseRVal, ret);
-        for_in = std::make_shared<AssignStmtNode>(sline, lval, rval);
-        ret->log(std::make_shared<ParserLog>(line(), "ForStmt"));
-        CHECK_AND_STEP(SEMICOLON, ret);
+        auto lval = parseLVal();
+        CHECK_AND_STEP(ASSIGN);
+        auto rval = parseRVal();
+        for_in = _arena->make<AssignStmtNode>(sline, lval, rval);
+        trace(TRACE_FOR_STMT);
+        CHECK_AND_STEP(SEMICOLON);
     }
     if (check(SEMICOLON)) {
-        ret->log(step());
+        step();
     } else {
-        cond = tryParse<ExpNode>(&Parser::parseCondExp, ret);
-        CHECK_AND_STEP(SEMICOLON, ret);
+        cond = parseCondExp();
+        CHECK_AND_STEP(SEMICOLON);
     }
     if (!check(RIGHT_BRACE)) {
         auto sline = line();
-        auto lval = tryParse<LValNode>(&Parser::parseLVal, ret);
-        CHECK_AND_STEP(ASSIGN, ret);
-        auto rval = tryParse<RValNode>(&Parser::parseRVal, ret);
-        for_out = std::make_shared<AssignStmtNode>(sline, lval, rval);
-        ret->log(std::make_shared<ParserLog>(line(), "ForStmt"));
+        auto lval = parseLVal();
+        CHECK_AND_STEP(ASSIGN);
+        auto rval = parseRVal();
+        for_out = _arena->make<AssignStmtNode>(sline, lval, rval);
+        trace(TRACE_FOR_STMT);
         if (check(RIGHT_BRACE)) {
-            ret->log(step());
+            step();
         } else {
-            ret->logError(std::make_shared<ErrorLog>(last().line, "for no brace", buaa::ERROR_MISSING_BRACE));
+            logError(last().line, "for no brace", buaa::ERROR_MISSING_BRACE);
         }
     } else {
-        ret->log(step());
+        step();
     }
 
-    for_stmt = tryParse<StmtNode>(&Parser::parseStmt, ret);
-
-    ret->node = std::make_shared<ForStmtNode>(sline, for_in, cond, for_out, for_stmt);
+    for_stmt = parseStmt();
 
-    return ret;
+    return _arena->make<ForStmtNode>(sline, for_in, cond, for_out, for_stmt);
 }
 
-std::shared_ptr<ParseResult> Parser::parseReturnStmt() {
-    auto ret = std::make_shared<ParseResult>();
-
+ReturnStmtNode* Parser::parseReturnStmt() {
     auto sline = line();
-    CHECK_AND_STEP(RETURN, ret);
+    CHECK_AND_STEP(RETURN);
 
-    if (auto exp = tryParse<ExpNode>(&Parser::parseExp, false, ret); exp) {
-        ret->node = std::make_shared<ReturnStmtNode>(sline, exp);
+    ReturnStmtNode* ret = nullptr;
+    if (checkExp()) {
+        ret = _arena->make<ReturnStmtNode>(sline, parseExp());
     } else {
-        ret->node = std::make_shared<ReturnStmtNode>(sline);
+        ret = _arena->make<ReturnStmtNode>(sline);
     }
 
     if (check(SEMICOLON)) {
-        ret->log(step());
+        step();
     } else {
-        ret->logError(std::make_shared<ErrorLog>(last().line, "return no semi", buaa::ERROR_MISSING_SEMICOLON));
+        logError(last().line, "return no semi", buaa::ERROR_MISSING_SEMICOLON);
     }
 
     return ret;
 }
 
-std::shared_ptr<ParseResult> Parser::parsePrintfStmt() {
-    auto ret = std::make_shared<ParseResult>();
-
+PrintfStmtNode* Parser::parsePrintfStmt() {
     auto sline = line();
-    CHECK_AND_STEP(PRINTF, ret);
-    CHECK_AND_STEP(LEFT_BRACE, ret);
+    CHECK_AND_STEP(PRINTF);
+    CHECK_AND_STEP(LEFT_BRACE);
 
-    auto fmt = (parseString(current().value));
-    ret->log(step());
+    auto fmt = _arena->string(parseString(current().value));
+    step();
 
-    auto exps = std::vector<std::shared_ptr<ExpNode>>();
+    auto exps = std::vector<ExpNode*>();
     while (check(COMMA)) {
-        ret->log(step());
-        exps.push_back(tryParse<ExpNode>(&Parser::parseExp, false, ret));
+        step();
+        exps.push_back(checkExp() ? parseExp() : nullptr);
     }
     if (check(RIGHT_BRACE)) {
-        ret->log(step());
+        step();
     } else {
-        ret->logError(std::make_shared<ErrorLog>(last().line, "printf no brace", buaa::ERROR_MISSING_BRACE));
+        logError(last().line, "printf no brace", buaa::ERROR_MISSING_BRACE);
     }
     if (check(SEMICOLON)) {
-        ret->log(step());
+        step();
     } else {
-        ret->logError(std::make_shared<ErrorLog>(last().line, "printf no semi", buaa::ERROR_MISSING_SEMICOLON));
+        logError(last().line, "printf no semi", buaa::ERROR_MISSING_SEMICOLON);
     }
 
-    ret->node = std::make_shared<PrintfStmtNode>(sline, fmt, exps);
+    return _arena->make<PrintfStmtNode>(sline, fmt, _arena->span(exps));
+}
 
-    return ret;
+AssignStmtNode* Parser::parseAssignStmt(LValNode* lval) {
+    step();    // assign
+    auto rval = parseRVal();
+    if (check(SEMICOLON)) {
+        step();
+    } else {
+        logError(last().line, "assign no semi", buaa::ERROR_MISSING_SEMICOLON);
+    }
+
+    return _arena->make<AssignStmtNode>(lval->line(), lval, rval);
 }
 
-std::shared_ptr<ParseResult> Parser::parseAssignStmt() {
-    auto ret = std::make_shared<ParseResult>();
+StmtNode* Parser::parseIdentStmt() {
+    if (matchNext(LEFT_BRACE)) {
+        return parseExpStmt();  // function call
+    }
 
-    auto sline = line();  
-    if (auto lval = tryParse<LValNode>(&Parser::parseLVal, ret); lval) {
-        CHECK_AND_STEP(ASSIGN, ret);
-        auto rval = tryParse<RValNode>(&Parser::parseRVal, ret);
-        if (check(SEMICOLON)) {
-            ret->log(step());
-        } else {
-            ret->logError(std::make_shared<ErrorLog>(last().line, "assign no semi", buaa::ERROR_MISSING_SEMICOLON));
+    if (_memoize) {
+        // speculate on AssignStmt, the ExpStmt retry reads LVal back from the memo
+        auto pos = _pos;
+        auto trace = _trace.size();
+        auto errors = _errors.size();
+        if (auto lval = parseLVal(); check(ASSIGN)) {
+            return parseAssignStmt(lval);
         }
-        ret->node = std::make_shared<AssignStmtNode>(sline, lval, rval);
-    } else {
-        return ret; // abort
+        revert(pos, trace, errors);
+        return parseExpStmt();
     }
 
-    return ret;
+    // LVal prefixes both AssignStmt and Exp, parse it once and decide on the next token
+    auto lval = parseLVal();
+    if (check(ASSIGN)) {
+        return parseAssignStmt(lval);
+    }
+
+    _pending_lval = lval;
+    return parseExpStmt();
 }
 
-std::shared_ptr<ParseResult> Parser::parseStmt() {
-    auto ret = std::make_shared<ParseResult>();
-
-    if (auto stmt = tryParse<AssignStmtNode>(&Parser::parseAssignStmt, ret); stmt) {
-        ret->node = stmt;
-    } else if (auto stmt = tryParse<ExpStmtNode>(&Parser::parseExpStmt, ret); stmt) {
-        ret->node = stmt;
-    } else if (auto stmt = tryParse<BlockStmtNode>(&Parser::parseBlockStmt, ret); stmt) {
-        ret->node = stmt;
-    } else if (auto stmt = tryParse<IfStmtNode>(&Parser::parseIfStmt, ret); stmt) {
-        ret->node = stmt;
-    } else if (auto stmt = tryParse<ForStmtNode>(&Parser::parseForStmt, ret); stmt) {
-        ret->node = stmt;
-    } else if (check(BREAK)) {
-        auto sline = line();
-        ret->log(step());
-        if (check(SEMICOLON)) {
-            ret->log(step());
-        } else {
-            ret->logError(std::make_shared<ErrorLog>(last().line, "break no semi", buaa::ERROR_MISSING_SEMICOLON));
+StmtNode* Parser::parseStmt() {
+    StmtNode* stmt = nullptr;
+    switch (current().type) {
+        case IDENT:
+            stmt = parseIdentStmt();
+            break;
+        case SEMICOLON:
+        case INT_CONSTANT:
+        case CHAR_CONSTANT:
+        case LEFT_BRACE:
+        case ADD:
+        case MINUS:
+        case NOT:
+            stmt = parseExpStmt();
+            break;
+        case LEFT_BRAKET:
+            stmt = parseBlockStmt();
+            break;
+        case IF:
+            stmt = parseIfStmt();
+            break;
+        case FOR:
+            stmt = parseForStmt();
+            break;
+        case BREAK: {
+            auto sline = line();
+            step();
+            if (check(SEMICOLON)) {
+                step();
+            } else {
+                logError(last().line, "break no semi", buaa::ERROR_MISSING_SEMICOLON);
+            }
+            stmt = _arena->make<BreakStmtNode>(sline);
+            break;
         }
-        ret->node = std::make_shared<BreakStmtNode>(sline);
-    } else if (check(CONTINUE)) {
-        auto sline = line();
-        ret->log(step());
-        if (check(SEMICOLON)) {
-            ret->log(step());
-        } else {
-            ret->logError(std::make_shared<ErrorLog>(last().line, "continue no semi", buaa::ERROR_MISSING_SEMICOLON));
+        case CONTINUE: {
+            auto sline = line();
+            step();
+            if (check(SEMICOLON)) {
+                step();
+            } else {
+                logError(last().line, "continue no semi", buaa::ERROR_MISSING_SEMICOLON);
+            }
+            stmt = _arena->make<ContinueStmtNode>(sline);
+            break;
         }
-        ret->node = std::make_shared<ContinueStmtNode>(sline);
-    } else if (auto stmt = tryParse<ReturnStmtNode>(&Parser::parseReturnStmt, ret); stmt) {
-        ret->node = stmt;
-    } else if (auto stmt = tryParse<PrintfStmtNode>(&Parser::parsePrintfStmt, ret); stmt) {
-        ret->node = stmt;
-    } else {
-        return ret; // abort
+        case RETURN:
+            stmt = parseReturnStmt();
+            break;
+        case PRINTF:
+            stmt = parsePrintfStmt();
+            break;
+        default:
+            break;
+    }
+    if (!stmt) {
+        return nullptr; // abort
     }
 
-    ret->log(std::make_shared<ParserLog>(line(), "Stmt"));
+    trace(TRACE_STMT);
 
-    return ret;
+    return stmt;
 }
 
-std::shared_ptr<ParseResult> Parser::parseExp(bool is_const) {
-    auto ret = std::make_shared<ParseResult>();
+ExpNode* Parser::parseExp(bool is_const) {
+    return memo(is_const ? PROD_CONST_EXP : PROD_EXP, &Parser::parseExpImpl, is_const);
+}
 
-    ret->node = tryParse<ExpNode>(&Parser::parseAddExp, ret);
+ExpNode* Parser::parseExpImpl(bool is_const) {
+    auto exp = parseAddExp();
+    if (!exp) {
+        return nullptr; // abort
+    }
 
     if (is_const) {
-        ret->log(std::make_shared<ParserLog>(line(), "ConstExp"));
+        trace(TRACE_CONST_EXP);
     } else {
-        ret->log(std::make_shared<ParserLog>(line(), "Exp"));
+        trace(TRACE_EXP);
     }
 
-    return ret;
+    return exp;
 }
 
-std::shared_ptr<ParseResult> Parser::parseCondExp() {
-    auto ret = std::make_shared<ParseResult>();
-
-    ret->node = tryParse<ExpNode>(&Parser::parseLOrExp, ret);
+ExpNode* Parser::parseCondExp() {
+    auto exp = parseLOrExp();
+    if (!exp) {
+        return nullptr; // abort
+    }
 
-    ret->log(std::make_shared<ParserLog>(line(), "Cond"));
+    trace(TRACE_COND);
 
-    return ret;
+    return exp;
 }
 
-std::shared_ptr<ParseResult> Parser::parseLVal() {
-    auto ret = std::make_shared<ParseResult>();
+LValNode* Parser::parseLVal() {
+    return memo(PROD_LVAL, &Parser::parseLValImpl);
+}
 
+LValNode* Parser::parseLValImpl() {
+    auto start = _pos;
     auto sline = line();
     if (!check(IDENT)) {
-        return ret; // abort
+        return nullptr; // abort
     }
 
-    auto ident = current().value;
-    ret->log(step());
+    auto ident = current().ident;
+    step();
 
-    auto exp = std::shared_ptr<ExpNode>();
+    ExpNode* exp = nullptr;
     if (check(LEFT_SQUARE)) {
-        ret->log(step());
-        exp = tryParse<ExpNode>(&Parser::parseExp, false, ret);
+        step();
+        exp = parseExp();
         if (check(RIGHT_SQUARE)) {
-            ret->log(step());
+            step();
         } else {
-            ret->logError(std::make_shared<ErrorLog>(last().line, "lval mis square", buaa::ERROR_MISSING_SQUARE));
+            logError(last().line, "lval mis square", buaa::ERROR_MISSING_SQUARE);
         }
     }
 
-    ret->log(std::make_shared<ParserLog>(sline, "LVal"));
-
-    ret->node = std::make_shared<LValNode>(sline, ident, exp);
+    trace(start, TRACE_L_VAL);
 
-    return ret;
+    return _arena->make<LValNode>(sline, ident, exp);
 }
 
-std::shared_ptr<ParseResult> Parser::parsePrimary() {
-    auto ret = std::make_shared<ParseResult>();
-
-    auto sline = line();
-    if (check(LEFT_BRACE)) {
-        ret->log(step());
-        auto exp = tryParse<ExpNode>(&Parser::parseExp, false, ret);
+PrimaryExpNode* Parser::parsePrimary() {
+    PrimaryExpNode* primary = nullptr;
+    if (_pending_lval) {
+        auto lval = _pending_lval;
+        _pending_lval = nullptr;
+        primary = _arena->make<PrimaryExpNode>(lval->line(), lval);
+    } else if (auto sline = line(); check(LEFT_BRACE)) {
+        step();
+        auto exp = parseExp();
         if (check(RIGHT_BRACE)) {
-            ret->log(step());
+            step();
         } else {
-            ret->logError(std::make_shared<ErrorLog>(last().line, "primary (exp) no brace", buaa::ERROR_MISSING_BRACE));
+            logError(last().line, "primary (exp) no brace", buaa::ERROR_MISSING_BRACE);
         }
 
-        ret->node = std::make_shared<PrimaryExpNode>(sline, exp);
-    } else if (auto value_n = tryParse<ValueNode>(&Parser::parseValue, ret); value_n) {
-        ret->node = std::make_shared<PrimaryExpNode>(sline, value_n);
-    } else if (auto lval = tryParse<LValNode>(&Parser::parseLVal, ret); lval) {
-        ret->node = std::make_shared<PrimaryExpNode>(sline, lval);
+        primary = _arena->make<PrimaryExpNode>(sline, exp);
+    } else if (auto value_n = parseValue(); value_n) {
+        primary = _arena->make<PrimaryExpNode>(sline, value_n);
+    } else if (auto lval = parseLVal(); lval) {
+        primary = _arena->make<PrimaryExpNode>(sline, lval);
     } else {
-        return ret; // abort
+        return nullptr; // abort
     }
 
-    ret->log(std::make_shared<ParserLog>(line(), "PrimaryExp"));
+    trace(TRACE_PRIMARY_EXP);
 
-    return ret;
+    return primary;
 }
 
-std::shared_ptr<ParseResult> Parser::parseRVal() {
-    auto ret = std::make_shared<ParseResult>();
-
+RValNode* Parser::parseRVal() {
     auto sline = line();
-    if (auto exp = tryParse<ExpNode>(&Parser::parseExp, false, ret); exp) {
-        ret->node = std::make_shared<RValNode>(sline, exp);
-    } else if (check(GETINT) || check(GETCHAR)) {
+    if (check(GETINT) || check(GETCHAR)) {
         auto type = check(GETINT) ? RVAL_GETINT : RVAL_GETCHAR;
-        ret->node = std::make_shared<RValNode>(sline, type);
-        ret->log(step());
-        CHECK_AND_STEP(LEFT_BRACE, ret);
+        auto rval = _arena->make<RValNode>(sline, type);
+        step();
+        if (!check(LEFT_BRACE)) {
+            return rval;
+        }
+        step();
         if (check(RIGHT_BRACE)) {
-            ret->log(step());
+            step();
         } else {
-            ret->logError(std::make_shared<ErrorLog>(last().line, "rval no brace", buaa::ERROR_MISSING_BRACE));
+            logError(last().line, "rval no brace", buaa::ERROR_MISSING_BRACE);
         }
+        return rval;
+    } else if (auto exp = parseExp(); exp) {
+        return _arena->make<RValNode>(sline, exp);
     }
 
-    return ret;
+    return nullptr;
 }
 
-std::shared_ptr<ParseResult> Parser::parseValue() {
-    auto ret = std::make_shared<ParseResult>();
-
+ValueNode* Parser::parseValue() {
     auto sline = line();
+    ValueNode* value = nullptr;
     if (check(CHAR_CONSTANT)) {
-        ret->node = std::make_shared<ValueNode>(sline, parseChar(current().value));
-        ret->log(step());
-        ret->log(std::make_shared<ParserLog>(line(), "Character"));
+        value = _arena->make<ValueNode>(sline, parseChar(current().value));
+        step();
+        trace(TRACE_CHARACTER);
     } else if (check(INT_CONSTANT)) {
-        ret->node = std::make_shared<ValueNode>(sline, parseInt(current().value));
-        ret->log(step());
-        ret->log(std::make_shared<ParserLog>(line(), "Number"));
+        value = _arena->make<ValueNode>(sline, parseInt(current().value));
+        step();
+        trace(TRACE_NUMBER);
     }
 
-    return ret;
+    return value;
 }
 
-Op Parser::parseUnaryOp(std::shared_ptr<ParseResult> buffer) {
+Op Parser::parseUnaryOp() {
     Op ret;
 
     switch (current().type) {
@@ -677,365 +792,328 @@ Op Parser::parseUnaryOp(std::shared_ptr<ParseResult> buffer) {
             ret = OP_EMPTY;
             break;
     }
-    buffer->log(step());
+    step();
 
-    buffer->log(std::make_shared<ParserLog>(line(), "UnaryOp"));
+    trace(TRACE_UNARY_OP);
 
     return ret;
 }
 
-std::shared_ptr<ParseResult> Parser::parseUnaryExp() {
-    auto ret = std::make_shared<ParseResult>();
-
-    auto sline = line();
-    if (match({IDENT, LEFT_BRACE})) {
-        auto ident = current().value;
-        ret->log(step());
-        ret->log(step());
-        auto params = std::shared_ptr<FuncRParamsNode>();
-
-        if (auto result = tryParse<FuncRParamsNode>(&Parser::parseFuncRParams, ret); result) {
-            params = result;
+UnaryExpNode* Parser::parseUnaryExp() {
+    UnaryExpNode* unary = nullptr;
+    if (_pending_lval) {
+        auto sline = _pending_lval->line();
+        unary = _arena->make<UnaryExpNode>(sline, parsePrimary());
+    } else if (auto sline = line(); match({IDENT, LEFT_BRACE})) {
+        auto ident = current().ident;
+        step();
+        step();
+        FuncRParamsNode* params = nullptr;
+
+        if (checkExp()) {
+            params = parseFuncRParams();
         }
         if (check(RIGHT_BRACE)) {
-            ret->log(step());
+            step();
         } else {
-            ret->logError(std::make_shared<ErrorLog>(last().line, "unary exp ident() brace missing", buaa::ERROR_MISSING_BRACE));
+            logError(last().line, "unary exp ident() brace missing", buaa::ERROR_MISSING_BRACE);
         }
 
-        ret->node = std::make_shared<UnaryExpNode>(sline, ident, params);
+        unary = _arena->make<UnaryExpNode>(sline, ident, params);
     } else if (check(ADD) || check(MINUS) || check(NOT)) {
-        auto op = parseUnaryOp(ret);
-        auto exp = tryParse<UnaryExpNode>(&Parser::parseUnaryExp, ret);;
+        auto op = parseUnaryOp();
+        auto exp = parseUnaryExp();
 
-        ret->node = std::make_shared<UnaryExpNode>(sline, op, exp);
-    } else if (auto primary = tryParse<PrimaryExpNode>(&Parser::parsePrimary, ret); primary) {
-        ret->node = std::make_shared<UnaryExpNode>(sline, primary);
+        unary = _arena->make<UnaryExpNode>(sline, op, exp);
+    } else if (auto primary = parsePrimary(); primary) {
+        unary = _arena->make<UnaryExpNode>(sline, primary);
+    } else {
+        return nullptr; // abort
     }
 
-    ret->log(std::make_shared<ParserLog>(line(), "UnaryExp"));
+    trace(TRACE_UNARY_EXP);
 
-    return ret;
+    return unary;
 }
 
-std::shared_ptr<ParseResult> Parser::parseFuncRParams() {
-    auto ret = std::make_shared<ParseResult>();
-
+FuncRParamsNode* Parser::parseFuncRParams() {
     auto sline = line();
-    auto exps = std::vector<std::shared_ptr<ExpNode>>();
-    if (auto exp = tryParse<ExpNode>(&Parser::parseExp, false, ret); exp) {
+    auto exps = std::vector<ExpNode*>();
+    if (auto exp = parseExp(); exp) {
         exps.push_back(exp);
     } else {
-        return ret; // abort
+        return nullptr; // abort
     }
     while (check(COMMA)) {
-        ret->log(step());
-        if (auto exp = tryParse<ExpNode>(&Parser::parseExp, false, ret); exp) {
+        step();
+        if (auto exp = parseExp(); exp) {
             exps.push_back(exp);
         } else {
-            return ret; // abort
+            return nullptr; // abort
         }
     }
 
-    ret->node = std::make_shared<FuncRParamsNode>(sline, exps);
-
-    ret->log(std::make_shared<ParserLog>(line(), "FuncRParams"));
+    trace(TRACE_FUNC_R_PARAMS);
 
-    return ret;
+    return _arena->make<FuncRParamsNode>(sline, _arena->span(exps));
 }
 
-std::shared_ptr<ParseResult> Parser::parseAddExp() {
-    auto ret = std::make_shared<ParseResult>();
-
-    auto node = std::shared_ptr<ExpNode>();
-    if (auto exp = tryParse<ExpNode>(&Parser::parseMulExp, ret); exp) {
+ExpNode* Parser::parseAddExp() {
+    ExpNode* node = nullptr;
+    if (auto exp = parseMulExp(); exp) {
         node = exp;
-        ret->log(std::make_shared<ParserLog>(line(), "AddExp"));
+        trace(TRACE_ADD_EXP);
     } else {
-        return ret; // abort
+        return nullptr; // abort
     }
 
     while (check(ADD) || check(MINUS)) {
         auto sline = line();
         auto op = check(ADD) ? OP_ADD : OP_MINUS;
-        ret->log(step());
-        auto exp = tryParse<ExpNode>(&Parser::parseMulExp, ret);
-        node = std::make_shared<BinaryExpNode>(sline, op, node, exp);
-        ret->log(std::make_shared<ParserLog>(line(), "AddExp"));
+        step();
+        auto exp = parseMulExp();
+        node = _arena->make<BinaryExpNode>(sline, op, node, exp);
+        trace(TRACE_ADD_EXP);
     }
 
-    ret->node = node;
-
-    return ret;
+    return node;
 }
 
-std::shared_ptr<ParseResult> Parser::parseMulExp() {
-    auto ret = std::make_shared<ParseResult>();
-
-    auto node = std::shared_ptr<ExpNode>();
-    if (auto exp = tryParse<ExpNode>(&Parser::parseUnaryExp, ret); exp) {
+ExpNode* Parser::parseMulExp() {
+    ExpNode* node = nullptr;
+    if (auto exp = parseUnaryExp(); exp) {
         node = exp;
-        ret->log(std::make_shared<ParserLog>(line(), "MulExp"));
+        trace(TRACE_MUL_EXP);
     } else {
-        return ret; // abort
+        return nullptr; // abort
     }
 
     while (check(MULTIPLY) || check(DIVIDE) || check(MOD)) {
         auto sline = line();
         auto op = check(MULTIPLY) ? OP_MUL : check(DIVIDE) ? OP_DIV : OP_MOD;
-        ret->log(step());
-        auto exp = tryParse<ExpNode>(&Parser::parseUnaryExp, ret);
-        node = std::make_shared<BinaryExpNode>(sline, op, node, exp);
-        ret->log(std::make_shared<ParserLog>(line(), "MulExp"));
+        step();
+        auto exp = parseUnaryExp();
+        node = _arena->make<BinaryExpNode>(sline, op, node, exp);
+        trace(TRACE_MUL_EXP);
     }
 
-    ret->node = node;
-
-    return ret;
+    return node;
 }
 
-std::shared_ptr<ParseResult> Parser::parseRelExp() {
-    auto ret = std::make_shared<ParseResult>();
-
-    auto node = std::shared_ptr<ExpNode>();
-    if (auto exp = tryParse<ExpNode>(&Parser::parseAddExp, ret); exp) {
+ExpNode* Parser::parseRelExp() {
+    ExpNode* node = nullptr;
+    if (auto exp = parseAddExp(); exp) {
         node = exp;
-        ret->log(std::make_shared<ParserLog>(line(), "RelExp"));
+        trace(TRACE_REL_EXP);
     } else {
-        return ret; // abort
+        return nullptr; // abort
     }
 
     while (check(GREATER) || check(GREATER_EQUAL) || check(LESSER) || check(LESSER_EQUAL)) {
         auto sline = line();
         auto op = check(GREATER) ? OP_GT : check(GREATER_EQUAL) ? OP_GE : check(LESSER) ? OP_LT : OP_LE;
-        ret->log(step());
-        auto exp = tryParse<ExpNode>(&Parser::parseAddExp, ret);
-        node = std::make_shared<BinaryExpNode>(sline, op, node, exp);
-        ret->log(std::make_shared<ParserLog>(line(), "RelExp"));
+        step();
+        auto exp = parseAddExp();
+        node = _arena->make<BinaryExpNode>(sline, op, node, exp);
+        trace(TRACE_REL_EXP);
     }
 
-    ret->node = node;
-
-    return ret;
+    return node;
 }
 
-std::shared_ptr<ParseResult> Parser::parseEqExp() {
-    auto ret = std::make_shared<ParseResult>();
-
-    auto node = std::shared_ptr<ExpNode>();
-    if (auto exp = tryParse<ExpNode>(&Parser::parseRelExp, ret); exp) {
+ExpNode* Parser::parseEqExp() {
+    ExpNode* node = nullptr;
+    if (auto exp = parseRelExp(); exp) {
         node = exp;
-        ret->log(std::make_shared<ParserLog>(line(), "EqExp"));
+        trace(TRACE_EQ_EXP);
     } else {
-        return ret; // abort
+        return nullptr; // abort
     }
 
     while (check(EQUAL) || check(NOT_EQUAL)) {
         auto sline = line();
         auto op = check(EQUAL) ? OP_EQ : OP_NEQ;
-        ret->log(step());
-        auto exp = tryParse<ExpNode>(&Parser::parseRelExp, ret);
-        node = std::make_shared<BinaryExpNode>(sline, op, node, exp);
-        ret->log(std::make_shared<ParserLog>(line(), "EqExp"));
+        step();
+        auto exp = parseRelExp();
+        node = _arena->make<BinaryExpNode>(sline, op, node, exp);
+        trace(TRACE_EQ_EXP);
     }
 
-    ret->node = node;
-
-    return ret;
+    return node;
 }
 
-std::shared_ptr<ParseResult> Parser::parseLAndExp() {
-    auto ret = std::make_shared<ParseResult>();
-
-    auto node = std::shared_ptr<ExpNode>();
-    if (auto exp = tryParse<ExpNode>(&Parser::parseEqExp, ret); exp) {
+ExpNode* Parser::parseLAndExp() {
+    ExpNode* node = nullptr;
+    if (auto exp = parseEqExp(); exp) {
         node = exp;
-        ret->log(std::make_shared<ParserLog>(line(), "LAndExp"));
+        trace(TRACE_L_AND_EXP);
     } else {
-        return ret; // abort
+        return nullptr; // abort
     }
 
     while (check(AND)) {
         auto sline = line();
         auto op = OP_AND;
-        ret->log(step());
-        auto exp = tryParse<ExpNode>(&Parser::parseEqExp, ret);
-        node = std::make_shared<BinaryExpNode>(sline, op, node, exp);
-        ret->log(std::make_shared<ParserLog>(line(), "LAndExp"));
+        step();
+        auto exp = parseEqExp();
+        node = _arena->make<BinaryExpNode>(sline, op, node, exp);
+        trace(TRACE_L_AND_EXP);
     }
 
-    ret->node = node;
-
-    return ret;
+    return node;
 }
 
-std::shared_ptr<ParseResult> Parser::parseLOrExp() {
-    auto ret = std::make_shared<ParseResult>();
-
-    auto node = std::shared_ptr<ExpNode>();
-    if (auto exp = tryParse<ExpNode>(&Parser::parseLAndExp, ret); exp) {
+ExpNode* Parser::parseLOrExp() {
+    ExpNode* node = nullptr;
+    if (auto exp = parseLAndExp(); exp) {
         node = exp;
-        ret->log(std::make_shared<ParserLog>(line(), "LOrExp"));
+        trace(TRACE_L_OR_EXP);
     } else {
-        return ret; // abort
+        return nullptr; // abort
     }
 
     while (check(OR)) {
         auto sline = line();
         auto op = OP_OR;
-        ret->log(step());
-        auto exp = tryParse<ExpNode>(&Parser::parseLAndExp, ret);
-        node = std::make_shared<BinaryExpNode>(sline, op, node, exp);
-        ret->log(std::make_shared<ParserLog>(line(), "LOrExp"));
+        step();
+        auto exp = parseLAndExp();
+        node = _arena->make<BinaryExpNode>(sline, op, node, exp);
+        trace(TRACE_L_OR_EXP);
     }
 
-    ret->node = node;
-
-    return ret;
+    return node;
 }
 
-std::shared_ptr<ParseResult> Parser::parseDecl() {
-    auto ret = std::make_shared<ParseResult>();
-
+DeclNode* Parser::parseDecl() {
     auto sline = line();
     auto is_const = false;
     if (check(CONST)) {
         is_const = true;
-        ret->log(step());
+        step();
     }
 
     auto type = token2Type(current());
     if (!type) {
-        return ret; // abort
+        return nullptr; // abort
     }
-    ret->log(step());
+    step();
 
-    auto defs = std::vector<std::shared_ptr<DefNode>>();
-    if (auto def = tryParse<DefNode>(&Parser::parseDef, is_const, ret); def) {
+    auto defs = std::vector<DefNode*>();
+    if (auto def = parseDef(is_const); def) {
         defs.push_back(def);
     } else {
-        return ret; // abort
+        return nullptr; // abort
     }
     while (check(COMMA)) {
-        ret->log(step());
-        if (auto def = tryParse<DefNode>(&Parser::parseDef, is_const, ret); def) {
+        step();
+        if (auto def = parseDef(is_const); def) {
             defs.push_back(def);
         } else {
-            return ret; // abort
+            return nullptr; // abort
         }
     }
 
     if (check(SEMICOLON)) {
-        ret->log(step());
+        step();
     } else {
-        ret->logError(std::make_shared<ErrorLog>(last().line, "decl no semi", buaa::ERROR_MISSING_SEMICOLON));
+        logError(last().line, "decl no semi", buaa::ERROR_MISSING_SEMICOLON);
     }
 
     if (is_const) {
-        ret->log(std::make_shared<ParserLog>(line(), "ConstDecl"));
+        trace(TRACE_CONST_DECL);
     } else {
-        ret->log(std::make_shared<ParserLog>(line(), "VarDecl"));
+        trace(TRACE_VAR_DECL);
     }
 
-    ret->node = std::make_shared<DeclNode>(sline, type, is_const, defs);
-
-    return ret;
+    return _arena->make<DeclNode>(sline, type, is_const, _arena->span(defs));
 }
 
-std::shared_ptr<ParseResult> Parser::parseDef(bool is_const) {
-    auto ret = std::make_shared<ParseResult>();
-
+DefNode* Parser::parseDef(bool is_const) {
     if (!check(IDENT)) {
-        return ret; // abort
+        return nullptr; // abort
     }
     auto sline = line();
-    auto ident = current().value;
-    ret->log(step());
-    auto array_exp = std::shared_ptr<ExpNode>();
+    auto ident = current().ident;
+    step();
+    ExpNode* array_exp = nullptr;
     if (check(LEFT_SQUARE)) {
-        ret->log(step());
-        array_exp = tryParse<ExpNode>(&Parser::parseExp, true, ret);
+        step();
+        array_exp = parseExp(true);
         if (check(RIGHT_SQUARE)) {
-            ret->log(step());
+            step();
         } else {
-            ret->logError(std::make_shared<ErrorLog>(last().line, "def no square", buaa::ERROR_MISSING_SQUARE));
+            logError(last().line, "def no square", buaa::ERROR_MISSING_SQUARE);
         }
     }
 
-    auto init_val = std::shared_ptr<InitValNode>();
+    InitValNode* init_val = nullptr;
     if (is_const) {
-        if (!check(ASSIGN)) {
-            return ret; // abort
-        }
-        ret->log(step());
-        init_val = tryParse<InitValNode>(&Parser::parseInitVal, is_const, ret);
+        CHECK_AND_STEP(ASSIGN);
+        init_val = parseInitVal(is_const);
     } else {
         if (check(ASSIGN)) {
-            ret->log(step());
-            init_val = tryParse<InitValNode>(&Parser::parseInitVal, is_const, ret);
+            step();
+            init_val = parseInitVal(is_const);
         }
     }
 
     if (is_const) {
-        ret->log(std::make_shared<ParserLog>(line(), "ConstDef"));
+        trace(TRACE_CONST_DEF);
     } else {
-        ret->log(std::make_shared<ParserLog>(line(), "VarDef"));
+        trace(TRACE_VAR_DEF);
     }
 
-    ret->node = std::make_shared<DefNode>(sline, ident, init_val, is_const, array_exp);
-
-    return ret;
+    return _arena->make<DefNode>(sline, ident, init_val, is_const, array_exp);
 }
 
-std::shared_ptr<ParseResult> Parser::parseInitVal(bool is_const) {
-    auto ret = std::make_shared<ParseResult>();
-
+InitValNode* Parser::parseInitVal(bool is_const) {
     auto sline = line();
+    InitValNode* init_val = nullptr;
     if (check(LEFT_BRAKET)) {
-        ret->log(step());
-        auto init_val_set = std::vector<std::shared_ptr<ExpNode>>();
+        step();
+        auto init_val_set = std::vector<ExpNode*>();
         if (!check(RIGHT_BRAKET)) {
-            if (auto exp = tryParse<ExpNode>(&Parser::parseExp, is_const, ret); exp) {
+            if (auto exp = parseExp(is_const); exp) {
                 init_val_set.push_back(exp);
             } else {
-                return ret; // abort
+                return nullptr; // abort
             }
             while (check(COMMA)) {
-                ret->log(step());
-                if (auto exp = tryParse<ExpNode>(&Parser::parseExp, is_const, ret); exp) {
+                step();
+                if (auto exp = parseExp(is_const); exp) {
                     init_val_set.push_back(exp);
                 } else {
-                    return ret; // abort
+                    return nullptr; // abort
                 }
             }
             if (check(RIGHT_BRAKET)) {
-                ret->log(step());
+                step();
             }
         } else {
-            ret->log(step());
+            step();
         }
 
-        ret->node = std::make_shared<InitValNode>(sline, init_val_set, is_const);
+        init_val = _arena->make<InitValNode>(sline, _arena->span(init_val_set), is_const);
     } else if (check(STRING)) {
-        auto str = current().value;
-        ret->log(step());
+        auto str = _arena->string(current().value);
+        step();
 
-        ret->node = std::make_shared<InitValNode>(sline, str, is_const);
-    } else if (auto exp = tryParse<ExpNode>(&Parser::parseExp, is_const, ret); exp) {
-        ret->node = std::make_shared<InitValNode>(sline, exp, is_const);
+        init_val = _arena->make<InitValNode>(sline, str, is_const);
+    } else if (auto exp = parseExp(is_const); exp) {
+        init_val = _arena->make<InitValNode>(sline, exp, is_const);
+    } else {
+        return nullptr; // abort
     }
 
     if (is_const) {
-        ret->log(std::make_shared<ParserLog>(line(), "ConstInitVal"));
+        trace(TRACE_CONST_INIT_VAL);
     } else {
-        ret->log(std::make_shared<ParserLog>(line(), "InitVal"));
+        trace(TRACE_INIT_VAL);
     }
 
-    return ret;
+    return init_val;
 }
 
-
-
 }
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,253 @@
+#include "scan.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BLANG_SCAN_X86
+#include <immintrin.h>
+#endif
+
+namespace blang {
+
+namespace frontend {
+
+namespace scan {
+
+namespace {
+
+inline bool isBlank(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\b' || ch == '\n';
+}
+
+const char* skipBlankScalar(const char* p, const char* end, uint32_t& lines) {
+    while (p < end && isBlank(*p)) {
+        lines += *p == '\n';
+        p++;
+    }
+    return p;
+}
+
+const char* findLineBreakScalar(const char* p, const char* end) {
+    while (p < end && *p != '\n' && *p != '\r') {
+        p++;
+    }
+    return p;
+}
+
+const char* findCommentEndScalar(const char* p, const char* end, uint32_t& lines) {
+    while (p < end && !(p[0] == '*' && p[1] == '/')) {
+        lines += *p == '\n';
+        p++;
+    }
+    return p;
+}
+
+/**
+ * @brief Count of set bits of mask below bit n
+ * 
+ */
+inline uint32_t countBelow(uint32_t mask, uint32_t n) {
+    return __builtin_popcount(mask & ((1u << n) - 1));
+}
+
+#ifdef BLANG_SCAN_X86
+
+const char* skipBlankSse2(const char* p, const char* end, uint32_t& lines) {
+    const auto space = _mm_set1_epi8(' ');
+    const auto tab = _mm_set1_epi8('\t');
+    const auto backspace = _mm_set1_epi8('\b');
+    const auto newline = _mm_set1_epi8('\n');
+    while (p + 16 <= end) {
+        auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        auto lf = _mm_cmpeq_epi8(block, newline);
+        auto blank = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(block, space), _mm_cmpeq_epi8(block, tab)),
+            _mm_or_si128(_mm_cmpeq_epi8(block, backspace), lf));
+        uint32_t lf_mask = _mm_movemask_epi8(lf);
+        uint32_t stop = ~_mm_movemask_epi8(blank) & 0xffffu;
+        if (stop) {
+            auto n = __builtin_ctz(stop);
+            lines += countBelow(lf_mask, n);
+            return p + n;
+        }
+        lines += __builtin_popcount(lf_mask);
+        p += 16;
+    }
+    return skipBlankScalar(p, end, lines);
+}
+
+const char* findLineBreakSse2(const char* p, const char* end) {
+    const auto newline = _mm_set1_epi8('\n');
+    const auto carriage = _mm_set1_epi8('\r');
+    while (p + 16 <= end) {
+        auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        uint32_t found = _mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(block, newline), _mm_cmpeq_epi8(block, carriage)));
+        if (found) {
+            return p + __builtin_ctz(found);
+        }
+        p += 16;
+    }
+    return findLineBreakScalar(p, end);
+}
+
+const char* findCommentEndSse2(const char* p, const char* end, uint32_t& lines) {
+    const auto star = _mm_set1_epi8('*');
+    const auto slash = _mm_set1_epi8('/');
+    const auto newline = _mm_set1_epi8('\n');
+    // the second load reads one byte past the block, end[0] is readable
+    while (p + 16 <= end) {
+        auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        auto next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1));
+        uint32_t found = _mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(block, star), _mm_cmpeq_epi8(next, slash)));
+        uint32_t lf_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, newline));
+        if (found) {
+            auto n = __builtin_ctz(found);
+            lines += countBelow(lf_mask, n);
+            return p + n;
+        }
+        lines += __builtin_popcount(lf_mask);
+        p += 16;
+    }
+    return findCommentEndScalar(p, end, lines);
+}
+
+__attribute__((target("avx2")))
+const char* skipBlankAvx2(const char* p, const char* end, uint32_t& lines) {
+    const auto space = _mm256_set1_epi8(' ');
+    const auto tab = _mm256_set1_epi8('\t');
+    const auto backspace = _mm256_set1_epi8('\b');
+    const auto newline = _mm256_set1_epi8('\n');
+    while (p + 32 <= end) {
+        auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        auto lf = _mm256_cmpeq_epi8(block, newline);
+        auto blank = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, space), _mm256_cmpeq_epi8(block, tab)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, backspace), lf));
+        uint32_t lf_mask = _mm256_movemask_epi8(lf);
+        uint32_t stop = ~static_cast<uint32_t>(_mm256_movemask_epi8(blank));
+        if (stop) {
+            auto n = __builtin_ctz(stop);
+            lines += __builtin_popcount(lf_mask & ((1ull << n) - 1));
+            return p + n;
+        }
+        lines += __builtin_popcount(lf_mask);
+        p += 32;
+    }
+    return skipBlankSse2(p, end, lines);
+}
+
+__attribute__((target("avx2")))
+const char* findLineBreakAvx2(const char* p, const char* end) {
+    const auto newline = _mm256_set1_epi8('\n');
+    const auto carriage = _mm256_set1_epi8('\r');
+    while (p + 32 <= end) {
+        auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        uint32_t found = _mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, newline), _mm256_cmpeq_epi8(block, carriage)));
+        if (found) {
+            return p + __builtin_ctz(found);
+        }
+        p += 32;
+    }
+    return findLineBreakSse2(p, end);
+}
+
+__attribute__((target("avx2")))
+const char* findCommentEndAvx2(const char* p, const char* end, uint32_t& lines) {
+    const auto star = _mm256_set1_epi8('*');
+    const auto slash = _mm256_set1_epi8('/');
+    const auto newline = _mm256_set1_epi8('\n');
+    while (p + 32 <= end) {
+        auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        auto next = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 1));
+        uint32_t found = _mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(block, star), _mm256_cmpeq_epi8(next, slash)));
+        uint32_t lf_mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newline));
+        if (found) {
+            auto n = __builtin_ctz(found);
+            lines += __builtin_popcount(lf_mask & ((1ull << n) - 1));
+            return p + n;
+        }
+        lines += __builtin_popcount(lf_mask);
+        p += 32;
+    }
+    return findCommentEndSse2(p, end, lines);
+}
+
+#endif
+
+struct Kernels {
+    ScanLevel level;
+    const char* (*skip_blank)(const char*, const char*, uint32_t&);
+    const char* (*find_line_break)(const char*, const char*);
+    const char* (*find_comment_end)(const char*, const char*, uint32_t&);
+};
+
+Kernels kernelsOf(ScanLevel level) {
+    switch (level) {
+#ifdef BLANG_SCAN_X86
+        case SCAN_AVX2:
+            return {SCAN_AVX2, skipBlankAvx2, findLineBreakAvx2, findCommentEndAvx2};
+        case SCAN_SSE2:
+            return {SCAN_SSE2, skipBlankSse2, findLineBreakSse2, findCommentEndSse2};
+#endif
+        default:
+            return {SCAN_SCALAR, skipBlankScalar, findLineBreakScalar, findCommentEndScalar};
+    }
+}
+
+Kernels& active() {
+    static Kernels kernels = kernelsOf(detect());
+    return kernels;
+}
+
+}
+
+ScanLevel detect() {
+#ifdef BLANG_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return SCAN_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return SCAN_SSE2;
+    }
+#endif
+    return SCAN_SCALAR;
+}
+
+ScanLevel level() {
+    return active().level;
+}
+
+ScanLevel select(ScanLevel level) {
+    auto best = detect();
+    active() = kernelsOf(level > best ? best : level);
+    return active().level;
+}
+
+const char* name(ScanLevel level) {
+    switch (level) {
+        case SCAN_AVX2: return "avx2";
+        case SCAN_SSE2: return "sse2";
+        default:        return "scalar";
+    }
+}
+
+const char* skipBlank(const char* p, const char* end, uint32_t& lines) {
+    return active().skip_blank(p, end, lines);
+}
+
+const char* findLineBreak(const char* p, const char* end) {
+    return active().find_line_break(p, end);
+}
+
+const char* findCommentEnd(const char* p, const char* end, uint32_t& lines) {
+    return active().find_comment_end(p, end, lines);
+}
+
+}
+
+}
+
+}
@@ -1,232 +1,524 @@
 #include "syntax_checker.hpp"
 #include "ast.hpp"
 #include "symbol_table.hpp"
+#include <algorithm>
+#include <cstdint>
 #include <memory>
 
 namespace blang {
 
 namespace frontend {
 
-SyntaxChecker::SyntaxChecker(std::shared_ptr<Logger> logger) :
-    _logger(logger) {
-    
+/**
+ * @brief Fold a binary op on constants, false if it cannot be folded
+ *
+ * @param op
+ * @param left
+ * @param right
+ * @param value Folded value
+ * @return true
+ * @return false
+ */
+static bool fold(Op op, int32_t left, int32_t right, int32_t& value) {
+    switch (op) {
+        case OP_ADD:    value = left +  right; return true;
+        case OP_MINUS:  value = left -  right; return true;
+        case OP_MUL:    value = left *  right; return true;
+        case OP_DIV:
+        case OP_MOD:
+            if (right == 0 || (left == INT32_MIN && right == -1)) {
+                return false;
+            }
+            value = op == OP_DIV ? left / right : left % right;
+            return true;
+        case OP_AND:    value = left && right; return true;
+        case OP_OR:     value = left || right; return true;
+        case OP_EQ:     value = left == right; return true;
+        case OP_NEQ:    value = left != right; return true;
+        case OP_GE:     value = left >= right; return true;
+        case OP_GT:     value = left >  right; return true;
+        case OP_LE:     value = left <= right; return true;
+        case OP_LT:     value = left <  right; return true;
+        default:
+            return false;
+    }
+}
+
+SyntaxChecker::SyntaxChecker(std::shared_ptr<Logger> logger, std::shared_ptr<tools::Arena> arena) :
+    _logger(logger), _arena(arena), _decl_type(nullptr), _pending({false}), _void_func(false), _loop_depth(0), _visits(0) {
+
+}
+
+std::shared_ptr<SymbolTable> SyntaxChecker::check(CompNode* comp_unit) {
+    _table = std::make_shared<SymbolTable>();
+    _pending = {false};
+    _void_func = false;
+    _loop_depth = 0;
+    _errors.clear();
+    _loop_errors.clear();
+    _return_errors.clear();
+    _visits = 0;
+
+    walk(comp_unit);
+
+    return _table;
+}
+
+void SyntaxChecker::flush() {
+    for (auto& error : _errors) {
+        _logger->logError(error.line, error.message, error.error);
+    }
+    _errors.clear();
 }
 
-std::shared_ptr<GlobalSymbolTable> SyntaxChecker::check(std::shared_ptr<CompNode> comp_unit) {
-    _global_table = std::make_shared<GlobalSymbolTable>();
-    _current_table = _global_table;
+SyntaxChecker::ExpAttr SyntaxChecker::operand(LValNode& node, bool& defined) {
+    auto ret = ExpAttr{false, 0, false, false, nullptr, false};
+    Type* type = nullptr;
+    bool array = false;
+    if (_pending.active && node.ident() == _pending.ident) {
+        type = _pending.type;
+        array = _pending.array;
+    } else if (auto var = _table->getVar(node.ident()); var) {
+        type = var->type();
+        if (auto array_t = dynamic_cast<ArrayType*>(type); array_t) {
+            type = array_t->type();
+            array = true;
+        }
+    }
 
-    comp_unit->accept(*this);
+    defined = type != nullptr;
+    if (!defined) {
+        return ret;
+    }
+    if (array && !node.exp()) {
+        ret.bare_array = true;
+        ret.element_t = type;
+    } else {
+        ret.not_array = true;
+    }
 
-    return _global_table;
+    return ret;
+}
+
+bool SyntaxChecker::fits(const ExpAttr& attr, Type* type) {
+    if (auto ptr_t = dynamic_cast<PtrType*>(type); ptr_t) {
+        return !attr.not_array && !attr.mixed
+            && (!attr.element_t || Type::is_same(attr.element_t, ptr_t->next()));
+    }
+
+    return !attr.bare_array;
+}
+
+void SyntaxChecker::checkReturned(BlockNode* block) {
+    auto items = block->items();
+    if (items.empty()) {
+        error(block->line(), "no return", buaa::ERROR_FUNC_NO_RETURN);
+        return ;
+    }
+    auto ret_stmt = dynamic_cast<ReturnStmtNode*>(items.back()->stmt());
+    if (!ret_stmt || !ret_stmt->exp()) {
+        error(block->line(), "no return", buaa::ERROR_FUNC_NO_RETURN);
+    }
+}
+
+std::shared_ptr<Var> SyntaxChecker::makeVar(DefNode& node, int32_t length) {
+    std::shared_ptr<Var> var;
+    bool init = node.init_val() != nullptr;
+    if (node.array_exp()) {
+        if (Type::is_same(_decl_type, IntType::get())) {
+            var = Var::getIntArray(node.ident(), node.is_const(), length);
+            if (init) {
+                var->init<int32_t>(*_arena, _init_values, std::max(length, 0));
+            }
+        } else if (Type::is_same(_decl_type, CharType::get())) {
+            var = Var::getCharArray(node.ident(), node.is_const(), length);
+            if (init) {
+                var->init<char>(*_arena, _init_values, std::max(length, 0));
+            }
+        }
+    } else {
+        if (Type::is_same(_decl_type, IntType::get())) {
+            var = Var::getInt(node.ident(), node.is_const());
+            if (init) {
+                var->init<int32_t>(*_arena, _init_values, 1);
+            }
+        } else if (Type::is_same(_decl_type, CharType::get())) {
+            var = Var::getChar(node.ident(), node.is_const());
+            if (init) {
+                var->init<char>(*_arena, _init_values, 1);
+            }
+        }
+    }
+
+    return var;
 }
 
 void SyntaxChecker::visit(CompNode& node) {
     if (node.comp()) {
-        node.comp()->accept(*this);
+        walk(node.comp());
     }
 
     if (node.decl()) {
-        node.decl()->accept(*this);
+        walk(node.decl());
     } else if (node.func_def()) {
-        node.func_def()->accept(*this);
+        walk(node.func_def());
     } else if (node.main_func_def()) {
-        _global_table->main_node() = node.main_func_def();
-        node.main_func_def()->accept(*this);
+        _table->main_node() = node.main_func_def();
+        walk(node.main_func_def());
     }
+    flush();
 }
 
 void SyntaxChecker::visit(DeclNode& node) {
-    auto checker = DefChecker(_logger);
+    _decl_type = node.type();
     for (auto& def : node.defs()) {
-        checker.check(node.type(), *def, _current_table);
-        def->accept(*this);
+        walk(def);
     }
 }
 
 void SyntaxChecker::visit(DefNode& node) {
+    auto redefined = _table->contains(node.ident());
+    if (redefined) {
+        error(node.line(), "def duplicate", buaa::ERROR_IDENT_REDEF);
+    }
+
+    _pending = {!redefined, node.ident(), _decl_type, node.array_exp() != nullptr, _table->depth() == 0};
+    int32_t length = 0;
     if (node.array_exp()) {
-        node.array_exp()->accept(*this);
+        auto attr = walkExp(node.array_exp());
+        length = attr.constant ? attr.value : -1;
     }
+    _init_values.clear();
     if (node.init_val()) {
-        node.init_val()->accept(*this);
+        walk(node.init_val());
+    }
+    _pending.active = false;
+    if (redefined) {
+        return ;
+    }
+
+    auto var = makeVar(node, length);
+    _table->addVar(var);
+    std::string log_type = node.is_const() ? "Const" : "";
+    log_type += Type::is_same(_decl_type, IntType::get()) ? "Int" : "Char";
+    if (node.array_exp()) {
+        log_type += "Array";
     }
+    _logger->logSyntax(node.line(), _table->blockn(), var->ident().str(), log_type);
 }
 
 void SyntaxChecker::visit(InitValNode& node) {
-    if (node.exp()) {
-        node.exp()->accept(*this);
-    } else if (!node.exps().empty()) {
+    if (node.type() == entities::INIT_SINGLE) {
+        auto attr = walkExp(node.exp());
+        _init_values.push_back(attr.constant ? attr.value : -1);
+    } else if (node.type() == entities::INIT_ARRAY) {
         for (auto& exp : node.exps()) {
-            exp->accept(*this);
+            auto attr = walkExp(exp);
+            _init_values.push_back(attr.constant ? attr.value : -1);
+        }
+    } else if (node.type() == entities::INIT_STRING) {
+        for (auto ch : node.str()) {
+            _init_values.push_back(static_cast<int32_t>(ch));
         }
     }
 }
 
 void SyntaxChecker::visit(UnaryExpNode& node) {
     if (node.unary_exp()) {
-        node.unary_exp()->accept(*this);
+        auto attr = walkExp(node.unary_exp());
+        attr.value = node.op() == OP_ADD ? attr.value
+                : node.op() == OP_MINUS ? -attr.value
+                : node.op() == OP_NOT ? !attr.value : 0;
+        _attr = attr;
     } else if (node.primary_exp()) {
-        node.primary_exp()->accept(*this);
+        walk(node.primary_exp());
     } else if (!node.ident().empty()) {
-        auto ident_checker = IdentChecker(_logger);
-        ident_checker.check(node, _current_table);
-        auto param_checker = ParamChecker(_logger);
-        param_checker.check(node, _current_table);
-        if (node.func_rparams()) {
-            node.func_rparams()->accept(*this);
+        // a global def hides a function of the same name from its own initializer
+        std::shared_ptr<Func> func = nullptr;
+        if (!_pending.active || !_pending.global || node.ident() != _pending.ident) {
+            func = _table->getFunc(node.ident());
+        }
+        if (!func) {
+            error(node.line(), "unary ident not defined", buaa::ERROR_IDENT_UNDEF);
         }
-    }
-}
 
-void SyntaxChecker::visit(FuncRParamsNode& node) {
-    for (auto& exp : node.nodes()) {
-        exp->accept(*this);
+        if (auto rparams = node.func_rparams(); rparams) {
+            auto args = rparams->nodes();
+            if (func && func->params().size() != args.size()) {
+                error(rparams->line(), "func param count no match", buaa::ERROR_FUNC_PARAM_COUNT_NOT_MATCH);
+                func = nullptr;
+            }
+            // type errors of this call go before errors inside its arguments
+            auto mark = _errors.size();
+            auto mismatches = std::vector<PendingError>();
+            for (std::size_t i = 0; i < args.size(); i++) {
+                auto attr = walkExp(args[i]);
+                if (func && !fits(attr, std::get<0>(func->params()[i]))) {
+                    mismatches.push_back({rparams->line(), "func param type no match", buaa::ERROR_FUNC_PARAM_TYPE_NOT_MATCH});
+                }
+            }
+            _errors.insert(_errors.begin() + mark, mismatches.begin(), mismatches.end());
+        }
+        _attr = ExpAttr{false, 0, false, true, nullptr, false};
     }
 }
 
 void SyntaxChecker::visit(PrimaryExpNode& node) {
     if (node.exp()) {
-        node.exp()->accept(*this);
+        walk(node.exp());
     } else if (node.lval()) {
-        node.lval()->accept(*this);
+        walk(node.lval());
     } else if (node.value()) {
-        node.value()->accept(*this);
+        walk(node.value());
     }
 }
 
 void SyntaxChecker::visit(LValNode& node) {
-    auto checker = IdentChecker(_logger);
-    checker.check(node, _current_table);
+    bool defined = false;
+    auto attr = operand(node, defined);
+    if (!defined) {
+        error(node.line(), "lval ident not defined", buaa::ERROR_IDENT_UNDEF);
+    }
+    auto index = ExpAttr{false, 0, false, false, nullptr, false};
     if (node.exp()) {
-        node.exp()->accept(*this);
+        index = walkExp(node.exp());
+    }
+
+    // constant value never sees a pending def
+    auto var = _table->getVar(node.ident());
+    if (var && var->is_const()) {
+        if (Type::is_same(var->type(), IntType::get())) {
+            attr.constant = true;
+            attr.value = var->at<int32_t>(0);
+        } else if (Type::is_same(var->type(), CharType::get())) {
+            attr.constant = true;
+            attr.value = static_cast<int32_t>(var->at<char>(0));
+        } else if (auto array_t = dynamic_cast<ArrayType*>(var->type()); array_t) {
+            if (node.exp() && index.constant && static_cast<uint32_t>(index.value) < array_t->length()) {
+                if (Type::is_same(array_t->type(), IntType::get())) {
+                    attr.constant = true;
+                    attr.value = var->at<int32_t>(index.value);
+                } else if (Type::is_same(array_t->type(), CharType::get())) {
+                    attr.constant = true;
+                    attr.value = static_cast<int32_t>(var->at<char>(index.value));
+                }
+            }
+        }
     }
+    _attr = attr;
 }
 
-void SyntaxChecker::visit(ValueNode& node) {}
+void SyntaxChecker::visit(ValueNode& node) {
+    _attr = ExpAttr{false, 0, false, true, nullptr, false};
+    if (Type::is_same(node.type(), IntType::get())) {
+        _attr.constant = true;
+        _attr.value = node.get<int32_t>();
+    } else if (Type::is_same(node.type(), CharType::get())) {
+        _attr.constant = true;
+        _attr.value = static_cast<int32_t>(node.get<char>());
+    }
+}
 
 void SyntaxChecker::visit(BinaryExpNode& node) {
-    node.left()->accept(*this);
-    node.right()->accept(*this);
+    auto left = walkExp(node.left());
+    auto right = walkExp(node.right());
+
+    auto attr = ExpAttr{false, 0, false, false, nullptr, false};
+    attr.constant = left.constant && right.constant && fold(node.op(), left.value, right.value, attr.value);
+    attr.bare_array = left.bare_array || right.bare_array;
+    attr.not_array = left.not_array || right.not_array;
+    attr.element_t = left.element_t ? left.element_t : right.element_t;
+    attr.mixed = left.mixed || right.mixed
+        || (left.element_t && right.element_t && !Type::is_same(left.element_t, right.element_t));
+    _attr = attr;
 }
 
 void SyntaxChecker::visit(FuncDefNode& node) {
-    auto def_checker = DefChecker(_logger);
-    auto block_table = def_checker.check(node, _current_table);
-
+    auto global_blockn = _table->blockn();
+    _table->pushScope();
+    auto params = std::vector<std::tuple<Type*, Ident>>();
     if (node.params()) {
-        node.params()->accept(*this);
+        walk(node.params());
+        params.assign(node.params()->params().begin(), node.params()->params().end());
+    }
+    auto func = std::make_shared<Func>(node.type(), node.ident(), params, &node);
+
+    std::string log_type;
+    if (Type::is_same(node.type(), VoidType::get())) {
+        log_type = "VoidFunc";
+    } else if (Type::is_same(node.type(), IntType::get())) {
+        log_type = "IntFunc";
+    } else if (Type::is_same(node.type(), CharType::get())) {
+        log_type = "CharFunc";
     }
 
-    auto tmp = _current_table;
-    _current_table = block_table;
-    node.block()->accept(*this);
-
-    auto block_checker = BlockChecker(_logger);
-    block_checker.check(*node.block(), _current_table);
+    if (!_table->addFunc(func)) {
+        error(node.line(), "func def duplicate", buaa::ERROR_IDENT_REDEF);
+    } else {
+        _logger->logSyntax(node.line(), global_blockn, func->ident().str(), log_type);
+    }
 
-    auto return_checker = ReturnChecker(_logger);
-    return_checker.check(node, _current_table);
+    _void_func = Type::is_same(node.type(), VoidType::get());
+    _loop_depth = 0;
+    walk(node.block());
 
-    _current_table = tmp;
+    _errors.insert(_errors.end(), _loop_errors.begin(), _loop_errors.end());
+    if (_void_func) {
+        _errors.insert(_errors.end(), _return_errors.begin(), _return_errors.end());
+    } else {
+        checkReturned(node.block());
+    }
+    _loop_errors.clear();
+    _return_errors.clear();
+    _void_func = false;
+    _table->popScope();
 }
 
-void SyntaxChecker::visit(FuncFParamsNode& node) {}
+void SyntaxChecker::visit(FuncFParamsNode& node) {
+    for (auto& [type, ident] : node.params()) {
+        std::shared_ptr<Var> var;
+        std::string log_type = "";
+        if (auto ptr_t = dynamic_cast<PtrType*>(type); ptr_t) {
+            auto base_t = ptr_t->next();
+            if (Type::is_same(base_t, IntType::get())) {
+                var = Var::getIntPtr(ident, false);
+                log_type = "IntArray";
+            } else if (Type::is_same(base_t, CharType::get())) {
+                var = Var::getCharPtr(ident, false);
+                log_type = "CharArray";
+            }
+        } else {
+            if (Type::is_same(type, IntType::get())) {
+                var = Var::getInt(ident, false);
+                log_type = "Int";
+            } else if (Type::is_same(type, CharType::get())) {
+                var = Var::getChar(ident, false);
+                log_type = "Char";
+            }
+        }
+        if (!_table->addVar(var)) {
+            error(node.line(), "var def duplicate", buaa::ERROR_IDENT_REDEF);
+        } else {
+            _logger->logSyntax(node.line(), _table->blockn(), var->ident().str(), log_type);
+        }
+    }
+}
 
 void SyntaxChecker::visit(MainNode& node) {
-    auto tmp = _current_table;
-    _current_table = std::make_shared<BlockSymbolTable>(_current_table);
-    node.block()->accept(*this);
-
-    auto block_checker = BlockChecker(_logger);
-    block_checker.check(*node.block(), _current_table);
-
-    auto return_checker = ReturnChecker(_logger);
-    return_checker.check(node, _current_table);
-
-    _current_table = tmp;
+    _table->pushScope();
+    _void_func = false;
+    _loop_depth = 0;
+    walk(node.block());
+
+    _errors.insert(_errors.end(), _loop_errors.begin(), _loop_errors.end());
+    checkReturned(node.block());
+    _loop_errors.clear();
+    _return_errors.clear();
+    _table->popScope();
 }
 
 void SyntaxChecker::visit(BlockNode& node) {
     for (auto& item : node.items()) {
-        item->accept(*this);
+        walk(item);
     }
 }
 
 void SyntaxChecker::visit(BlockItemNode& node) {
     if (node.decl()) {
-        node.decl()->accept(*this);
+        walk(node.decl());
     } else if (node.stmt()) {
-        node.stmt()->accept(*this);
+        walk(node.stmt());
     }
 }
 
 void SyntaxChecker::visit(AssignStmtNode& node) {
-    auto checker = AssignChecker(_logger);
-    checker.check(node, _current_table);
-    node.lval()->accept(*this);
-    node.rval()->accept(*this);
+    if (auto var = _table->getVar(node.lval()->ident()); var && var->is_const()) {
+        error(node.lval()->line(), "const modify", buaa::ERROR_CONST_MODIFY);
+    }
+    walk(node.lval());
+    walk(node.rval());
 }
 
 void SyntaxChecker::visit(RValNode& node) {
     if (node.exp()) {
-        node.exp()->accept(*this);
+        walk(node.exp());
     }
 }
 
 void SyntaxChecker::visit(ReturnStmtNode& node) {
     if (node.exp()) {
-        node.exp()->accept(*this);
+        walk(node.exp());
+        if (_void_func) {
+            _return_errors.push_back({node.line(), "void return", buaa::ERROR_VOID_FUNC_RETURN});
+        }
     }
 }
 
 void SyntaxChecker::visit(PrintfStmtNode& node) {
-    auto checker = PrintfChecker(_logger);
-    checker.check(node, _current_table);
+    auto fmt = node.fmt();
+    std::size_t count = 0;
+    for (auto iter = fmt.find("%d"); iter != std::string_view::npos; iter = fmt.find("%d", iter + 1)) {
+        count++;
+    }
+    for (auto iter = fmt.find("%c"); iter != std::string_view::npos; iter = fmt.find("%c", iter + 1)) {
+        count++;
+    }
+    if (count != node.exps().size()) {
+        error(node.line(), "printf", buaa::ERROR_PRINTF_PARAM_COUNT_NOT_MATCH);
+    }
 
     for (auto& exp : node.exps()) {
-        exp->accept(*this);
+        walk(exp);
     }
 }
 
-void SyntaxChecker::visit(BreakStmtNode& node) {}
+void SyntaxChecker::visit(BreakStmtNode& node) {
+    if (_loop_depth == 0) {
+        _loop_errors.push_back({node.line(), "break", buaa::ERROR_ITER_IDENT_MISUSE});
+    }
+}
 
-void SyntaxChecker::visit(ContinueStmtNode& node) {}
+void SyntaxChecker::visit(ContinueStmtNode& node) {
+    if (_loop_depth == 0) {
+        _loop_errors.push_back({node.line(), "continue", buaa::ERROR_ITER_IDENT_MISUSE});
+    }
+}
 
 void SyntaxChecker::visit(ExpStmtNode& node) {
     if (node.exp()) {
-        node.exp()->accept(*this);
+        walk(node.exp());
     }
 }
 
 void SyntaxChecker::visit(ForStmtNode& node) {
     if (node.for_in()) {
-        node.for_in()->accept(*this);
+        walk(node.for_in());
     }
     if (node.cond()) {
-        node.cond()->accept(*this);
+        walk(node.cond());
     }
     if (node.for_out()) {
-        node.for_out()->accept(*this);
+        walk(node.for_out());
     }
-    node.stmt()->accept(*this);
+    _loop_depth++;
+    walk(node.stmt());
+    _loop_depth--;
 }
 
 void SyntaxChecker::visit(IfStmtNode& node) {
-    node.cond()->accept(*this);
-    node.if_stmt()->accept(*this);
+    walk(node.cond());
+    walk(node.if_stmt());
     if (node.else_stmt()) {
-        node.else_stmt()->accept(*this);
+        walk(node.else_stmt());
     }
 }
 
 void SyntaxChecker::visit(BlockStmtNode& node) {
-    auto tmp = _current_table;
-    _current_table = std::make_shared<BlockSymbolTable>(_current_table);
-    node.block()->accept(*this);
-    _current_table = tmp;
+    _table->pushScope();
+    walk(node.block());
+    _table->popScope();
 }
 
 }
 
-}
\ No newline at end of file
+}
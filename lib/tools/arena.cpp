@@ -0,0 +1,45 @@
+#include "arena.hpp"
+#include <algorithm>
+#include <cstdint>
+
+namespace blang {
+
+namespace tools {
+
+void* Arena::grow(std::size_t size, std::size_t align) {
+    auto next = _cur ? _chunk + 1 : 0;
+    // a chunk left by the previous compilation may be too small for a large request
+    while (next < _chunks.size() && _chunks[next].size < size + align) {
+        next++;
+    }
+    if (next == _chunks.size()) {
+        auto chunk_size = std::max(CHUNK_SIZE, size + align);
+        _chunks.push_back({std::make_unique<char[]>(chunk_size), chunk_size});
+    }
+
+    _chunk = next;
+    _cur = _chunks[next].data.get();
+    _end = _cur + _chunks[next].size;
+
+    return allocate(size, align);
+}
+
+void Arena::reset() {
+    _chunk = 0;
+    _cur = _chunks.empty() ? nullptr : _chunks[0].data.get();
+    _end = _chunks.empty() ? nullptr : _cur + _chunks[0].size;
+    _allocated = 0;
+}
+
+std::size_t Arena::capacity() {
+    std::size_t ret = 0;
+    for (auto& chunk : _chunks) {
+        ret += chunk.size;
+    }
+
+    return ret;
+}
+
+}
+
+}
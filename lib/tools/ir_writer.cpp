@@ -0,0 +1,45 @@
+#include "ir_writer.hpp"
+#include <cerrno>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace blang {
+
+namespace tools {
+
+IrWriter::IrWriter(const std::string& path) : _buffer(), _fd(-1) {
+    _fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (_fd < 0) {
+        throw std::runtime_error("failed to open file: " + path);
+    }
+    _buffer.reserve(FLUSH_SIZE * 2);
+}
+
+IrWriter::~IrWriter() {
+    if (_fd >= 0) {
+        close(_fd);
+    }
+}
+
+void IrWriter::flush() {
+    if (_fd < 0) {
+        return ;
+    }
+    std::size_t written = 0;
+    while (written < _buffer.size()) {
+        auto ret = write(_fd, _buffer.data() + written, _buffer.size() - written);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            throw std::runtime_error("failed to write ir output!");
+        }
+        written += static_cast<std::size_t>(ret);
+    }
+    _buffer.clear();
+}
+
+}
+
+}
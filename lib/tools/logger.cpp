@@ -1,45 +1,146 @@
 #include "logger.hpp"
 #include <algorithm>
+#include <cerrno>
 #include <memory>
+#include <unistd.h>
 #include <vector>
 
 namespace blang {
 
-Logger::Logger() {
+Logger::Logger() : _syntax_sorted(true), _sink(-1) {
 }
 
-void Logger::logError(std::shared_ptr<ErrorLog> error) {
-    _errors.push_back(error);
+uint32_t Logger::push(LogType type, uint32_t line, uint32_t blockn, std::string_view message, uint32_t detail) {
+    auto row = static_cast<uint32_t>(_types.size());
+    _types.push_back(type);
+    _lines.push_back(line);
+    _blockns.push_back(blockn);
+    _messages.push_back(_strings.intern(message).id());
+    _details.push_back(detail);
+    _index[type].push_back(row);
+
+    return row;
+}
+
+void Logger::logError(uint32_t line, std::string_view message, buaa::ErrorType error) {
+    push(LOG_ERROR, line, 0, message, error);
+
+    if (_sink >= 0) {
+        auto text = ErrorLog(line, std::string(message), error).to_string() + "\n";
+        std::size_t written = 0;
+        while (written < text.size()) {
+            auto ret = ::write(_sink, text.data() + written, text.size() - written);
+            if (ret < 0 && errno == EINTR) {
+                continue;
+            }
+            if (ret <= 0) {
+                break;
+            }
+            written += static_cast<std::size_t>(ret);
+        }
+    }
+}
+
+void Logger::logLexer(uint32_t line, frontend::TokenType type, std::string_view value) {
+    push(LOG_LEXER, line, 0, value, type);
+}
+
+void Logger::logParser(uint32_t line, std::string_view name) {
+    push(LOG_PARSER, line, 0, name, 0);
 }
 
-void Logger::log(std::shared_ptr<Log> log) {
-    _logs.push_back(log);
+void Logger::logSyntax(uint32_t line, uint32_t blockn, std::string_view name, std::string_view type) {
+    push(LOG_SYNTAX, line, blockn, name, _strings.intern(type).id());
+    _syntax_sorted = false;
+}
+
+void Logger::clear() {
+    _types.clear();
+    _lines.clear();
+    _blockns.clear();
+    _messages.clear();
+    _details.clear();
+    for (auto& index : _index) {
+        index.clear();
+    }
+    _syntax_order.clear();
+    _syntax_sorted = true;
+    _strings.clear();
 }
 
 void Logger::sortError() {
-    std::stable_sort(_errors.begin(), errors().end(), 
-        [](std::shared_ptr<ErrorLog> e1, std::shared_ptr<ErrorLog> e2) {
-            return e1->line < e2->line;
-        }
-    );
+    auto& errors = _index[LOG_ERROR];
+    auto by_line = [this](uint32_t r1, uint32_t r2) {
+        return _lines[r1] < _lines[r2];
+    };
+    if (!std::is_sorted(errors.begin(), errors.end(), by_line)) {
+        std::stable_sort(errors.begin(), errors.end(), by_line);
+    }
 }
 
-std::vector<std::shared_ptr<SyntaxLog>> Logger::syntax_logs() {
-    auto ret = std::vector<std::shared_ptr<SyntaxLog>>();
+std::vector<std::shared_ptr<ErrorLog>> Logger::errors() {
+    auto ret = std::vector<std::shared_ptr<ErrorLog>>();
+    ret.reserve(_index[LOG_ERROR].size());
 
-    for (auto& log : _logs) {
-        if (auto slog = std::dynamic_pointer_cast<SyntaxLog>(log); slog) {
-            ret.push_back(slog);
+    for (auto row : _index[LOG_ERROR]) {
+        ret.push_back(std::make_shared<ErrorLog>(_lines[row], message(row), static_cast<buaa::ErrorType>(_details[row])));
+    }
+
+    return ret;
+}
+
+std::vector<std::shared_ptr<Log>> Logger::logs() {
+    auto ret = std::vector<std::shared_ptr<Log>>();
+    ret.reserve(_types.size() - _index[LOG_ERROR].size());
+
+    for (uint32_t row = 0; row < _types.size(); row++) {
+        switch (_types[row]) {
+            case LOG_LEXER:
+                ret.push_back(std::make_shared<LexerLog>(_lines[row], static_cast<frontend::TokenType>(_details[row]), message(row)));
+                break;
+            case LOG_PARSER:
+                ret.push_back(std::make_shared<ParserLog>(_lines[row], message(row)));
+                break;
+            case LOG_SYNTAX:
+                ret.push_back(std::make_shared<SyntaxLog>(_lines[row], _blockns[row], message(row), _strings.str(_details[row])));
+                break;
+            default:
+                break;
         }
     }
 
-    std::stable_sort(ret.begin(), ret.end(),
-        [](std::shared_ptr<SyntaxLog> l1, std::shared_ptr<SyntaxLog> l2) {
-            return l1->blockn < l2->blockn;
+    return ret;
+}
+
+std::vector<std::shared_ptr<SyntaxLog>> Logger::syntax_logs() {
+    auto& rows = _index[LOG_SYNTAX];
+    if (!_syntax_sorted) {
+        // counting sort, block numbers are dense and stability comes for free
+        uint32_t max_blockn = 0;
+        for (auto row : rows) {
+            max_blockn = std::max(max_blockn, _blockns[row]);
         }
-    );
+        auto offsets = std::vector<uint32_t>(max_blockn + 2, 0);
+        for (auto row : rows) {
+            offsets[_blockns[row] + 1]++;
+        }
+        for (std::size_t i = 1; i < offsets.size(); i++) {
+            offsets[i] += offsets[i - 1];
+        }
+        _syntax_order.resize(rows.size());
+        for (auto row : rows) {
+            _syntax_order[offsets[_blockns[row]]++] = row;
+        }
+        _syntax_sorted = true;
+    }
+
+    auto ret = std::vector<std::shared_ptr<SyntaxLog>>();
+    ret.reserve(_syntax_order.size());
+    for (auto row : _syntax_order) {
+        ret.push_back(std::make_shared<SyntaxLog>(_lines[row], _blockns[row], message(row), _strings.str(_details[row])));
+    }
 
     return ret;
 }
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,104 @@
+#include "source.hpp"
+#include <fcntl.h>
+#include <fstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace blang {
+
+namespace tools {
+
+SourceBuffer::~SourceBuffer() {
+    if (_mapped) {
+        munmap(const_cast<char*>(_data), _size);
+    }
+}
+
+std::shared_ptr<SourceBuffer> SourceBuffer::load(const std::string& filename, LoadMode mode) {
+    if (mode == LOAD_MMAP) {
+        if (auto source = map(filename); source) {
+            return source;
+        }
+    }
+
+    return read(filename);
+}
+
+std::shared_ptr<SourceBuffer> SourceBuffer::fromString(std::string_view text) {
+    auto source = std::shared_ptr<SourceBuffer>(new SourceBuffer());
+    source->_copy.reserve(text.size() + 1);
+    source->_copy.assign(text.begin(), text.end());
+    source->_copy.push_back('\0');
+    source->_data = source->_copy.data();
+    source->_size = text.size();
+
+    return source;
+}
+
+std::shared_ptr<SourceBuffer> SourceBuffer::map(const std::string& filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("failed to open file: " + filename);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return nullptr;
+    }
+    if (st.st_size <= 0) {
+        close(fd);
+        throw std::runtime_error("file may be empty!");
+    }
+
+    auto size = static_cast<std::size_t>(st.st_size);
+    // the tail of the last page reads as zero and serves as sentinel,
+    // a file filling its last page exactly has no room for one
+    if (size % static_cast<std::size_t>(sysconf(_SC_PAGESIZE)) == 0) {
+        close(fd);
+        return nullptr;
+    }
+    void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return nullptr;
+    }
+    madvise(addr, size, MADV_SEQUENTIAL);
+
+    auto source = std::shared_ptr<SourceBuffer>(new SourceBuffer());
+    source->_data = static_cast<const char*>(addr);
+    source->_size = size;
+    source->_mapped = true;
+
+    return source;
+}
+
+std::shared_ptr<SourceBuffer> SourceBuffer::read(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+
+    if (!file) {
+        throw std::runtime_error("failed to open file: " + filename);
+    }
+
+    file.seekg(0, std::ios::end);
+    auto file_size = file.tellg();
+
+    if (file_size <= 0) {
+        throw std::runtime_error("file may be empty!");
+    }
+
+    file.seekg(0, std::ios::beg);
+    auto source = std::shared_ptr<SourceBuffer>(new SourceBuffer());
+    source->_copy.resize(static_cast<std::size_t>(file_size) + 1, '\0');
+    file.read(source->_copy.data(), file_size);
+    source->_data = source->_copy.data();
+    source->_size = static_cast<std::size_t>(file_size);
+
+    return source;
+}
+
+}
+
+}
@@ -0,0 +1,121 @@
+#include "thread_pool.hpp"
+#include <utility>
+
+namespace blang {
+
+namespace tools {
+
+namespace {
+
+thread_local ThreadPool* current_pool = nullptr;
+thread_local std::size_t current_worker = 0;
+
+}
+
+ThreadPool::ThreadPool(std::size_t workers) :
+    _queued(0), _pending(0), _stop(false), _next_queue(0) {
+    if (workers == 0) {
+        workers = std::thread::hardware_concurrency();
+    }
+    if (workers == 0) {
+        workers = 1;
+    }
+
+    for (std::size_t i = 0; i < workers; i++) {
+        _queues.push_back(std::make_unique<Queue>());
+    }
+    for (std::size_t i = 0; i < workers; i++) {
+        _threads.emplace_back(&ThreadPool::run, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _task_cv.notify_all();
+    for (auto& thread : _threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::submit(Task task) {
+    std::size_t index = current_pool == this
+                        ? current_worker
+                        : _next_queue++ % _queues.size();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _queued++;
+        _pending++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_queues[index]->mutex);
+        _queues[index]->tasks.push_back(std::move(task));
+    }
+    _task_cv.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done_cv.wait(lock, [this]() { return _pending == 0; });
+}
+
+bool ThreadPool::pop(std::size_t worker, Task& task) {
+    auto& queue = *_queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(std::size_t worker, Task& task) {
+    for (std::size_t i = 1; i < _queues.size(); i++) {
+        auto& queue = *_queues[(worker + i) % _queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run(std::size_t worker) {
+    current_pool = this;
+    current_worker = worker;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _task_cv.wait(lock, [this]() { return _stop || _queued > 0; });
+            if (_queued == 0) {
+                return;
+            }
+            _queued--;
+        }
+
+        Task task;
+        // a task is reserved by the counter above, spin until it is found
+        while (!pop(worker, task) && !steal(worker, task)) {
+            std::this_thread::yield();
+        }
+        task(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _pending--;
+            if (_pending == 0) {
+                _done_cv.notify_all();
+            }
+        }
+    }
+}
+
+}
+
+}
@@ -9,12 +9,441 @@
  * 
  */
 
+#include "arena.hpp"
+#include "batch_compiler.hpp"
 #include "blang.hpp"
+#include "ident.hpp"
+#include "inst_visitor.hpp"
+#include "ir.hpp"
+#include "ir_generator.hpp"
+#include "lexer.hpp"
+#include "logger.hpp"
+#include "optimizer.hpp"
+#include "parser.hpp"
+#include "scan.hpp"
+#include "source.hpp"
+#include "syntax_checker.hpp"
+#include "type.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using blang::BatchCompiler;
+using blang::BatchJob;
 using blang::Blang;
 
-int main(int argc, char** argv) {
-    auto compiler = Blang();
-    compiler.compile("./testfile.txt");
+/**
+ * @brief Default output path of an input, extension replaced with .ll
+ *
+ * @param input
+ * @return std::string
+ */
+static std::string default_output(const std::string& input) {
+    auto slash = input.find_last_of('/');
+    auto dot = input.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return input + ".ll";
+    }
+    return input.substr(0, dot) + ".ll";
+}
+
+/**
+ * @brief Lex a source repeatedly for at least a second
+ * 
+ * @param source 
+ * @param tokens Set to token count of source
+ * @return double Throughput in MB/s
+ */
+static double time_lexer(std::shared_ptr<blang::tools::SourceBuffer> source, std::size_t& tokens) {
+    using clock = std::chrono::steady_clock;
+    auto logger = std::make_shared<blang::Logger>();
+    auto idents = std::make_shared<blang::entities::IdentTable>();
+    auto lexer = blang::frontend::Lexer(logger, idents);
+
+    std::size_t rounds = 0;
+    double elapsed = 0;
+    auto start = clock::now();
+    while (elapsed < 1.0 || rounds < 3) {
+        logger->clear();
+        idents->clear();
+        tokens = lexer.lexTokens(source)->size();
+        rounds++;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    return static_cast<double>(source->size()) * rounds / elapsed / 1e6;
+}
+
+/**
+ * @brief Lexer microbenchmark, report throughput of every input
+ * under every scan level supported by the cpu
+ * 
+ * @param jobs 
+ * @param load_mode 
+ * @return int 
+ */
+static int bench_lexer(const std::vector<BatchJob>& jobs, blang::tools::LoadMode load_mode) {
+    namespace scan = blang::frontend::scan;
+    auto best = scan::detect();
+    for (auto& job : jobs) {
+        auto source = blang::tools::SourceBuffer::load(job.input, load_mode);
+        for (int level = scan::SCAN_SCALAR; level <= best; level++) {
+            scan::select(static_cast<scan::ScanLevel>(level));
+            std::size_t tokens = 0;
+            auto mb = time_lexer(source, tokens);
+            std::cout << job.input << " [" << scan::name(scan::level()) << "]: "
+                      << source->size() << " bytes, " << tokens << " tokens, "
+                      << mb << " MB/s\n";
+        }
+    }
+    scan::select(best);
+
     return 0;
 }
+
+/**
+ * @brief Parser benchmark, lex each input once and report time of parsing
+ * the token stream under every trace level and size of the ast built,
+ * repeated for at least a second
+ * 
+ * @param jobs 
+ * @param load_mode 
+ * @param memoize Enable packrat memo and report its hits and misses
+ * @return int 
+ */
+static int bench_parser(const std::vector<BatchJob>& jobs, blang::tools::LoadMode load_mode, bool memoize) {
+    using clock = std::chrono::steady_clock;
+    static const char* level_names[] = {"none", "compact", "full"};
+    for (auto& job : jobs) {
+        auto source = blang::tools::SourceBuffer::load(job.input, load_mode);
+        auto logger = std::make_shared<blang::Logger>();
+        auto lexer = blang::frontend::Lexer(logger, std::make_shared<blang::entities::IdentTable>());
+        auto arena = std::make_shared<blang::tools::Arena>();
+        auto parser = blang::frontend::Parser(logger, arena);
+        auto types = blang::entities::TypeContext();
+        auto type_scope = blang::entities::TypeContext::Scope(types);
+        auto tokens = lexer.lexTokens(source);
+        parser.setMemoize(memoize);
+
+        for (int level = blang::frontend::TRACE_NONE; level <= blang::frontend::TRACE_FULL; level++) {
+            parser.setTraceLevel(static_cast<blang::frontend::TraceLevel>(level));
+            std::size_t rounds = 0;
+            double elapsed = 0;
+            auto start = clock::now();
+            while (elapsed < 1.0 || rounds < 3) {
+                logger->clear();
+                arena->reset();
+                parser.parse(tokens);
+                rounds++;
+                elapsed = std::chrono::duration<double>(clock::now() - start).count();
+            }
+
+            std::cout << job.input << " [trace " << level_names[level] << "]: " << tokens->size() << " tokens, "
+                      << elapsed * 1e3 / rounds << " ms/parse, "
+                      << static_cast<double>(tokens->size()) * rounds / elapsed / 1e6 << " Mtokens/s, "
+                      << arena->allocated() / 1024 << " KB ast";
+            if (memoize) {
+                auto stats = parser.memoStats();
+                std::cout << ", memo " << stats.hits << " hits " << stats.misses << " misses";
+            }
+            std::cout << "\n";
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Semantic check benchmark, parse each input once and report time
+ * of checking the ast and nodes visited per check, repeated for at least a second
+ * 
+ * @param jobs 
+ * @param load_mode 
+ * @return int 
+ */
+static int bench_checker(const std::vector<BatchJob>& jobs, blang::tools::LoadMode load_mode) {
+    using clock = std::chrono::steady_clock;
+    for (auto& job : jobs) {
+        auto source = blang::tools::SourceBuffer::load(job.input, load_mode);
+        auto logger = std::make_shared<blang::Logger>();
+        auto lexer = blang::frontend::Lexer(logger, std::make_shared<blang::entities::IdentTable>());
+        auto parser = blang::frontend::Parser(logger, std::make_shared<blang::tools::Arena>());
+        auto checker = blang::frontend::SyntaxChecker(logger, std::make_shared<blang::tools::Arena>());
+        auto types = blang::entities::TypeContext();
+        auto type_scope = blang::entities::TypeContext::Scope(types);
+        parser.setTraceLevel(blang::frontend::TRACE_NONE);
+        auto comp_unit = parser.parse(lexer.lexTokens(source));
+        if (!comp_unit) {
+            std::cerr << job.input << ": parse failed\n";
+            return 1;
+        }
+
+        std::size_t rounds = 0;
+        double elapsed = 0;
+        auto start = clock::now();
+        while (elapsed < 1.0 || rounds < 3) {
+            logger->clear();
+            checker.check(comp_unit);
+            rounds++;
+            elapsed = std::chrono::duration<double>(clock::now() - start).count();
+        }
+
+        std::cout << job.input << ": " << checker.visits() << " nodes visited, "
+                  << elapsed * 1e3 / rounds << " ms/check, "
+                  << logger->count(blang::LOG_SYNTAX) << " symbols, "
+                  << logger->count(blang::LOG_ERROR) << " errors\n";
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Instructions of a module counted by kind
+ * 
+ */
+struct InstCounts {
+    std::size_t br = 0;
+    std::size_t condbr = 0;
+    std::size_t arith = 0;
+    std::size_t other = 0;
+    bool operator==(const InstCounts& rhs) const {
+        return br == rhs.br && condbr == rhs.condbr && arith == rhs.arith && other == rhs.other;
+    }
+};
+
+/**
+ * @brief Count instructions by kind with dynamic_cast, the way passes used to
+ * 
+ * @param module 
+ * @return InstCounts 
+ */
+static InstCounts count_rtti(blang::entities::IrModule& module) {
+    using namespace blang::entities;
+    auto counts = InstCounts();
+    for (auto& [ident, function] : module.functions()) {
+        for (auto& block : function->blocks()) {
+            for (auto& instruct : block->instructions()) {
+                if (dynamic_cast<BrInstruct*>(instruct.get())) {
+                    counts.br++;
+                } else if (dynamic_cast<CondBrInstruct*>(instruct.get())) {
+                    counts.condbr++;
+                } else if (dynamic_cast<ArithInstruct*>(instruct.get())) {
+                    counts.arith++;
+                } else {
+                    counts.other++;
+                }
+            }
+        }
+    }
+
+    return counts;
+}
+
+/**
+ * @brief Count instructions by kind with opcode dispatch
+ * 
+ */
+class InstCounter : public blang::entities::InstVisitor<InstCounter> {
+public:
+    InstCounts counts;
+    void visitBr(blang::entities::BrInstruct& inst) { counts.br++; }
+    void visitCondBr(blang::entities::CondBrInstruct& inst) { counts.condbr++; }
+    void visitArith(blang::entities::ArithInstruct& inst) { counts.arith++; }
+    void visitInstruct(blang::entities::Instruct& inst) { counts.other++; }
+};
+
+static InstCounts count_opcode(blang::entities::IrModule& module) {
+    auto counter = InstCounter();
+    for (auto& [ident, function] : module.functions()) {
+        counter.visit(*function);
+    }
+
+    return counter.counts;
+}
+
+/**
+ * @brief IR walk benchmark, generate ir of each input once and report time
+ * of classifying every instruction with rtti and with opcode dispatch,
+ * repeated for at least a second
+ * 
+ * @param jobs 
+ * @param load_mode 
+ * @return int 
+ */
+static int bench_ir(const std::vector<BatchJob>& jobs, blang::tools::LoadMode load_mode) {
+    using clock = std::chrono::steady_clock;
+    for (auto& job : jobs) {
+        auto source = blang::tools::SourceBuffer::load(job.input, load_mode);
+        auto logger = std::make_shared<blang::Logger>();
+        auto arena = std::make_shared<blang::tools::Arena>();
+        auto lexer = blang::frontend::Lexer(logger, std::make_shared<blang::entities::IdentTable>());
+        auto parser = blang::frontend::Parser(logger, arena);
+        auto checker = blang::frontend::SyntaxChecker(logger, arena);
+        auto generator = blang::backend::IrGenerator(logger, arena);
+        auto types = blang::entities::TypeContext();
+        auto type_scope = blang::entities::TypeContext::Scope(types);
+        parser.setTraceLevel(blang::frontend::TRACE_NONE);
+        auto comp_unit = parser.parse(lexer.lexTokens(source));
+        if (!comp_unit) {
+            std::cerr << job.input << ": parse failed\n";
+            return 1;
+        }
+        auto table = checker.check(comp_unit);
+        if (logger->count(blang::LOG_ERROR) > 0) {
+            std::cerr << job.input << ": semantic errors\n";
+            return 1;
+        }
+        auto module = generator.gen(table);
+
+        auto expected = count_rtti(*module);
+        auto instructs = expected.br + expected.condbr + expected.arith + expected.other;
+        static const char* method_names[] = {"rtti", "opcode"};
+        for (int method = 0; method < 2; method++) {
+            std::size_t rounds = 0;
+            double elapsed = 0;
+            bool agree = true;
+            auto start = clock::now();
+            while (elapsed < 1.0 || rounds < 3) {
+                auto counts = method == 0 ? count_rtti(*module) : count_opcode(*module);
+                agree = agree && counts == expected;
+                rounds++;
+                elapsed = std::chrono::duration<double>(clock::now() - start).count();
+            }
+
+            std::cout << job.input << " [" << method_names[method] << "]: " << instructs << " instructions, "
+                      << elapsed * 1e3 / rounds << " ms/walk, "
+                      << static_cast<double>(instructs) * rounds / elapsed / 1e6 << " Minstructs/s"
+                      << (agree ? "" : ", counts differ") << "\n";
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Print what each optimization pass removed
+ * 
+ * @param stats 
+ */
+static void print_pass_stats(const std::vector<std::pair<std::string, blang::backend::PassStats>>& stats) {
+    for (auto& [name, removed] : stats) {
+        std::cerr << name << ": " << removed.instructs << " instructions, " << removed.blocks << " blocks removed\n";
+    }
+}
+
+static void usage(const char* name) {
+    std::cerr << "usage: " << name << " [-j workers] [--no-mmap] [--stream-errors] [-passes=pass,...] [--pass-stats] [--bench-lexer] [--bench-parser [--parser-memo]] [--bench-checker] [--bench-ir] [input [-o output]]...\n"
+              << "without inputs, compile ./testfile.txt to ./llvm_ir.txt\n"
+              << "passes:";
+    for (auto& pass : blang::backend::Optimizer::passNames()) {
+        std::cerr << " " << pass;
+    }
+    std::cerr << ", default -passes=" << blang::backend::Optimizer::DEFAULT_PIPELINE << "\n";
+}
+
+int main(int argc, char** argv) {
+    std::vector<BatchJob> jobs{};
+    std::size_t workers = 0;
+    auto load_mode = blang::tools::LOAD_MMAP;
+    int error_fd = -1;
+    bool lexer_bench = false;
+    bool parser_bench = false;
+    bool parser_memo = false;
+    bool checker_bench = false;
+    bool ir_bench = false;
+    std::string passes = blang::backend::Optimizer::DEFAULT_PIPELINE;
+    bool pass_stats = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) {
+            workers = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg.rfind("-j", 0) == 0 && arg.size() > 2) {
+            workers = std::strtoul(arg.c_str() + 2, nullptr, 10);
+        } else if (arg == "-o" && i + 1 < argc && !jobs.empty()) {
+            jobs.back().output = argv[++i];
+        } else if (arg == "--no-mmap") {
+            load_mode = blang::tools::LOAD_COPY;
+        } else if (arg.rfind("-passes=", 0) == 0) {
+            passes = arg.substr(8);
+        } else if (arg == "--pass-stats") {
+            pass_stats = true;
+        } else if (arg == "--stream-errors") {
+            error_fd = STDERR_FILENO;
+        } else if (arg == "--bench-lexer") {
+            lexer_bench = true;
+        } else if (arg == "--bench-parser") {
+            parser_bench = true;
+        } else if (arg == "--bench-checker") {
+            checker_bench = true;
+        } else if (arg == "--bench-ir") {
+            ir_bench = true;
+        } else if (arg == "--parser-memo") {
+            parser_memo = true;
+        } else if (arg == "-h" || arg == "--help") {
+            usage(argv[0]);
+            return 0;
+        } else if (arg[0] == '-') {
+            usage(argv[0]);
+            return 1;
+        } else {
+            jobs.push_back({arg, default_output(arg)});
+        }
+    }
+
+    try {
+        blang::backend::Optimizer().setPipeline(passes);
+    } catch (std::exception& err) {
+        std::cerr << err.what() << "\n";
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (lexer_bench) {
+        return bench_lexer(jobs, load_mode);
+    }
+    if (parser_bench) {
+        return bench_parser(jobs, load_mode, parser_memo);
+    }
+    if (checker_bench) {
+        return bench_checker(jobs, load_mode);
+    }
+    if (ir_bench) {
+        return bench_ir(jobs, load_mode);
+    }
+
+    if (jobs.empty()) {
+        auto compiler = Blang(load_mode, std::thread::hardware_concurrency());
+        compiler.logger()->setSink(error_fd);
+        compiler.setPasses(passes);
+        compiler.compile("./testfile.txt");
+        if (pass_stats) {
+            print_pass_stats(compiler.passStats());
+        }
+        return 0;
+    }
+
+    if (workers == 0) {
+        workers = std::thread::hardware_concurrency();
+    }
+    auto batch = BatchCompiler(std::min(std::max<std::size_t>(workers, 1), jobs.size()), load_mode, error_fd);
+    batch.setPasses(passes);
+    auto failed = batch.compile(jobs);
+    if (pass_stats) {
+        print_pass_stats(batch.passStats());
+    }
+    for (auto& job : jobs) {
+        if (!job.success) {
+            std::cerr << job.input << ": " << job.message << "\n";
+        }
+    }
+
+    return failed == 0 ? 0 : 1;
+}